@@ -0,0 +1,68 @@
+/*******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2022. Seungwoo Kang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * project home: https://github.com/perfkitpp
+ ******************************************************************************/
+
+#pragma once
+#include <algorithm>
+#include <iterator>
+
+#include "cpph/thread/thread_pool.hxx"
+
+namespace cpph {
+/**
+ * Sort policy which can be passed to bulk operations of flat_map / flat_set.
+ *
+ * Input is split into chunks as parallel_policy describes, which are stable-sorted on thread
+ *  pool and then merged pairwise. Result is identical to std::stable_sort.
+ */
+struct parallel_sorter : parallel_policy {
+    template <typename Iter_, typename Compare_>
+    void operator()(Iter_ first, Iter_ last, Compare_ const& comp) const
+    {
+        size_t n = std::distance(first, last);
+        auto num_chunks = this->num_chunks(n);
+
+        if (num_chunks <= 1) { return std::stable_sort(first, last, comp); }
+
+        auto at = [&](size_t chunk) { return first + chunk_offset(n, num_chunks, std::min(chunk, num_chunks)); };
+
+        parallel_for(*pool, num_chunks, [&](size_t i) {
+            std::stable_sort(at(i), at(i + 1), comp);
+        });
+
+        // Merge adjacent sorted runs, doubling run width each round.
+        for (size_t width = 1; width < num_chunks; width *= 2) {
+            auto num_merges = (num_chunks + 2 * width - 1) / (2 * width);
+
+            parallel_for(*pool, num_merges, [&](size_t i) {
+                auto begin = i * 2 * width;
+                if (begin + width >= num_chunks) { return; }
+
+                std::inplace_merge(at(begin), at(begin + width), at(begin + 2 * width), comp);
+            });
+        }
+    }
+};
+}  // namespace cpph
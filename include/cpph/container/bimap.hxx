@@ -24,113 +24,383 @@
  * project home: https://github.com/perfkitpp
  ******************************************************************************/
 
-//
-// Created by ki608 on 2022-03-22.
-//
-
 #pragma once
-#include <cassert>
-#include <cpph/std/map>
-#include <cpph/std/vector>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "flat_hash_map.hxx"
 
 namespace cpph {
-template <typename Key1, typename Key2, bool UniqueSecondKey>
-class bimap
+namespace _detail::bimap {
+/**
+ * Open addressing index over external array. Each slot holds position of element in the array
+ *  and low 32 bits of its hash, thus most mismatches are rejected without touching elements.
+ *
+ * Uses linear probing and backward shift deletion, thus no tombstone is left on erase.
+ */
+template <typename Alloc_>
+class hash_index
 {
    public:
-    using value_type = std::pair<Key1, Key2>;
-    using container_type = std::vector<value_type>;
-    using second_map_type = std::map<Key2, size_t, std::less<>>;
-    using first_map_type = std::map<Key1, size_t, std::less<>>;
+    struct slot_t {
+        uint32_t index;
+        uint32_t hash;
+    };
 
-    using iterator = typename container_type::iterator;
-    using const_iterator = typename container_type::const_iterator;
-    using reverse_iterator = typename container_type::reverse_iterator;
-    using const_reverse_iterator = typename container_type::const_reverse_iterator;
+    enum : uint32_t { empty = ~uint32_t{} };
 
    private:
-    container_type _data;
-    first_map_type _first;
-    second_map_type _second;
+    using slot_alloc = typename std::allocator_traits<Alloc_>::template rebind_alloc<slot_t>;
+    std::vector<slot_t, slot_alloc> _slots;
+    size_t _mask = 0;
 
    public:
-    auto begin() noexcept { return _data.begin(); }
-    auto begin() const noexcept { return _data.begin(); }
-    auto cbegin() const noexcept { return _data.begin(); }
+    explicit hash_index(Alloc_ const& alloc = {}) : _slots(slot_alloc{alloc}) {}
+
+    size_t capacity() const noexcept { return _slots.size(); }
+    size_t memory_usage() const noexcept { return _slots.capacity() * sizeof(slot_t); }
 
-    auto end() noexcept { return _data.end(); }
-    auto end() const noexcept { return _data.end(); }
-    auto cend() const noexcept { return _data.end(); }
+    void reset(size_t capacity)
+    {
+        _slots.assign(capacity, slot_t{empty, 0});
+        _mask = capacity - 1;
+    }
+
+    //! Returns slot position of element which satisfies pred(index), or capacity() if not found.
+    template <typename Pred_>
+    size_t find(size_t hash, Pred_&& pred) const noexcept
+    {
+        if (_slots.empty()) { return 0; }
+
+        for (size_t i = hash & _mask;; i = (i + 1) & _mask) {
+            auto& slot = _slots[i];
+            if (slot.index == empty) { return capacity(); }
+            if (slot.hash == uint32_t(hash) && pred(slot.index)) { return i; }
+        }
+    }
 
-    auto rbegin() noexcept { return _data.rbegin(); }
-    auto rbegin() const noexcept { return _data.rbegin(); }
+    void insert(size_t hash, size_t index) noexcept
+    {
+        size_t i = hash & _mask;
+        while (_slots[i].index != empty) { i = (i + 1) & _mask; }
+        _slots[i] = slot_t{uint32_t(index), uint32_t(hash)};
+    }
+
+    void erase_at(size_t pos) noexcept
+    {
+        // Shift following entries back, unless it moves an entry before its home slot.
+        for (size_t j = pos, k = (pos + 1) & _mask;; k = (k + 1) & _mask) {
+            if (_slots[k].index == empty) {
+                _slots[j].index = empty;
+                return;
+            }
+
+            size_t home = _slots[k].hash & _mask;
+            if (((k - home) & _mask) >= ((k - j) & _mask)) {
+                _slots[j] = _slots[k];
+                j = k;
+            }
+        }
+    }
+
+    size_t index_at(size_t pos) const noexcept { return _slots[pos].index; }
+
+    //! Replaces index stored at given slot position
+    void relink(size_t pos, size_t index) noexcept { _slots[pos].index = uint32_t(index); }
+};
+}  // namespace _detail::bimap
+
+/**
+ * Bidirectional 1:1 map, e.g. id to name translation.
+ *
+ * Pairs are stored contiguously in single vector, and each direction is indexed by open
+ *  addressing hash table of 32 bit positions into the vector. Thus an insertion costs no node
+ *  allocation, and a lookup touches single index slot and single element in common case.
+ *
+ * Erasure moves last pair into erased position, thus any insertion or erasure may invalidate
+ *  iterators, references and order of elements.
+ *
+ * Replaces former bimap<Key1, Key2, bool UniqueSecondKey>, which was backed by two std::maps,
+ *  and is not source compatible with it:
+ *  - Both keys are always unique; UniqueSecondKey parameter is gone, and template parameters
+ *    are now hashers, equality comparators and allocator.
+ *  - find_first_key() / find_second_key() are replaced by find_by_left() / find_by_right().
+ *  - insert() returns pair of iterator and bool, as std::map does, instead of end() on
+ *    conflict.
+ *  - Iterators are const only, as mutating a key in place would corrupt indices.
+ *  - assign() actually inserts given range; former one looped forever on non-empty range.
+ */
+template <typename Left_, typename Right_,
+          typename LHash_ = hasher::fast_hash<Left_>,
+          typename RHash_ = hasher::fast_hash<Right_>,
+          typename LEq_ = std::equal_to<>,
+          typename REq_ = std::equal_to<>,
+          typename Alloc_ = std::allocator<std::pair<Left_, Right_>>>
+class bimap
+{
+   public:
+    using left_type = Left_;
+    using right_type = Right_;
+    using value_type = std::pair<Left_, Right_>;
+    using allocator_type = Alloc_;
+    using container_type = std::vector<value_type, Alloc_>;
+    using const_iterator = typename container_type::const_iterator;
+    using iterator = const_iterator;
 
-    auto rend() noexcept { return _data.rend(); }
-    auto rend() const noexcept { return _data.rend(); }
+   private:
+    using index_type = _detail::bimap::hash_index<Alloc_>;
 
-    auto size() const noexcept { return _data.size(); }
-    auto empty() const noexcept { return _data.empty(); }
+    template <typename Fn_>
+    constexpr static bool is_transparent = _detail::swiss::is_transparent_v<Fn_>;
 
-    void shrink_to_fit() { _data.shrink_to_fit(); }
-    void reserve(size_t n) { _data.reserve(n); }
-    void clear() { _data.clear(), _first.clear(), _second.clear(); }
+   private:
+    container_type _data;
+    index_type _left;
+    index_type _right;
 
+   public:
     bimap() noexcept = default;
 
-    bimap(std::initializer_list<value_type> init)
+    explicit bimap(Alloc_ const& alloc) : _data(alloc), _left(alloc), _right(alloc) {}
+
+    bimap(std::initializer_list<value_type> init, Alloc_ const& alloc = {}) : bimap(alloc)
     {
         assign(init.begin(), init.end());
     }
 
-    explicit bimap(size_t nreserve) { _data.reserve(nreserve); }
+    bimap(bimap const&) = default;
+    bimap(bimap&&) noexcept = default;
+    bimap& operator=(bimap const&) = default;
+    bimap& operator=(bimap&&) noexcept = default;
 
-    iterator insert(value_type&& value)
+   public:
+    size_t size() const noexcept { return _data.size(); }
+    bool empty() const noexcept { return _data.empty(); }
+
+    auto begin() const noexcept { return _data.cbegin(); }
+    auto end() const noexcept { return _data.cend(); }
+    auto data() const noexcept { return _data.data(); }
+    auto& operator[](size_t index) const noexcept { return _data[index]; }
+
+    //! Bytes allocated by element storage and both indices
+    size_t memory_usage() const noexcept
     {
-        auto [it_key1, okay_key1]
-                = _first.try_emplace(value.first, _data.size());
-        auto [it_key2, okay_key2]
-                = _second.try_emplace(value.second, _data.size());
+        return _data.capacity() * sizeof(value_type) + _left.memory_usage() + _right.memory_usage();
+    }
 
-        if (not okay_key1) {
-            if (okay_key2) { _second.erase(it_key2); }
-            return _data.end();
+    void clear() noexcept
+    {
+        _data.clear();
+        _left.reset(_left.capacity());
+        _right.reset(_right.capacity());
+    }
+
+    void reserve(size_t n)
+    {
+        _data.reserve(n);
+        if (_capacity_for(n) > _left.capacity()) { _rehash(_capacity_for(n)); }
+    }
+
+    /**
+     * Replaces content with given range in bulk. Throws std::logic_error if any of left or
+     *  right values duplicates, in which case the map is left empty.
+     */
+    template <typename Iter_>
+    void assign(Iter_ first, Iter_ last)
+    {
+        _data.assign(first, last);
+        _left.reset(_capacity_for(_data.size()));
+        _right.reset(_capacity_for(_data.size()));
+
+        for (size_t i = 0; i < _data.size(); ++i) {
+            auto lh = _lhash(_data[i].first), rh = _rhash(_data[i].second);
+            if (_find_left(_data[i].first, lh) != _left.capacity()
+                || _find_right(_data[i].second, rh) != _right.capacity()) {
+                clear();
+                throw std::logic_error{"duplicated key found!"};
+            }
+
+            _left.insert(lh, i), _right.insert(rh, i);
         }
-        if (not okay_key2) {
-            if (okay_key1) { _first.erase(it_key1); }
-            return _data.end();
+    }
+
+    /**
+     * Inserts pair only if neither of left and right value exists. Returns position of pair
+     *  which blocked insertion, or newly inserted one.
+     */
+    std::pair<const_iterator, bool> insert(value_type value)
+    {
+        auto lh = _lhash(value.first), rh = _rhash(value.second);
+
+        if (auto pos = _find_left(value.first, lh); pos != _left.capacity()) {
+            return {_data.begin() + _left_index(pos), false};
         }
+        if (auto pos = _find_right(value.second, rh); pos != _right.capacity()) {
+            return {_data.begin() + _right_index(pos), false};
+        }
+
+        if (_capacity_for(_data.size() + 1) > _left.capacity()) {
+            _rehash(_capacity_for(std::max<size_t>(_data.size() * 2, 1)));
+        }
+
+        _data.push_back(std::move(value));
+        _left.insert(lh, _data.size() - 1);
+        _right.insert(rh, _data.size() - 1);
 
-        _data.emplace_back(std::move(value));
-        return _data.end() - 1;
+        return {_data.end() - 1, true};
+    }
+
+    template <typename L_, typename R_>
+    std::pair<const_iterator, bool> emplace(L_&& left, R_&& right)
+    {
+        return insert(value_type{std::forward<L_>(left), std::forward<R_>(right)});
     }
 
-    iterator insert(value_type const& value)
+    template <typename K_>
+    const_iterator find_by_left(K_ const& key) const noexcept
     {
-        return this->insert(value_type{value});
+        auto pos = _find_left(key, _lhash(key));
+        return pos == _left.capacity() ? _data.end() : _data.begin() + _left_index(pos);
     }
 
-    template <typename Iter>
-    void assign(Iter begin, Iter end)
+    template <typename K_>
+    const_iterator find_by_right(K_ const& key) const noexcept
     {
-        clear();
-        reserve(std::distance(begin, end));
+        auto pos = _find_right(key, _rhash(key));
+        return pos == _right.capacity() ? _data.end() : _data.begin() + _right_index(pos);
+    }
 
-        while (begin != end) {}
+    template <typename K_>
+    Right_ const* find_right(K_ const& left) const noexcept
+    {
+        auto it = find_by_left(left);
+        return it == _data.end() ? nullptr : &it->second;
     }
 
-    template <typename FirstKey>
-    auto find_first_key(FirstKey&& key) noexcept
+    template <typename K_>
+    Left_ const* find_left(K_ const& right) const noexcept
     {
-        auto iter = _first.find(std::forward<FirstKey>(key));
-        if (iter == _first.end()) { return _data.end(); }
+        auto it = find_by_right(right);
+        return it == _data.end() ? nullptr : &it->first;
+    }
+
+    template <typename K_>
+    bool contains_left(K_ const& key) const noexcept { return find_by_left(key) != _data.end(); }
 
-        return _data.begin() + iter->second;
+    template <typename K_>
+    bool contains_right(K_ const& key) const noexcept { return find_by_right(key) != _data.end(); }
+
+    template <typename K_>
+    size_t erase_left(K_ const& key) noexcept
+    {
+        auto it = find_by_left(key);
+        return it == _data.end() ? 0 : (erase(it), 1);
     }
 
-    template <typename SecondKey>
-    auto find_second_key(SecondKey&& key) noexcept
+    template <typename K_>
+    size_t erase_right(K_ const& key) noexcept
     {
-        return _second.equal_range(std::forward<SecondKey>(key));
+        auto it = find_by_right(key);
+        return it == _data.end() ? 0 : (erase(it), 1);
     }
+
+    /**
+     * Erases pair at given position, by moving last pair into it. Returns iterator to the
+     *  element which now occupies erased position.
+     */
+    const_iterator erase(const_iterator it) noexcept
+    {
+        size_t index = it - _data.begin();
+        size_t last = _data.size() - 1;
+
+        _left.erase_at(_find_left_index(index));
+        _right.erase_at(_find_right_index(index));
+
+        if (index != last) {
+            _left.relink(_find_left_index(last), index);
+            _right.relink(_find_right_index(last), index);
+            _data[index] = std::move(_data[last]);
+        }
+
+        _data.pop_back();
+        return _data.begin() + index;
+    }
+
+   private:
+    static size_t _capacity_for(size_t n) noexcept
+    {
+        // Keep load factor under 3/4
+        size_t cap = 16;
+        while (cap - cap / 4 < n) { cap <<= 1; }
+        return cap;
+    }
+
+    void _rehash(size_t capacity)
+    {
+        _left.reset(capacity);
+        _right.reset(capacity);
+
+        for (size_t i = 0; i < _data.size(); ++i) {
+            _left.insert(_lhash(_data[i].first), i);
+            _right.insert(_rhash(_data[i].second), i);
+        }
+    }
+
+    template <typename Hash_, typename K_>
+    static size_t _hash_of(K_ const& key) noexcept
+    {
+        size_t hash = Hash_{}(key);
+        if constexpr (not _detail::swiss::is_avalanching_v<Hash_>) { hash = size_t(hasher::wyhash64(hash)); }
+        return hash;
+    }
+
+    template <typename K_>
+    static size_t _lhash(K_ const& key) noexcept
+    {
+        if constexpr (is_transparent<LHash_> || std::is_same_v<K_, Left_>) {
+            return _hash_of<LHash_>(key);
+        } else {
+            return _hash_of<LHash_>(Left_(key));
+        }
+    }
+
+    template <typename K_>
+    static size_t _rhash(K_ const& key) noexcept
+    {
+        if constexpr (is_transparent<RHash_> || std::is_same_v<K_, Right_>) {
+            return _hash_of<RHash_>(key);
+        } else {
+            return _hash_of<RHash_>(Right_(key));
+        }
+    }
+
+    template <typename K_>
+    size_t _find_left(K_ const& key, size_t hash) const noexcept
+    {
+        return _left.find(hash, [&](size_t i) { return LEq_{}(_data[i].first, key); });
+    }
+
+    template <typename K_>
+    size_t _find_right(K_ const& key, size_t hash) const noexcept
+    {
+        return _right.find(hash, [&](size_t i) { return REq_{}(_data[i].second, key); });
+    }
+
+    size_t _find_left_index(size_t index) const noexcept
+    {
+        return _left.find(_lhash(_data[index].first), [&](size_t i) { return i == index; });
+    }
+
+    size_t _find_right_index(size_t index) const noexcept
+    {
+        return _right.find(_rhash(_data[index].second), [&](size_t i) { return i == index; });
+    }
+
+    size_t _left_index(size_t pos) const noexcept { return _left.index_at(pos); }
+    size_t _right_index(size_t pos) const noexcept { return _right.index_at(pos); }
 };
 }  // namespace cpph
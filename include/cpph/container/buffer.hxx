@@ -27,6 +27,7 @@
 #include <cstdlib>
 #include <type_traits>
 
+#include "cpph/memory/alloc_tracker.hxx"
 #include "cpph/utility/array_view.hxx"
 #include "cpph/utility/generic.hxx"
 
@@ -123,6 +124,17 @@ class buffer
     }
 };
 
+#if CPPH_ALLOC_TRACKING
+namespace _detail {
+//! Shared by every flex_buffer instance. Never destroyed, as static buffers may outlive it.
+inline alloc_tracker& flex_buffer_tracker()
+{
+    static auto tracker = new alloc_tracker{"flex_buffer"};
+    return *tracker;
+}
+}  // namespace _detail
+#endif
+
 /**
  * A class to prevent copying existing buffer on serializations
  */
@@ -155,6 +167,8 @@ class flex_buffer
                 _size = len;
             } else {
                 _buffer = static_cast<char*>(realloc(const_cast<char*>(_buffer), len));
+                CPPH_ALLOC_TRACK(_detail::flex_buffer_tracker().on_deallocate(_capacity),
+                                 _detail::flex_buffer_tracker().on_allocate(len));
                 _capacity = _size = len;
             }
 
@@ -162,6 +176,7 @@ class flex_buffer
         }
 
         auto buffer = static_cast<char*>(malloc(len));
+        CPPH_ALLOC_TRACK(_detail::flex_buffer_tracker().on_allocate(len));
         _capacity = _size = len;
         _buffer = buffer;
         assert(_buffer && "Memory allocation must not fail!");
@@ -215,6 +230,7 @@ class flex_buffer
     {
         if (is_owning_buffer()) {
             ::free((void*)_buffer);
+            CPPH_ALLOC_TRACK(_detail::flex_buffer_tracker().on_deallocate(_capacity));
         }
     }
 };
@@ -31,28 +31,50 @@
 #include <iterator>
 #include <memory>
 
+#include "../memory/page_allocator.hxx"
+#include "../utility/array_view.hxx"
+#include "../utility/relocatable.hxx"
+
 //
 
 namespace cpph {
+/**
+ * Tag to place circular_queue on mirrored virtual memory. See allocate_mirrored_pages().
+ */
+struct mirrored_mapping_t {
+    explicit constexpr mirrored_mapping_t() = default;
+};
+
+constexpr mirrored_mapping_t mirrored_mapping{};
+
 /**
  * 스레드에 매우 안전하지 않은 클래스입니다.
  * 별도의 스레드와 사용 시 반드시 락 필요
  *
  * TODO: rbegin(), rend() 에러 고치기
  */
-template <typename Ty_>
+template <typename Ty_, typename Alloc_ = std::allocator<Ty_>>
 class circular_queue
 {
     using chunk_t = std::array<int8_t, sizeof(Ty_)>;
+    using chunk_allocator = typename std::allocator_traits<Alloc_>::template rebind_alloc<chunk_t>;
 
    public:
     using value_type = Ty_;
+    using allocator_type = Alloc_;
 
     enum {
         is_safe_ctor = std::is_nothrow_constructible_v<value_type>,
         is_safe_dtor = std::is_nothrow_destructible_v<value_type>,
+
+        // Slots must evenly divide pages to be placed on mirrored memory
+        is_mirrorable = std::is_trivially_copyable_v<value_type>
+                        && _detail::pages::small_page_size % sizeof(value_type) == 0,
     };
 
+    using span_type = array_view<Ty_>;
+    using const_span_type = array_view<Ty_ const>;
+
    public:
     template <bool Constant_ = true, bool Reverse_ = false>
     class _iterator
@@ -132,28 +154,44 @@ class circular_queue
     using const_reverse_iterator = _iterator<true, true>;
 
    public:
-    explicit circular_queue(size_t capacity) noexcept
-            : _capacity(capacity + 1), _data(capacity ? std::make_unique<chunk_t[]>(_capacity) : nullptr) {}
+    explicit circular_queue(size_t capacity, allocator_type const& alloc = {})
+            : _alloc(alloc), _capacity(capacity + 1), _data(capacity ? _alloc.allocate(_capacity) : nullptr) {}
+
+    /**
+     * Places elements on mirrored memory, on which every readable and writable region is
+     *  contiguous. Capacity is rounded up to fill whole pages. Falls back to regular
+     *  allocation if mirroring is not available; check is_mirrored().
+     */
+    circular_queue(size_t capacity, mirrored_mapping_t, allocator_type const& alloc = {})
+            : _alloc(alloc), _capacity(capacity + 1), _mirrored(true)
+    {
+        _data = _allocate_storage(_capacity, _mirrored);
+    }
 
-    circular_queue(const circular_queue& op) noexcept(is_safe_ctor) { *this = op; }
-    circular_queue(circular_queue&& op) noexcept { *this = std::move(op); }
+    circular_queue(const circular_queue& op) noexcept(is_safe_ctor) : _alloc(op._alloc) { *this = op; }
+    circular_queue(circular_queue&& op) noexcept : _alloc(op._alloc) { *this = std::move(op); }
 
     circular_queue& operator=(circular_queue&& op) noexcept
     {
+        std::swap(_alloc, op._alloc);
         std::swap(_head, op._head);
         std::swap(_tail, op._tail);
         std::swap(_data, op._data);
         std::swap(_capacity, op._capacity);
+        std::swap(_mirrored, op._mirrored);
         return *this;
     }
 
     circular_queue& operator=(const circular_queue& op) noexcept(is_safe_ctor)
     {
+        if (this == &op) { return *this; }
+
         clear();
+        _release_storage();
         _head = 0;
         _tail = 0;
         _capacity = op._capacity;
-        _data = std::make_unique<chunk_t[]>(_capacity);
+        _data = _alloc.allocate(_capacity);
 
         std::copy(op.begin(), op.end(), std::back_inserter(*this));
         return *this;
@@ -166,24 +204,30 @@ class circular_queue
         }
 
         if (new_cap == 0) {
-            clear(), _data.reset(), _capacity = 1;
+            clear(), _release_storage(), _capacity = 1;
             return;
         }
 
-        auto n_copy = std::min(size(), new_cap);
-
-        // move available objects
-        circular_queue next{new_cap};
+        auto n_move = std::min(size(), new_cap);
+        auto next_cap = new_cap + 1;
+        auto next_mirrored = _mirrored;
+        auto next = _allocate_storage(next_cap, next_mirrored);
 
-        if (n_copy > 0) {
-            std::move(begin(), begin() + n_copy, std::back_inserter(next));
+        // relocate available objects, as up to two contiguous sequences
+        auto n_seq1 = std::min(n_move, _contiguous(_tail));
+        uninitialized_relocate_n(_ptr(_tail), n_seq1, reinterpret_cast<Ty_*>(next));
+        uninitialized_relocate_n(_ptr(0), n_move - n_seq1, reinterpret_cast<Ty_*>(next) + n_seq1);
 
-            // destroies unmoved objects
-            _tail = _jmp(_tail, n_copy);
-            clear();
-        }
+        // destroies unmoved objects
+        _tail = _jmp(_tail, n_move);
+        clear();
+        _release_storage();
 
-        *this = std::move(next);
+        _data = next;
+        _capacity = next_cap;
+        _mirrored = next_mirrored;
+        _tail = 0;
+        _head = n_move;
     }
 
     template <typename RTy_>
@@ -247,29 +291,91 @@ class circular_queue
         return r;
     }
 
+    /**
+     * Moves n elements from front to given output. Trivially copyable elements are copied as
+     *  up to two contiguous sequences, which lowers into memmove for pointer outputs. Trivially
+     *  relocatable elements are relocated into pointer outputs, after destroying destination.
+     */
     template <typename OutIt_>
-    void dequeue_n(size_t n, OutIt_ oit) noexcept(is_safe_ctor&& is_safe_dtor)
+    OutIt_ dequeue_n(size_t n, OutIt_ oit) noexcept(is_safe_ctor&& is_safe_dtor)
     {
         assert(n <= size());
 
-        if constexpr (std::is_trivially_destructible_v<Ty_> && std::is_trivially_copyable_v<Ty_>) {
-            if (_tail < _head) {
-                std::copy_n(&_at(_tail), std::min<size_t>(_head - _tail, n), oit);
-            } else {
-                auto nseq1 = std::min<size_t>(_capacity - _tail, n);
-                auto nseq2 = n - nseq1;
-                assert(nseq2 <= _head);
+        auto nseq1 = std::min(n, _contiguous(_tail));
+        auto nseq2 = n - nseq1;
 
-                for (auto it = &_at(_tail); nseq1--;) { *(oit++) = *(it++); }
-                for (auto it = &_at(0); nseq2--;) { *(oit++) = *(it++); }
-            }
+        if constexpr (std::is_trivially_copyable_v<Ty_>) {
+            oit = std::copy_n(_ptr(_tail), nseq1, oit);
+            oit = std::copy_n(_ptr(0), nseq2, oit);
+            _tail = _jmp(_tail, n);
+        } else if constexpr (is_trivially_relocatable_v<Ty_> && std::is_same_v<OutIt_, Ty_*>) {
+            // Move assignment followed by destruction of source equals destroying
+            //  destination, then relocating source onto it.
+            std::destroy_n(oit, n);
+            uninitialized_relocate_n(_ptr(_tail), nseq1, oit);
+            uninitialized_relocate_n(_ptr(0), nseq2, oit + nseq1);
+
+            _tail = _jmp(_tail, n);
+            oit += n;
+        } else {
+            oit = std::move(_ptr(_tail), _ptr(_tail) + nseq1, oit);
+            oit = std::move(_ptr(0), _ptr(0) + nseq2, oit);
+            while (n--) { _pop(); }
+        }
+
+        return oit;
+    }
+
+    /**
+     * Readable elements as up to two contiguous spans, in queue order. Second span is empty
+     *  unless elements wrap around the end of buffer, which never happens if mirrored.
+     */
+    std::pair<span_type, span_type> readable_spans() noexcept
+    {
+        auto n = size();
+        auto nseq1 = std::min(n, _contiguous(_tail));
+        return {{_ptr(_tail), nseq1}, {_ptr(0), n - nseq1}};
+    }
+
+    std::pair<const_span_type, const_span_type> readable_spans() const noexcept
+    {
+        auto [a, b] = const_cast<circular_queue*>(this)->readable_spans();
+        return {a.as_const(), b.as_const()};
+    }
+
+    /**
+     * Uninitialized free space as up to two contiguous spans. Fill them from the first span,
+     *  then publish written elements with commit_write().
+     */
+    std::pair<span_type, span_type> writable_spans() noexcept
+    {
+        static_assert(std::is_trivially_copyable_v<Ty_>, "Writing to raw storage requires trivial type");
+
+        auto n = capacity() - size();
+        auto nseq1 = std::min(n, _contiguous(_head));
+        return {{_ptr(_head), nseq1}, {_ptr(0), n - nseq1}};
+    }
+
+    void commit_write(size_t n) noexcept
+    {
+        assert(n <= capacity() - size());
+        _head = _jmp(_head, n);
+    }
+
+    //! Drops n elements from front, e.g. after consuming readable_spans().
+    void consume(size_t n) noexcept(is_safe_dtor)
+    {
+        assert(n <= size());
+
+        if constexpr (std::is_trivially_destructible_v<Ty_>) {
             _tail = _jmp(_tail, n);
         } else {
-            while (n--)
-                *oit++ = dequeue();
+            while (n--) { _pop(); }
         }
     }
 
+    bool is_mirrored() const noexcept { return _mirrored; }
+
     size_t size() const noexcept
     {
         return _head >= _tail ? _head - _tail : _head + _cap() - _tail;
@@ -333,7 +439,10 @@ class circular_queue
     }
 
     /**
-     * Append given range to buffer. Only trivial types are allowed
+     * Append given range to buffer. If there isn't enough space, oldest elements are dropped.
+     *
+     * Trivially copyable elements from random access range are copied as up to two contiguous
+     *  sequences.
      */
     template <typename Iter_>
     void enqueue_n(Iter_ begin, size_t total)
@@ -358,23 +467,44 @@ class circular_queue
         }
 
         // Copy contents to buffer
-        auto nseq1 = std::min<size_t>(total, _cap() - _head);
+        auto nseq1 = std::min(total, _contiguous(_head));
         auto nseq2 = total - nseq1;
 
-        auto head = std::exchange(_head, _jmp(_head, total));
-
-        for (auto it = &_at(head); nseq1; --nseq1)
-            *(it++) = *(begin++);
-
-        for (auto it = &_at(0); nseq2; --nseq2)
-            *(it++) = *(begin++);
+        begin = _construct_n(begin, nseq1, _ptr(_head));
+        _construct_n(begin, nseq2, _ptr(0));
+        _head = _jmp(_head, total);
     }
 
-    ~circular_queue() noexcept(is_safe_dtor) { clear(); }
+    ~circular_queue() noexcept(is_safe_dtor) { clear(), _release_storage(); }
+
+    allocator_type get_allocator() const noexcept { return allocator_type(_alloc); }
 
    private:
     size_t _cap() const noexcept { return _capacity; }
 
+    // Number of slots that can be accessed contiguously from given index
+    size_t _contiguous(size_t at) const noexcept { return _mirrored ? _cap() : _cap() - at; }
+
+    Ty_* _ptr(size_t i) const noexcept
+    {
+        return reinterpret_cast<Ty_*>(const_cast<chunk_t*>(_data)) + i;
+    }
+
+    template <typename Iter_>
+    static Iter_ _construct_n(Iter_ begin, size_t n, Ty_* out)
+    {
+        using category = typename std::iterator_traits<Iter_>::iterator_category;
+
+        if constexpr (std::is_trivially_copyable_v<Ty_>
+                      && std::is_base_of_v<std::random_access_iterator_tag, category>) {
+            std::copy_n(begin, n, out);
+            return begin + n;
+        } else {
+            for (; n; --n) { new (out++) Ty_(*begin++); }
+            return begin;
+        }
+    }
+
     size_t _reserve()
     {
         assert(not is_full());
@@ -433,9 +563,42 @@ class circular_queue
     }
 
    private:
+    // Returns storage of at least num_slots. If mirrored storage is requested, num_slots is
+    //  rounded up to fill mapping, and mirrored is cleared if it couldn't be allocated.
+    chunk_t* _allocate_storage(size_t& num_slots, bool& mirrored)
+    {
+        if constexpr (is_mirrorable) {
+            if (mirrored) {
+                auto nbytes = mirrored_mapping_size(num_slots * sizeof(Ty_));
+
+                if (auto p = allocate_mirrored_pages(nbytes)) {
+                    num_slots = nbytes / sizeof(Ty_);
+                    return static_cast<chunk_t*>(p);
+                }
+            }
+        }
+
+        mirrored = false;
+        return _alloc.allocate(num_slots);
+    }
+
+    void _release_storage() noexcept
+    {
+        if (_data && _mirrored) {
+            deallocate_mirrored_pages(_data, _capacity * sizeof(Ty_)), _data = nullptr;
+        } else if (_data) {
+            _alloc.deallocate(_data, _capacity), _data = nullptr;
+        }
+
+        _mirrored = false;
+    }
+
+   private:
+    chunk_allocator _alloc;
     size_t _capacity = {};
-    std::unique_ptr<chunk_t[]> _data;
+    chunk_t* _data = nullptr;
     size_t _head = {};
     size_t _tail = {};
+    bool _mirrored = false;
 };
 }  // namespace cpph
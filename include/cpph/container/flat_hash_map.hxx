@@ -0,0 +1,726 @@
+/*******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2022. Seungwoo Kang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * project home: https://github.com/perfkitpp
+ ******************************************************************************/
+
+
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "../utility/hasher.hxx"
+
+#if !defined(CPPH_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#    define INTERNAL_CPPH_SWISS_SSE2 1
+#    include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#    include <intrin.h>
+#endif
+
+/**
+ * Open addressing hash table, which follows design of Swiss table.
+ *
+ * Each slot has one byte of control metadata, which holds either empty/deleted mark or 7 bits of
+ *  its key's hash. Lookup probes group of 16 control bytes at once, and only compares keys of
+ *  which hash bits are matched.
+ */
+namespace cpph {
+namespace _detail::swiss {
+using ctrl_t = int8_t;
+
+enum : ctrl_t {
+    ctrl_empty = -128,
+    ctrl_deleted = -2,
+};
+
+enum : size_t { group_width = 16 };
+
+inline int countr_zero(uint32_t mask) noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return int(idx);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+inline int countl_zero16(uint32_t mask) noexcept
+{
+    int n = 0;
+    for (uint32_t bit = 1u << 15; bit && not(mask & bit); bit >>= 1) { ++n; }
+    return n;
+}
+
+/**
+ * Group of control bytes, which is matched at once.
+ */
+class group
+{
+#if defined(INTERNAL_CPPH_SWISS_SSE2)
+    __m128i ctrl_;
+
+   public:
+    explicit group(ctrl_t const* p) noexcept : ctrl_(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p))) {}
+
+    uint32_t match(ctrl_t h2) const noexcept
+    {
+        return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_)));
+    }
+
+    uint32_t match_empty() const noexcept
+    {
+        return match(ctrl_empty);
+    }
+
+    uint32_t match_empty_or_deleted() const noexcept
+    {
+        // Only empty and deleted marks are less than -1
+        return uint32_t(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl_)));
+    }
+#else
+    ctrl_t ctrl_[group_width];
+
+   public:
+    explicit group(ctrl_t const* p) noexcept { memcpy(ctrl_, p, group_width); }
+
+    uint32_t match(ctrl_t h2) const noexcept
+    {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < group_width; ++i) { mask |= uint32_t(ctrl_[i] == h2) << i; }
+        return mask;
+    }
+
+    uint32_t match_empty() const noexcept
+    {
+        return match(ctrl_empty);
+    }
+
+    uint32_t match_empty_or_deleted() const noexcept
+    {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < group_width; ++i) { mask |= uint32_t(ctrl_[i] < -1) << i; }
+        return mask;
+    }
+#endif
+};
+
+template <typename Hash_, typename = void>
+constexpr bool is_avalanching_v = false;
+
+template <typename Hash_>
+constexpr bool is_avalanching_v<Hash_, std::void_t<typename Hash_::is_avalanching>> = true;
+
+template <typename Fn_, typename = void>
+constexpr bool is_transparent_v = false;
+
+template <typename Fn_>
+constexpr bool is_transparent_v<Fn_, std::void_t<typename Fn_::is_transparent>> = true;
+
+/**
+ * Common table implementation. Policy_ defines slot type, and how to extract key from it.
+ */
+template <typename Policy_, typename Hash_, typename Eq_, typename Alloc_>
+class raw_hash_set
+{
+   public:
+    using key_type = typename Policy_::key_type;
+    using value_type = typename Policy_::slot_type;
+    using size_type = size_t;
+    using hasher = Hash_;
+    using key_equal = Eq_;
+    using allocator_type = Alloc_;
+
+   private:
+    using slot_alloc = typename std::allocator_traits<Alloc_>::template rebind_alloc<value_type>;
+    using slot_traits = std::allocator_traits<slot_alloc>;
+    using ctrl_alloc = typename std::allocator_traits<Alloc_>::template rebind_alloc<ctrl_t>;
+    using ctrl_traits = std::allocator_traits<ctrl_alloc>;
+
+   public:
+    template <bool Const_>
+    class iterator_base
+    {
+        friend class raw_hash_set;
+        template <bool>
+        friend class iterator_base;
+
+        using table_type = std::conditional_t<Const_, raw_hash_set const, raw_hash_set>;
+
+        table_type* table_ = nullptr;
+        size_t index_ = 0;
+
+        iterator_base(table_type* table, size_t index) noexcept : table_(table), index_(index) {}
+
+        void _skip_empty() noexcept
+        {
+            while (index_ < table_->capacity_ && table_->ctrl_[index_] < 0) { ++index_; }
+        }
+
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename raw_hash_set::value_type;
+        using difference_type = ptrdiff_t;
+        using reference = std::conditional_t<Const_, value_type const&, value_type&>;
+        using pointer = std::conditional_t<Const_, value_type const*, value_type*>;
+
+        iterator_base() noexcept = default;
+
+        template <bool Other_, typename = std::enable_if_t<Const_ && not Other_>>
+        iterator_base(iterator_base<Other_> const& other) noexcept
+                : table_(other.table_), index_(other.index_) {}
+
+        reference operator*() const noexcept { return table_->slots_[index_]; }
+        pointer operator->() const noexcept { return &table_->slots_[index_]; }
+
+        iterator_base& operator++() noexcept { return ++index_, _skip_empty(), *this; }
+        iterator_base operator++(int) noexcept { auto r = *this; return ++*this, r; }
+
+        template <bool Other_>
+        bool operator==(iterator_base<Other_> const& o) const noexcept { return index_ == o.index_; }
+
+        template <bool Other_>
+        bool operator!=(iterator_base<Other_> const& o) const noexcept { return index_ != o.index_; }
+    };
+
+    using iterator = iterator_base<false>;
+    using const_iterator = iterator_base<true>;
+
+   protected:
+    constexpr static bool is_transparent = is_transparent_v<Hash_> && is_transparent_v<Eq_>;
+
+    //! Enables heterogeneous lookup, only if both hasher and comparator are transparent.
+    template <typename K_>
+    using enable_if_key_t = std::enable_if_t<is_transparent
+                                             && not std::is_convertible_v<K_ const&, const_iterator>>;
+
+   private:
+    ctrl_t* ctrl_ = nullptr;
+    value_type* slots_ = nullptr;
+    size_t capacity_ = 0;  // Zero, or power of 2 which is not less than group_width
+    size_t size_ = 0;
+    size_t growth_left_ = 0;
+
+    Hash_ hash_;
+    Eq_ eq_;
+    slot_alloc alloc_;
+
+   public:
+    raw_hash_set() noexcept = default;
+
+    explicit raw_hash_set(size_t bucket_count, Hash_ const& hash = {}, Eq_ const& eq = {}, Alloc_ const& alloc = {})
+            : hash_(hash), eq_(eq), alloc_(alloc)
+    {
+        reserve(bucket_count);
+    }
+
+    raw_hash_set(raw_hash_set const& other)
+            : hash_(other.hash_), eq_(other.eq_),
+              alloc_(slot_traits::select_on_container_copy_construction(other.alloc_))
+    {
+        reserve(other.size());
+        for (auto& value : other) { _insert_unique(other._hash_of(Policy_::key(value)), value); }
+    }
+
+    raw_hash_set(raw_hash_set&& other) noexcept
+            : hash_(std::move(other.hash_)), eq_(std::move(other.eq_)), alloc_(std::move(other.alloc_))
+    {
+        _steal(other);
+    }
+
+    raw_hash_set& operator=(raw_hash_set const& other)
+    {
+        if (this != &other) { raw_hash_set{other}.swap(*this); }
+        return *this;
+    }
+
+    raw_hash_set& operator=(raw_hash_set&& other) noexcept
+    {
+        if (this != &other) {
+            _destroy();
+            hash_ = std::move(other.hash_), eq_ = std::move(other.eq_), alloc_ = std::move(other.alloc_);
+            _steal(other);
+        }
+        return *this;
+    }
+
+    ~raw_hash_set() noexcept { _destroy(); }
+
+   public:
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    size_t capacity() const noexcept { return capacity_; }
+    float load_factor() const noexcept { return capacity_ ? float(size_) / capacity_ : 0.f; }
+
+    iterator begin() noexcept { return _begin<iterator>(this); }
+    iterator end() noexcept { return {this, capacity_}; }
+    const_iterator begin() const noexcept { return _begin<const_iterator>(this); }
+    const_iterator end() const noexcept { return {this, capacity_}; }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    hasher hash_function() const { return hash_; }
+    key_equal key_eq() const { return eq_; }
+
+    void clear() noexcept
+    {
+        if (size_ == 0) { return; }
+
+        for (size_t i = 0; i < capacity_; ++i)
+            if (ctrl_[i] >= 0) { slot_traits::destroy(alloc_, slots_ + i); }
+
+        std::fill_n(ctrl_, capacity_ + group_width, ctrl_t(ctrl_empty));
+        size_ = 0;
+        growth_left_ = _max_load(capacity_);
+    }
+
+    //! Make room for n elements without rehashing
+    void reserve(size_t n)
+    {
+        if (n <= size_ + growth_left_) { return; }
+
+        size_t cap = group_width;
+        while (_max_load(cap) < n) { cap <<= 1; }
+        _resize(cap);
+    }
+
+    //! Rebuild table with capacity of at least n, which also clears out tombstones.
+    void rehash(size_t n)
+    {
+        size_t cap = group_width;
+        while (cap < n || _max_load(cap) < size_) { cap <<= 1; }
+        _resize(cap);
+    }
+
+    void swap(raw_hash_set& other) noexcept
+    {
+        using std::swap;
+        swap(ctrl_, other.ctrl_), swap(slots_, other.slots_);
+        swap(capacity_, other.capacity_), swap(size_, other.size_), swap(growth_left_, other.growth_left_);
+        swap(hash_, other.hash_), swap(eq_, other.eq_), swap(alloc_, other.alloc_);
+    }
+
+   public:
+    iterator find(key_type const& key) noexcept { return {this, _find(key, _hash_of(key))}; }
+    const_iterator find(key_type const& key) const noexcept { return {this, _find(key, _hash_of(key))}; }
+    bool contains(key_type const& key) const noexcept { return _find(key, _hash_of(key)) != capacity_; }
+    size_t count(key_type const& key) const noexcept { return contains(key); }
+
+    template <typename K_, typename = enable_if_key_t<K_>>
+    iterator find(K_ const& key) noexcept
+    {
+        return {this, _find(key, _hash_of(key))};
+    }
+
+    template <typename K_, typename = enable_if_key_t<K_>>
+    const_iterator find(K_ const& key) const noexcept
+    {
+        return {this, _find(key, _hash_of(key))};
+    }
+
+    template <typename K_, typename = enable_if_key_t<K_>>
+    bool contains(K_ const& key) const noexcept
+    {
+        return _find(key, _hash_of(key)) != capacity_;
+    }
+
+    template <typename K_, typename = enable_if_key_t<K_>>
+    size_t count(K_ const& key) const noexcept
+    {
+        return contains(key);
+    }
+
+    iterator erase(const_iterator iter) noexcept
+    {
+        _erase_at(iter.index_);
+        iterator r{this, iter.index_};
+        r._skip_empty();
+        return r;
+    }
+
+    iterator erase(iterator iter) noexcept { return erase(const_iterator{iter}); }
+    size_t erase(key_type const& key) noexcept { return _erase(key); }
+
+    template <typename K_, typename = enable_if_key_t<K_>>
+    size_t erase(K_ const& key) noexcept
+    {
+        return _erase(key);
+    }
+
+    template <typename Pred_>
+    size_t erase_if(Pred_&& pred)
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < capacity_; ++i)
+            if (ctrl_[i] >= 0 && pred(slots_[i])) { _erase_at(i), ++n; }
+
+        return n;
+    }
+
+   protected:
+    /**
+     * Find slot of key, or construct new one with args if it doesn't exist.
+     */
+    template <typename K_, typename... Args_>
+    std::pair<iterator, bool> _try_emplace(K_ const& key, Args_&&... args)
+    {
+        auto hash = _hash_of(key);
+        if (auto idx = _find(key, hash); idx != capacity_) { return {{this, idx}, false}; }
+
+        auto idx = _insert_unique(hash, std::forward<Args_>(args)...);
+        return {{this, idx}, true};
+    }
+
+    value_type* _slot(iterator const& iter) const noexcept { return slots_ + iter.index_; }
+
+   private:
+    template <typename It_, typename Self_>
+    static It_ _begin(Self_* self) noexcept
+    {
+        It_ r{self, 0};
+        if (self->capacity_) { r._skip_empty(); }
+        return r;
+    }
+
+    static size_t _max_load(size_t cap) noexcept { return cap - cap / 8; }
+
+    template <typename K_>
+    size_t _erase(K_ const& key) noexcept
+    {
+        auto idx = _find(key, _hash_of(key));
+        if (idx == capacity_) { return 0; }
+
+        _erase_at(idx);
+        return 1;
+    }
+
+    template <typename K_>
+    size_t _hash_of(K_ const& key) const noexcept
+    {
+        size_t hash = hash_(key);
+        if constexpr (not is_avalanching_v<Hash_>) { hash = size_t(hasher::wyhash64(hash)); }
+        return hash;
+    }
+
+    static ctrl_t _h2(size_t hash) noexcept { return ctrl_t(hash & 0x7f); }
+    static size_t _h1(size_t hash) noexcept { return hash >> 7; }
+
+    template <typename K_>
+    size_t _find(K_ const& key, size_t hash) const noexcept
+    {
+        if (capacity_ == 0) { return capacity_; }
+
+        auto const mask = capacity_ - 1;
+        auto const h2 = _h2(hash);
+
+        for (size_t pos = _h1(hash) & mask, step = 0;;) {
+            group g{ctrl_ + pos};
+
+            for (auto bits = g.match(h2); bits; bits &= bits - 1) {
+                auto idx = (pos + countr_zero(bits)) & mask;
+                if (eq_(Policy_::key(slots_[idx]), key)) { return idx; }
+            }
+
+            if (g.match_empty()) { return capacity_; }
+
+            step += group_width;
+            pos = (pos + step) & mask;
+        }
+    }
+
+    size_t _find_non_full(size_t hash) const noexcept
+    {
+        auto const mask = capacity_ - 1;
+
+        for (size_t pos = _h1(hash) & mask, step = 0;;) {
+            if (auto bits = group{ctrl_ + pos}.match_empty_or_deleted())
+                return (pos + countr_zero(bits)) & mask;
+
+            step += group_width;
+            pos = (pos + step) & mask;
+        }
+    }
+
+    void _set_ctrl(size_t idx, ctrl_t value) noexcept
+    {
+        ctrl_[idx] = value;
+
+        // First group is mirrored after end, thus group load never wraps around.
+        if (idx < group_width) { ctrl_[capacity_ + idx] = value; }
+    }
+
+    template <typename... Args_>
+    size_t _insert_unique(size_t hash, Args_&&... args)
+    {
+        if (capacity_ == 0) { _resize(group_width); }
+
+        auto idx = _find_non_full(hash);
+        if (growth_left_ == 0 && ctrl_[idx] != ctrl_deleted) {
+            // Rehash in same size if most of used slots are tombstones
+            _resize(size_ * 2 < _max_load(capacity_) ? capacity_ : capacity_ * 2);
+            idx = _find_non_full(hash);
+        }
+
+        slot_traits::construct(alloc_, slots_ + idx, std::forward<Args_>(args)...);
+        growth_left_ -= (ctrl_[idx] == ctrl_empty);
+        _set_ctrl(idx, _h2(hash));
+        ++size_;
+
+        return idx;
+    }
+
+    void _erase_at(size_t idx) noexcept
+    {
+        slot_traits::destroy(alloc_, slots_ + idx);
+        --size_;
+
+        // If no probe sequence ever passed through this slot as full group, it can be marked
+        //  empty instead of tombstone.
+        auto const mask = capacity_ - 1;
+        auto empty_after = group{ctrl_ + idx}.match_empty();
+        auto empty_before = group{ctrl_ + ((idx - group_width) & mask)}.match_empty();
+
+        bool was_never_full = empty_before && empty_after
+                              && countr_zero(empty_after) + countl_zero16(empty_before) < int(group_width);
+
+        _set_ctrl(idx, was_never_full ? ctrl_t(ctrl_empty) : ctrl_t(ctrl_deleted));
+        growth_left_ += was_never_full;
+    }
+
+    void _resize(size_t new_capacity)
+    {
+        auto old_ctrl = ctrl_;
+        auto old_slots = slots_;
+        auto old_capacity = capacity_;
+
+        ctrl_alloc calloc{alloc_};
+        ctrl_ = ctrl_traits::allocate(calloc, new_capacity + group_width);
+        try {
+            slots_ = slot_traits::allocate(alloc_, new_capacity);
+        } catch (...) {
+            ctrl_traits::deallocate(calloc, ctrl_, new_capacity + group_width);
+            ctrl_ = old_ctrl;
+            throw;
+        }
+
+        std::fill_n(ctrl_, new_capacity + group_width, ctrl_t(ctrl_empty));
+        capacity_ = new_capacity;
+        growth_left_ = _max_load(new_capacity) - size_;
+
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (old_ctrl[i] < 0) { continue; }
+
+            auto hash = _hash_of(Policy_::key(old_slots[i]));
+            auto idx = _find_non_full(hash);
+            _set_ctrl(idx, _h2(hash));
+
+            slot_traits::construct(alloc_, slots_ + idx, std::move(old_slots[i]));
+            slot_traits::destroy(alloc_, old_slots + i);
+        }
+
+        if (old_capacity) {
+            ctrl_traits::deallocate(calloc, old_ctrl, old_capacity + group_width);
+            slot_traits::deallocate(alloc_, old_slots, old_capacity);
+        }
+    }
+
+    void _destroy() noexcept
+    {
+        if (capacity_ == 0) { return; }
+        clear();
+
+        ctrl_alloc calloc{alloc_};
+        ctrl_traits::deallocate(calloc, ctrl_, capacity_ + group_width);
+        slot_traits::deallocate(alloc_, slots_, capacity_);
+
+        ctrl_ = nullptr, slots_ = nullptr;
+        capacity_ = size_ = growth_left_ = 0;
+    }
+
+    void _steal(raw_hash_set& other) noexcept
+    {
+        ctrl_ = std::exchange(other.ctrl_, nullptr);
+        slots_ = std::exchange(other.slots_, nullptr);
+        capacity_ = std::exchange(other.capacity_, 0);
+        size_ = std::exchange(other.size_, 0);
+        growth_left_ = std::exchange(other.growth_left_, 0);
+    }
+};
+
+template <typename Key_>
+struct set_policy {
+    using key_type = Key_;
+    using slot_type = Key_;
+
+    static Key_ const& key(slot_type const& slot) noexcept { return slot; }
+};
+
+template <typename Key_, typename Mapped_>
+struct map_policy {
+    using key_type = Key_;
+    using slot_type = std::pair<Key_, Mapped_>;
+
+    static Key_ const& key(slot_type const& slot) noexcept { return slot.first; }
+};
+}  // namespace _detail::swiss
+
+/**
+ * Open addressing hash set. Unlike std::unordered_set, any insertion or erasure may invalidate
+ *  iterators and references to elements.
+ */
+template <typename Key_,
+          typename Hash_ = hasher::fast_hash<Key_>,
+          typename Eq_ = std::equal_to<>,
+          typename Alloc_ = std::allocator<Key_>>
+class flat_hash_set : public _detail::swiss::raw_hash_set<_detail::swiss::set_policy<Key_>, Hash_, Eq_, Alloc_>
+{
+    using super = _detail::swiss::raw_hash_set<_detail::swiss::set_policy<Key_>, Hash_, Eq_, Alloc_>;
+
+   public:
+    using super::super;
+    using typename super::const_iterator;
+    using typename super::iterator;
+
+    flat_hash_set() noexcept = default;
+
+    flat_hash_set(std::initializer_list<Key_> init) : super(init.size())
+    {
+        for (auto& value : init) { insert(value); }
+    }
+
+   public:
+    std::pair<iterator, bool> insert(Key_ const& value) { return this->_try_emplace(value, value); }
+    std::pair<iterator, bool> insert(Key_&& value) { return this->_try_emplace(value, std::move(value)); }
+
+    template <typename... Args_>
+    std::pair<iterator, bool> emplace(Args_&&... args)
+    {
+        Key_ value(std::forward<Args_>(args)...);
+        return insert(std::move(value));
+    }
+
+    template <typename It_>
+    void insert(It_ first, It_ last)
+    {
+        for (; first != last; ++first) { insert(*first); }
+    }
+};
+
+/**
+ * Open addressing hash map. Unlike std::unordered_map, any insertion or erasure may invalidate
+ *  iterators and references to elements.
+ *
+ * As flat_map does, value_type is pair of non-const key and mapped value.
+ */
+template <typename Key_, typename Mapped_,
+          typename Hash_ = hasher::fast_hash<Key_>,
+          typename Eq_ = std::equal_to<>,
+          typename Alloc_ = std::allocator<std::pair<Key_, Mapped_>>>
+class flat_hash_map
+        : public _detail::swiss::raw_hash_set<_detail::swiss::map_policy<Key_, Mapped_>, Hash_, Eq_, Alloc_>
+{
+    using super = _detail::swiss::raw_hash_set<_detail::swiss::map_policy<Key_, Mapped_>, Hash_, Eq_, Alloc_>;
+
+   public:
+    using mapped_type = Mapped_;
+    using super::super;
+    using typename super::const_iterator;
+    using typename super::iterator;
+    using typename super::value_type;
+
+    flat_hash_map() noexcept = default;
+
+    flat_hash_map(std::initializer_list<value_type> init) : super(init.size())
+    {
+        for (auto& value : init) { insert(value); }
+    }
+
+   public:
+    template <typename K_, typename... Args_>
+    std::pair<iterator, bool> try_emplace(K_&& key, Args_&&... args)
+    {
+        if constexpr (super::is_transparent || std::is_same_v<std::decay_t<K_>, Key_>) {
+            return this->_try_emplace(
+                    key, std::piecewise_construct,
+                    std::forward_as_tuple(std::forward<K_>(key)),
+                    std::forward_as_tuple(std::forward<Args_>(args)...));
+        } else {
+            return try_emplace(Key_(std::forward<K_>(key)), std::forward<Args_>(args)...);
+        }
+    }
+
+    template <typename K_, typename M_>
+    std::pair<iterator, bool> insert_or_assign(K_&& key, M_&& value)
+    {
+        auto r = try_emplace(std::forward<K_>(key), std::forward<M_>(value));
+        if (not r.second) { r.first->second = std::forward<M_>(value); }
+        return r;
+    }
+
+    std::pair<iterator, bool> insert(value_type const& value) { return this->_try_emplace(value.first, value); }
+    std::pair<iterator, bool> insert(value_type&& value) { return this->_try_emplace(value.first, std::move(value)); }
+
+    template <typename It_>
+    void insert(It_ first, It_ last)
+    {
+        for (; first != last; ++first) { insert(*first); }
+    }
+
+    template <typename... Args_>
+    std::pair<iterator, bool> emplace(Args_&&... args)
+    {
+        value_type value(std::forward<Args_>(args)...);
+        return insert(std::move(value));
+    }
+
+    template <typename K_>
+    Mapped_& operator[](K_&& key)
+    {
+        return try_emplace(std::forward<K_>(key)).first->second;
+    }
+
+    template <typename K_>
+    Mapped_& at(K_ const& key)
+    {
+        auto iter = this->find(key);
+        if (iter == this->end()) { throw std::out_of_range{"key not exist"}; }
+        return iter->second;
+    }
+
+    template <typename K_>
+    Mapped_ const& at(K_ const& key) const
+    {
+        auto iter = this->find(key);
+        if (iter == this->end()) { throw std::out_of_range{"key not exist"}; }
+        return iter->second;
+    }
+};
+}  // namespace cpph
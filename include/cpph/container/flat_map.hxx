@@ -27,10 +27,38 @@
 #pragma once
 #include <algorithm>
 #include <cpph/std/vector>
+#include <iterator>
 #include <memory>
 #include <stdexcept>
 
 namespace cpph {
+namespace _detail::flat {
+//! Default sort policy of bulk operations. (See parallel_sorter for multithreaded one)
+struct stable_sorter {
+    template <typename Iter_, typename Compare_>
+    void operator()(Iter_ first, Iter_ last, Compare_ const& comp) const
+    {
+        std::stable_sort(first, last, comp);
+    }
+};
+
+/**
+ * Merges sorted range [mid, end) into sorted range [begin, mid), then removes duplicates.
+ *  For equivalent elements, the one which came first is kept, thus elements of [begin, mid)
+ *  always win. Returns new end of range.
+ */
+template <typename Iter_, typename Compare_>
+Iter_ merge_unique(Iter_ begin, Iter_ mid, Iter_ end, Compare_ const& comp)
+{
+    if (mid != end && begin != mid && comp(*std::prev(mid), *mid)) {
+        // Already ordered, which is common when appending larger keys.
+    } else {
+        std::inplace_merge(begin, mid, end, comp);
+    }
+
+    return std::unique(begin, end, [&](auto& a, auto& b) { return not comp(a, b); });
+}
+}  // namespace _detail::flat
 
 template <typename ValTy, typename Comparator = std::less<ValTy>,
           typename Alloc = std::allocator<ValTy>>
@@ -44,6 +72,11 @@ class flat_set
     using allocator_type = Alloc;
 
    public:
+    flat_set() = default;
+    explicit flat_set(allocator_type const& alloc) : vals_(alloc) {}
+
+    allocator_type get_allocator() const noexcept { return vals_.get_allocator(); }
+
     template <typename Keyable, typename Compare = std::less<void>>
     auto lower_bound(Keyable const& keyv, Compare const& compare = std::less<void>{})
     {
@@ -67,9 +100,9 @@ class flat_set
     {
         auto iter = std::lower_bound(vals_.begin(), vals_.end(), val, Comparator{});
         if (iter == vals_.end() || Comparator{}(*iter, val) || Comparator{}(val, *iter)) {
-            return iter;
-        } else {
             return vals_.end();
+        } else {
+            return iter;
         }
     }
 
@@ -94,15 +127,73 @@ class flat_set
         }
     }
 
+    /**
+     * Inserts every element of range at once. New elements are sorted together and merged in
+     *  single pass, which is much cheaper than inserting them one by one.
+     *
+     * Existing elements are kept on conflict. Among equivalent elements in range, the first one
+     *  is inserted.
+     */
+    template <typename Iter_, typename Sort_ = _detail::flat::stable_sorter>
+    void insert_range(Iter_ first, Iter_ last, Sort_ const& sort = {})
+    {
+        auto n_prev = vals_.size();
+        vals_.insert(vals_.end(), first, last);
+
+        auto mid = vals_.begin() + n_prev;
+        sort(mid, vals_.end(), Comparator{});
+        vals_.erase(_detail::flat::merge_unique(vals_.begin(), mid, vals_.end(), Comparator{}), vals_.end());
+    }
+
+    /**
+     * Replaces content with given unordered range. Duplicated elements are dropped, except for
+     *  the first one.
+     */
+    template <typename Iter_, typename Sort_ = _detail::flat::stable_sorter>
+    void assign_unsorted(Iter_ first, Iter_ last, Sort_ const& sort = {})
+    {
+        vals_.clear();
+        insert_range(first, last, sort);
+    }
+
+    /**
+     * Merges other set in linear time. Existing elements are kept on conflict, and other is
+     *  cleared.
+     */
+    void merge(flat_set&& other)
+    {
+        auto n_prev = vals_.size();
+        vals_.insert(vals_.end(), std::make_move_iterator(other.vals_.begin()), std::make_move_iterator(other.vals_.end()));
+        other.vals_.clear();
+
+        auto mid = vals_.begin() + n_prev;
+        vals_.erase(_detail::flat::merge_unique(vals_.begin(), mid, vals_.end(), Comparator{}), vals_.end());
+    }
+
+    /**
+     * Erases every element which satisfies predicate in single pass. Returns number of erased
+     *  elements.
+     */
+    template <typename Pred_>
+    size_t erase_if(Pred_&& pred)
+    {
+        auto it = std::remove_if(vals_.begin(), vals_.end(), std::forward<Pred_>(pred));
+        auto n = size_t(vals_.end() - it);
+        vals_.erase(it, vals_.end());
+        return n;
+    }
+
     auto size() const noexcept { return vals_.size(); }
     auto empty() const noexcept { return vals_.empty(); }
+    void clear() noexcept { vals_.clear(); }
+    void reserve(size_t n) { vals_.reserve(n); }
 
     auto begin() noexcept { return vals_.begin(); }
     auto begin() const noexcept { return vals_.begin(); }
-    auto end() noexcept { return vals_.begin(); }
-    auto end() const noexcept { return vals_.begin(); }
-    auto cbegin() const noexcept { return vals_.begin(); }
-    auto cend() const noexcept { return vals_.begin(); }
+    auto end() noexcept { return vals_.end(); }
+    auto end() const noexcept { return vals_.end(); }
+    auto cbegin() const noexcept { return vals_.cbegin(); }
+    auto cend() const noexcept { return vals_.cend(); }
 
     auto& vec() noexcept { return vals_; }
     auto& vec() const noexcept { return vals_; }
@@ -166,6 +257,12 @@ class flat_map
         return Comparator_{}(a->first, b->first);
     }
 
+   public:
+    flat_map() = default;
+    explicit flat_map(allocator_type const& alloc) : _vector(alloc) {}
+
+    allocator_type get_allocator() const noexcept { return _vector.get_allocator(); }
+
    public:
     auto size() const noexcept { return _vector.size(); }
     auto empty() const noexcept { return _vector.empty(); }
@@ -184,9 +281,9 @@ class flat_map
     auto rend() noexcept { return _vector.rend(); }
 
     auto front() noexcept { return _vector.front(); }
-    auto back() noexcept { return _vector.front(); }
+    auto back() noexcept { return _vector.back(); }
     auto front() const noexcept { return _vector.front(); }
-    auto back() const noexcept { return _vector.front(); }
+    auto back() const noexcept { return _vector.back(); }
 
     auto erase(const_iterator iter) { return _vector.erase(iter); }
     void clear() { _vector.clear(); }
@@ -291,6 +388,67 @@ class flat_map
             throw std::logic_error{"duplicated key found!"};
     }
 
+    /**
+     * Inserts every element of range at once. New elements are sorted together and merged in
+     *  single pass, which is much cheaper than calling try_emplace() repeatedly.
+     *
+     * Like try_emplace(), existing keys are kept on conflict. Among duplicated keys in range,
+     *  the first one is inserted.
+     *
+     * Pass parallel_sorter (algorithm/parallel_sort.hxx) as sort to sort large input on thread
+     *  pool.
+     */
+    template <typename Iter_, typename Sort_ = _detail::flat::stable_sorter>
+    void insert_range(Iter_ first, Iter_ last, Sort_ const& sort = {})
+    {
+        auto n_prev = _vector.size();
+        _vector.insert(_vector.end(), first, last);
+
+        auto mid = _vector.begin() + n_prev;
+        sort(mid, _vector.end(), _sort_fn);
+        _vector.erase(_detail::flat::merge_unique(_vector.begin(), mid, _vector.end(), _sort_fn), _vector.end());
+    }
+
+    /**
+     * Replaces content with given unordered range. Unlike assign(), duplicated keys are
+     *  silently dropped, except for the first one.
+     */
+    template <typename Iter_, typename Sort_ = _detail::flat::stable_sorter>
+    void assign_unsorted(Iter_ first, Iter_ last, Sort_ const& sort = {})
+    {
+        _vector.clear();
+        insert_range(first, last, sort);
+    }
+
+    /**
+     * Merges other map in linear time. Existing keys are kept on conflict, and other is
+     *  cleared.
+     */
+    void merge(flat_map&& other)
+    {
+        auto n_prev = _vector.size();
+        _vector.insert(_vector.end(),
+                       std::make_move_iterator(other._vector.begin()),
+                       std::make_move_iterator(other._vector.end()));
+        other._vector.clear();
+
+        auto mid = _vector.begin() + n_prev;
+        _vector.erase(_detail::flat::merge_unique(_vector.begin(), mid, _vector.end(), _sort_fn), _vector.end());
+    }
+
+    /**
+     * Erases every element which satisfies pred(value_type&) in single pass. Returns number of
+     *  erased elements.
+     */
+    template <typename Pred_>
+    size_t erase_if(Pred_&& pred)
+    {
+        auto it = std::remove_if(_vector.begin(), _vector.end(), std::forward<Pred_>(pred));
+        auto n = size_t(_vector.end() - it);
+        _vector.erase(it, _vector.end());
+        return n;
+    }
+
     size_t erase(key_type key)
     {
         auto iter = find(key);
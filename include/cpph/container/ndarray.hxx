@@ -25,12 +25,350 @@
  ******************************************************************************/
 
 #pragma once
+#include <algorithm>
 #include <array>
 #include <cpph/std/vector>
+#include <cstddef>
+#include <functional>
 #include <numeric>
 #include <stdexcept>
 
+#include "../helper/macros.hxx"
+
 namespace cpph {
+template <typename Ty_, size_t Dim_>
+class ndarray;
+
+namespace _detail::nd {
+/*
+ * Element-wise kernels on contiguous memory. Written as plain unit-stride loops over raw
+ *  pointers, which are vectorized by compiler.
+ */
+template <typename D, typename S, typename Fn>
+void apply_n(D* dst, S const* src, size_t n, Fn&& fn)
+{
+    CPPH_VECTORIZE_LOOP
+    for (size_t i = 0; i < n; ++i) { dst[i] = fn(dst[i], src[i]); }
+}
+
+template <typename D, typename V, typename Fn>
+void apply_scalar_n(D* dst, V value, size_t n, Fn&& fn)
+{
+    CPPH_VECTORIZE_LOOP
+    for (size_t i = 0; i < n; ++i) { dst[i] = fn(dst[i], value); }
+}
+
+template <typename D, typename S, typename Fn>
+void transform_n(D* dst, S const* src, size_t n, Fn&& fn)
+{
+    CPPH_VECTORIZE_LOOP
+    for (size_t i = 0; i < n; ++i) { dst[i] = fn(src[i]); }
+}
+
+template <typename D, typename A, typename B, typename Fn>
+void transform_n(D* dst, A const* a, B const* b, size_t n, Fn&& fn)
+{
+    CPPH_VECTORIZE_LOOP
+    for (size_t i = 0; i < n; ++i) { dst[i] = fn(a[i], b[i]); }
+}
+
+/**
+ * Reduces n elements with associative, commutative operator.
+ *
+ * Uses independent accumulators to break dependency chain, which lets floating point
+ *  reductions to be vectorized without -ffast-math.
+ */
+template <typename Acc, typename S, typename Op>
+Acc reduce_n(S const* src, size_t n, Acc init, Op&& op)
+{
+    constexpr size_t lanes = 8;
+    if (n < lanes * 2) {
+        for (size_t i = 0; i < n; ++i) { init = op(init, src[i]); }
+        return init;
+    }
+
+    Acc acc[lanes];
+    for (size_t k = 0; k < lanes; ++k) { acc[k] = src[k]; }
+
+    size_t i = lanes;
+    for (; i + lanes <= n; i += lanes) {
+        CPPH_VECTORIZE_LOOP
+        for (size_t k = 0; k < lanes; ++k) { acc[k] = op(acc[k], src[i + k]); }
+    }
+
+    for (; i < n; ++i) { init = op(init, src[i]); }
+    for (size_t k = 0; k < lanes; ++k) { init = op(init, acc[k]); }
+    return init;
+}
+
+/**
+ * Copies strided 2D block [rows, cols] into contiguous destination, of which row pitch is
+ *  'dst_pitch'. If source is not contiguous on inner axis, copies tile by tile to keep both
+ *  source and destination access in cache.
+ */
+template <typename D, typename S>
+void copy_block(D* dst, ptrdiff_t dst_pitch,
+                S const* src, ptrdiff_t src_row_stride, ptrdiff_t src_col_stride,
+                size_t rows, size_t cols)
+{
+    if (src_col_stride == 1) {
+        for (size_t r = 0; r < rows; ++r) {
+            auto s = src + r * src_row_stride;
+            auto d = dst + r * dst_pitch;
+
+            CPPH_VECTORIZE_LOOP
+            for (size_t c = 0; c < cols; ++c) { d[c] = s[c]; }
+        }
+        return;
+    }
+
+    constexpr size_t tile = 32;
+    for (size_t r0 = 0; r0 < rows; r0 += tile) {
+        auto r1 = std::min(rows, r0 + tile);
+
+        for (size_t c0 = 0; c0 < cols; c0 += tile) {
+            auto c1 = std::min(cols, c0 + tile);
+
+            for (size_t r = r0; r < r1; ++r) {
+                auto s = src + r * src_row_stride;
+                auto d = dst + r * dst_pitch;
+
+                for (size_t c = c0; c < c1; ++c) { d[c] = s[c * src_col_stride]; }
+            }
+        }
+    }
+}
+}  // namespace _detail::nd
+
+/**
+ * Non-owning, strided view of N-dimensional array.
+ *
+ * Strides are in number of elements, and may be zero or negative. Slicing and permuting
+ *  axes just create another view, without copying any element.
+ */
+template <typename Ty_, size_t Dim_>
+class ndarray_view
+{
+   public:
+    using value_type = std::remove_const_t<Ty_>;
+    using reference = Ty_&;
+    using pointer = Ty_*;
+    using size_type = size_t;
+    using dimension_type = std::array<size_type, Dim_>;
+    using stride_type = std::array<ptrdiff_t, Dim_>;
+    static constexpr size_t dimension = Dim_;
+
+   private:
+    pointer data_ = nullptr;
+    dimension_type dim_ = {};
+    stride_type strides_ = {};
+
+   private:
+    template <size_type D_, bool Check_, typename T_, typename... Args_>
+    ptrdiff_t _reduce_index(T_ idx, Args_... args) const
+    {
+        if constexpr (Check_) {
+            if (size_type(idx) >= dim_[D_]) {
+                throw std::invalid_argument("array index out of range");
+            }
+        }
+
+        if constexpr (sizeof...(Args_)) {
+            return idx * strides_[D_] + _reduce_index<D_ + 1, Check_>(args...);
+        } else {
+            return idx * strides_[D_];
+        }
+    }
+
+    template <size_type D_, typename Fn_>
+    void _for_each(pointer base, Fn_& fn) const
+    {
+        if constexpr (D_ + 1 == Dim_) {
+            auto n = dim_[D_];
+            auto stride = strides_[D_];
+
+            if (stride == 1)
+                for (size_type i = 0; i < n; ++i) { fn(base[i]); }
+            else
+                for (size_type i = 0; i < n; ++i) { fn(base[i * stride]); }
+        } else {
+            for (size_type i = 0; i < dim_[D_]; ++i) { _for_each<D_ + 1>(base + i * strides_[D_], fn); }
+        }
+    }
+
+   public:
+    ndarray_view() noexcept = default;
+    ndarray_view(pointer data, dimension_type const& dims, stride_type const& strides) noexcept
+            : data_(data), dim_(dims), strides_(strides)
+    {
+    }
+
+    template <typename Other_, typename = std::enable_if_t<std::is_convertible_v<Other_*, Ty_*>>>
+    ndarray_view(ndarray_view<Other_, Dim_> const& other) noexcept
+            : data_(other.data()), dim_(other.dims()), strides_(other.strides())
+    {
+    }
+
+   public:
+    template <typename... Idxs_,
+              typename = std::enable_if_t<
+                      sizeof...(Idxs_) == dimension
+                      && (std::is_integral_v<Idxs_> && ...)>>
+    reference operator()(Idxs_... index) const noexcept
+    {
+        return data_[_reduce_index<0, false>(index...)];
+    }
+
+    template <typename... Idxs_,
+              typename = std::enable_if_t<
+                      sizeof...(Idxs_) == dimension
+                      && (std::is_integral_v<Idxs_> && ...)>>
+    reference at(Idxs_... index) const
+    {
+        return data_[_reduce_index<0, true>(index...)];
+    }
+
+    reference operator[](dimension_type const& index) const noexcept
+    {
+        ptrdiff_t offset = 0;
+        for (size_type i = 0; i < Dim_; ++i) { offset += index[i] * strides_[i]; }
+        return data_[offset];
+    }
+
+    pointer data() const noexcept { return data_; }
+    auto const& dims() const noexcept { return dim_; }
+    auto const& strides() const noexcept { return strides_; }
+    bool empty() const noexcept { return size() == 0; }
+
+    size_type size() const noexcept
+    {
+        return std::reduce(dim_.begin(), dim_.end(), size_type(1), std::multiplies<>{});
+    }
+
+    //! Check if elements are laid out in row-major order without gap
+    bool is_contiguous() const noexcept
+    {
+        ptrdiff_t expected = 1;
+        for (size_type i = Dim_; i-- > 0;) {
+            if (dim_[i] > 1 && strides_[i] != expected) { return false; }
+            expected *= dim_[i];
+        }
+        return true;
+    }
+
+   public:
+    /**
+     * Create sub-view of range [begin, end) with given step on each axis.
+     * End index is clamped to each dimension.
+     */
+    ndarray_view slice(dimension_type const& begin,
+                       dimension_type const& end,
+                       dimension_type const& step = _unit_steps()) const
+    {
+        ndarray_view rv = *this;
+
+        for (size_type i = 0; i < Dim_; ++i) {
+            auto b = std::min(begin[i], dim_[i]);
+            auto e = std::max(b, std::min(end[i], dim_[i]));
+
+            if (step[i] == 0) { throw std::invalid_argument("slice step must not be zero"); }
+
+            rv.data_ += ptrdiff_t(b) * strides_[i];
+            rv.dim_[i] = (e - b + step[i] - 1) / step[i];
+            rv.strides_[i] = strides_[i] * ptrdiff_t(step[i]);
+        }
+
+        return rv;
+    }
+
+    //! Reorder axes. Result's i-th axis is axes[i]-th axis of this view.
+    ndarray_view permute(std::array<size_type, Dim_> const& axes) const
+    {
+        ndarray_view rv = *this;
+
+        for (size_type i = 0; i < Dim_; ++i) {
+            rv.dim_[i] = dim_.at(axes[i]);
+            rv.strides_[i] = strides_[axes[i]];
+        }
+
+        return rv;
+    }
+
+    //! Swap last two axes
+    ndarray_view transpose() const
+    {
+        static_assert(Dim_ >= 2);
+
+        std::array<size_type, Dim_> axes;
+        std::iota(axes.begin(), axes.end(), size_type(0));
+        std::swap(axes[Dim_ - 1], axes[Dim_ - 2]);
+        return permute(axes);
+    }
+
+    //! Visit every element in row-major order
+    template <typename Fn_>
+    void for_each(Fn_&& fn) const
+    {
+        if (empty()) { return; }
+        _for_each<0>(data_, fn);
+    }
+
+    template <typename Value_>
+    void fill(Value_ const& value) const
+    {
+        for_each([&](reference elem) { elem = value; });
+    }
+
+    //! Copy elements into new ndarray, in row-major order
+    ndarray<value_type, Dim_> to_ndarray() const
+    {
+        ndarray<value_type, Dim_> rv;
+        rv.reshape(dim_);
+        copy_to(rv.data());
+        return rv;
+    }
+
+    //! Copy elements into contiguous buffer, in row-major order
+    void copy_to(value_type* out) const
+    {
+        if (empty()) { return; }
+
+        if constexpr (Dim_ == 1) {
+            _detail::nd::copy_block(out, 0, data_, 0, strides_[0], 1, dim_[0]);
+        } else {
+            auto rows = dim_[Dim_ - 2], cols = dim_[Dim_ - 1];
+            auto num_blocks = size() / (rows * cols);
+
+            for (size_type i = 0; i < num_blocks; ++i) {
+                _detail::nd::copy_block(
+                        out + i * rows * cols, cols,
+                        data_ + outer_offset(i), strides_[Dim_ - 2], strides_[Dim_ - 1],
+                        rows, cols);
+            }
+        }
+    }
+
+   public:
+    //! Offset of i-th 2D block, which is indexed by axes except for last two
+    ptrdiff_t outer_offset(size_type block) const noexcept
+    {
+        ptrdiff_t offset = 0;
+        for (size_type ax = Dim_ - 2; ax-- > 0;) {
+            offset += (block % dim_[ax]) * strides_[ax];
+            block /= dim_[ax];
+        }
+        return offset;
+    }
+
+   private:
+    static constexpr dimension_type _unit_steps() noexcept
+    {
+        dimension_type rv = {};
+        for (auto& v : rv) { v = 1; }
+        return rv;
+    }
+};
+
 /**
  * N-dimensional array
  * Basically, wrapper of an vector
@@ -44,6 +382,8 @@ class ndarray
     using const_reference = typename std::vector<Ty_>::const_reference;
     using size_type = size_t;
     using dimension_type = std::array<size_type, Dim_>;
+    using view_type = ndarray_view<Ty_, Dim_>;
+    using const_view_type = ndarray_view<Ty_ const, Dim_>;
     static constexpr size_t dimension = Dim_;
     
    private:
@@ -74,6 +414,7 @@ class ndarray
     auto _apply_reshape()
     {
         data_.resize(std::reduce(dim_.begin(), dim_.end(), size_type(1), std::multiplies<>{}));
+        if constexpr (dimension == 1) { return; }
 
         auto it_dim = dim_.end() - 1;
         auto it_dim_end = dim_.begin();
@@ -186,12 +527,102 @@ class ndarray
 
     void assign(std::initializer_list<value_type> values) { assign(values.begin(), values.end()); }
 
+   public:
+    view_type view() noexcept { return {data_.data(), dim_, _strides()}; }
+    const_view_type view() const noexcept { return {data_.data(), dim_, _strides()}; }
+
+    //! Create strided sub-view. See ndarray_view::slice()
+    view_type slice(dimension_type const& begin, dimension_type const& end) { return view().slice(begin, end); }
+    const_view_type slice(dimension_type const& begin, dimension_type const& end) const { return view().slice(begin, end); }
+
+    view_type slice(dimension_type const& begin, dimension_type const& end, dimension_type const& step)
+    {
+        return view().slice(begin, end, step);
+    }
+
+    const_view_type slice(dimension_type const& begin, dimension_type const& end, dimension_type const& step) const
+    {
+        return view().slice(begin, end, step);
+    }
+
+    void fill(value_type const& value) { std::fill(data_.begin(), data_.end(), value); }
+
+   public:
+    /*
+     * Element-wise arithmetic. Shapes of operands must be identical.
+     *
+     * See ndarray_ops.hxx for parallel variants.
+     */
+    ndarray& operator+=(ndarray const& r) { return _apply(r, std::plus<>{}); }
+    ndarray& operator-=(ndarray const& r) { return _apply(r, std::minus<>{}); }
+    ndarray& operator*=(ndarray const& r) { return _apply(r, std::multiplies<>{}); }
+    ndarray& operator/=(ndarray const& r) { return _apply(r, std::divides<>{}); }
+
+    ndarray& operator+=(value_type const& r) { return _apply_scalar(r, std::plus<>{}); }
+    ndarray& operator-=(value_type const& r) { return _apply_scalar(r, std::minus<>{}); }
+    ndarray& operator*=(value_type const& r) { return _apply_scalar(r, std::multiplies<>{}); }
+    ndarray& operator/=(value_type const& r) { return _apply_scalar(r, std::divides<>{}); }
+
+    template <typename Rhs_>
+    friend ndarray operator+(ndarray l, Rhs_ const& r) { return l += r; }
+
+    template <typename Rhs_>
+    friend ndarray operator-(ndarray l, Rhs_ const& r) { return l -= r; }
+
+    template <typename Rhs_>
+    friend ndarray operator*(ndarray l, Rhs_ const& r) { return l *= r; }
+
+    template <typename Rhs_>
+    friend ndarray operator/(ndarray l, Rhs_ const& r) { return l /= r; }
+
+   public:
+    template <typename Acc_, typename Op_>
+    Acc_ reduce(Acc_ init, Op_&& op) const { return _detail::nd::reduce_n(data_.data(), data_.size(), init, op); }
+
+    value_type sum() const { return reduce(value_type{}, std::plus<>{}); }
+
+    value_type min() const
+    {
+        if (data_.empty()) { throw std::logic_error{"empty array"}; }
+        return reduce(data_[0], [](auto a, auto b) { return b < a ? b : a; });
+    }
+
+    value_type max() const
+    {
+        if (data_.empty()) { throw std::logic_error{"empty array"}; }
+        return reduce(data_[0], [](auto a, auto b) { return a < b ? b : a; });
+    }
+
     bool operator==(ndarray const& r) const noexcept { return dim_ == r.dim_ && data_ == r.data_; }
     bool operator!=(ndarray const& r) const noexcept { return !(*this == r); }
 
    private:
-    dimension_type dim_;
-    std::array<size_type, size_t(dimension - 1)> steps_;
+    typename view_type::stride_type _strides() const noexcept
+    {
+        typename view_type::stride_type rv;
+        std::copy(steps_.begin(), steps_.end(), rv.begin());
+        rv.back() = 1;
+        return rv;
+    }
+
+    template <typename Op_>
+    ndarray& _apply(ndarray const& r, Op_&& op)
+    {
+        if (dim_ != r.dim_) { throw std::invalid_argument{"array shape mismatch"}; }
+        _detail::nd::apply_n(data_.data(), r.data_.data(), data_.size(), op);
+        return *this;
+    }
+
+    template <typename Op_>
+    ndarray& _apply_scalar(value_type const& r, Op_&& op)
+    {
+        _detail::nd::apply_scalar_n(data_.data(), r, data_.size(), op);
+        return *this;
+    }
+
+   private:
+    dimension_type dim_ = {};
+    std::array<size_type, size_t(dimension - 1)> steps_ = {};
     std::vector<Ty_> data_;
 };  // namespace kangsw::inline containers
 }  // namespace cpph
\ No newline at end of file
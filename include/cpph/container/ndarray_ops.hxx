@@ -0,0 +1,187 @@
+/*******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021-2022. Seungwoo Kang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * project home: https://github.com/perfkitpp
+ ******************************************************************************/
+
+#pragma once
+#include <cpph/std/mutex>
+
+#include "../thread/thread_pool.hxx"
+#include "ndarray.hxx"
+
+/**
+ * Bulk operations on ndarray, which run on thread pool if array is large enough.
+ */
+namespace cpph::nd {
+using exec_policy = parallel_policy;
+
+namespace _detail {
+template <typename A_, typename B_, size_t Dim_>
+void assert_same_shape(ndarray<A_, Dim_> const& a, ndarray<B_, Dim_> const& b)
+{
+    if (a.dims() != b.dims()) { throw std::invalid_argument{"array shape mismatch"}; }
+}
+}  // namespace _detail
+
+/**
+ * dst[i] = fn(src[i])
+ */
+template <typename D_, typename S_, size_t Dim_, typename Fn_>
+void transform(ndarray<D_, Dim_>& dst, ndarray<S_, Dim_> const& src, Fn_&& fn, exec_policy const& exec = {})
+{
+    if (dst.dims() != src.dims()) { dst.reshape(src.dims()); }
+
+    run_chunked(exec, src.size(), [&](size_t begin, size_t end) {
+        cpph::_detail::nd::transform_n(dst.data() + begin, src.data() + begin, end - begin, fn);
+    });
+}
+
+/**
+ * dst[i] = fn(a[i], b[i])
+ */
+template <typename D_, typename A_, typename B_, size_t Dim_, typename Fn_>
+void transform(ndarray<D_, Dim_>& dst, ndarray<A_, Dim_> const& a, ndarray<B_, Dim_> const& b,
+               Fn_&& fn, exec_policy const& exec = {})
+{
+    _detail::assert_same_shape(a, b);
+    if (dst.dims() != a.dims()) { dst.reshape(a.dims()); }
+
+    run_chunked(exec, a.size(), [&](size_t begin, size_t end) {
+        cpph::_detail::nd::transform_n(dst.data() + begin, a.data() + begin, b.data() + begin, end - begin, fn);
+    });
+}
+
+template <typename D_, typename A_, typename B_, size_t Dim_>
+void add(ndarray<D_, Dim_>& dst, ndarray<A_, Dim_> const& a, ndarray<B_, Dim_> const& b, exec_policy const& exec = {})
+{
+    nd::transform(dst, a, b, std::plus<>{}, exec);
+}
+
+template <typename D_, typename A_, typename B_, size_t Dim_>
+void subtract(ndarray<D_, Dim_>& dst, ndarray<A_, Dim_> const& a, ndarray<B_, Dim_> const& b, exec_policy const& exec = {})
+{
+    nd::transform(dst, a, b, std::minus<>{}, exec);
+}
+
+template <typename D_, typename A_, typename B_, size_t Dim_>
+void multiply(ndarray<D_, Dim_>& dst, ndarray<A_, Dim_> const& a, ndarray<B_, Dim_> const& b, exec_policy const& exec = {})
+{
+    nd::transform(dst, a, b, std::multiplies<>{}, exec);
+}
+
+template <typename D_, typename A_, typename B_, size_t Dim_>
+void divide(ndarray<D_, Dim_>& dst, ndarray<A_, Dim_> const& a, ndarray<B_, Dim_> const& b, exec_policy const& exec = {})
+{
+    nd::transform(dst, a, b, std::divides<>{}, exec);
+}
+
+/**
+ * Reduce all elements with associative, commutative operator.
+ */
+template <typename Ty_, size_t Dim_, typename Acc_, typename Op_>
+Acc_ reduce(ndarray<Ty_, Dim_> const& src, Acc_ init, Op_&& op, exec_policy const& exec = {})
+{
+    std::vector<std::pair<size_t, Acc_>> partials;
+    std::mutex lock;
+
+    run_chunked(exec, src.size(), [&](size_t begin, size_t end) {
+        if (begin == end) { return; }
+
+        auto first = Acc_(src.data()[begin]);
+        auto value = cpph::_detail::nd::reduce_n(src.data() + begin + 1, end - begin - 1, first, op);
+
+        std::lock_guard _{lock};
+        partials.emplace_back(begin, value);
+    });
+
+    // Combine in order, to make result deterministic
+    std::sort(partials.begin(), partials.end(), [](auto& a, auto& b) { return a.first < b.first; });
+    for (auto& [_, value] : partials) { init = op(init, value); }
+    return init;
+}
+
+template <typename Ty_, size_t Dim_>
+Ty_ sum(ndarray<Ty_, Dim_> const& src, exec_policy const& exec = {})
+{
+    return nd::reduce(src, Ty_{}, std::plus<>{}, exec);
+}
+
+/**
+ * Copy strided view into dst, in row-major order. Non-contiguous inner axis is copied with
+ *  cache tiling.
+ */
+template <typename D_, typename S_, size_t Dim_>
+void copy(ndarray<D_, Dim_>& dst, ndarray_view<S_, Dim_> const& src, exec_policy const& exec = {})
+{
+    if (dst.dims() != src.dims()) { dst.reshape(src.dims()); }
+    if (src.empty()) { return; }
+
+    if constexpr (Dim_ == 1) {
+        run_chunked(exec, src.size(), [&](size_t begin, size_t end) {
+            cpph::_detail::nd::copy_block(
+                    dst.data() + begin, 0,
+                    src.data() + ptrdiff_t(begin) * src.strides()[0], 0, src.strides()[0],
+                    1, end - begin);
+        });
+    } else {
+        auto rows = src.dims()[Dim_ - 2], cols = src.dims()[Dim_ - 1];
+        auto num_blocks = src.size() / (rows * cols);
+
+        // Split by rows of every 2D blocks
+        run_chunked(exec, num_blocks * rows, src.size(), [&](size_t begin, size_t end) {
+            while (begin < end) {
+                auto block = begin / rows, row = begin % rows;
+                auto num_rows = std::min(rows - row, end - begin);
+
+                cpph::_detail::nd::copy_block(
+                        dst.data() + (block * rows + row) * cols, cols,
+                        src.data() + src.outer_offset(block) + ptrdiff_t(row) * src.strides()[Dim_ - 2],
+                        src.strides()[Dim_ - 2], src.strides()[Dim_ - 1],
+                        num_rows, cols);
+
+                begin += num_rows;
+            }
+        });
+    }
+}
+
+/**
+ * Reorder axes of src into dst. dst's i-th axis is axes[i]-th axis of src.
+ */
+template <typename D_, typename S_, size_t Dim_>
+void permute(ndarray<D_, Dim_>& dst, ndarray<S_, Dim_> const& src,
+             std::array<size_t, Dim_> const& axes, exec_policy const& exec = {})
+{
+    nd::copy(dst, src.view().permute(axes), exec);
+}
+
+/**
+ * Swap last two axes of src into dst
+ */
+template <typename D_, typename S_, size_t Dim_>
+void transpose(ndarray<D_, Dim_>& dst, ndarray<S_, Dim_> const& src, exec_policy const& exec = {})
+{
+    nd::copy(dst, src.view().transpose(), exec);
+}
+}  // namespace cpph::nd
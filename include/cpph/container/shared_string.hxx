@@ -24,81 +24,259 @@
  * project home: https://github.com/perfkitpp
  ******************************************************************************/
 
+
 #pragma once
-#include <memory>
+#include <atomic>
+#include <cpph/std/mutex>
 #include <cpph/std/string>
 #include <cpph/std/string_view>
+#include <cpph/std/unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <new>
 
 //
 
 namespace cpph {
+/**
+ * Immutable, cheaply copyable string.
+ *
+ * Short strings are stored inline without any allocation. Long strings are stored in single
+ *  reference counted block, which holds counter and characters together.
+ *
+ * Strings can be interned into global table. Interned strings are never freed, thus copying
+ *  them does not touch reference counter, and two interned strings are equal only when they
+ *  point to same block.
+ */
 template <typename CharTy_, typename Traits_, typename Alloc_>
 class basic_shared_string
 {
    public:
     using string_type = std::basic_string<CharTy_, Traits_, Alloc_>;
     using string_view_type = std::basic_string_view<CharTy_, Traits_>;
+    using value_type = CharTy_;
+    using const_iterator = CharTy_ const*;
+
+   private:
+    struct _block_t {
+        std::atomic_size_t refcnt;
+        size_t size;
+        size_t hash;  // Only valid for interned strings
+        bool interned;
+
+        CharTy_* chars() noexcept { return (CharTy_*)(this + 1); }
+    };
+
+    struct _intern_table_t {
+        std::mutex lock;
+        std::unordered_map<string_view_type, _block_t*> entries;
+    };
+
+    enum : uint8_t {
+        _tag_heap = 0xfe,
+        _tag_null = 0xff,
+    };
+
+   public:
+    //! Maximum length of string which is stored inline
+    static constexpr size_t inline_capacity = sizeof(void*) * 3 / sizeof(CharTy_) - 1;
+    static_assert(inline_capacity < _tag_heap);
+
+   private:
+    union {
+        _block_t* _block = nullptr;
+        CharTy_ _inline[inline_capacity + 1];  // NUL terminated
+    };
+
+    // Size of inline string, or one of _tag_heap and _tag_null
+    uint8_t _tag = _tag_null;
 
    public:
     basic_shared_string() noexcept = default;
+    ~basic_shared_string() noexcept { _release(); }
+
+    basic_shared_string(CharTy_ const* str)
+            : basic_shared_string(string_view_type{str}) {}
+
+    basic_shared_string(string_type const& str)
+            : basic_shared_string(string_view_type{str}) {}
 
-    template <size_t N_>
-    basic_shared_string(CharTy_ const (&str)[N_]) noexcept
-            : _string(std::make_shared<string_type>(str))
+    explicit basic_shared_string(string_view_type str)
     {
+        if (str.size() <= inline_capacity) {
+            Traits_::copy(_inline, str.data(), str.size());
+            _inline[str.size()] = CharTy_{};
+            _tag = uint8_t(str.size());
+        } else {
+            _block = _new_block(str);
+            _tag = _tag_heap;
+        }
     }
 
-    basic_shared_string(CharTy_ const* str) noexcept
-            : _string(std::make_shared<string_type>(str)) {}
+    basic_shared_string(basic_shared_string const& r) noexcept { _copy_from(r); }
+    basic_shared_string(basic_shared_string&& r) noexcept { _move_from(r); }
 
-    basic_shared_string(string_type str) noexcept
-            : _string(std::make_shared<string_type>(std::move(str))) {}
-
-    explicit basic_shared_string(string_view_type str) noexcept
-            : _string(std::make_shared<string_type>(str)) {}
+    basic_shared_string& operator=(basic_shared_string const& r) noexcept
+    {
+        if (this != &r) { _release(), _copy_from(r); }
+        return *this;
+    }
 
-    basic_shared_string(basic_shared_string const& r) noexcept = default;
-    basic_shared_string(basic_shared_string&& r) noexcept = default;
-    basic_shared_string& operator=(basic_shared_string const& r) noexcept = default;
-    basic_shared_string& operator=(basic_shared_string&& r) noexcept = default;
+    basic_shared_string& operator=(basic_shared_string&& r) noexcept
+    {
+        if (this != &r) { _release(), _move_from(r); }
+        return *this;
+    }
 
     template <typename Str_,
-              typename std::enable_if_t<std::is_convertible_v<Str_, string_type>> Require_ = nullptr>
-    basic_shared_string& operator=(Str_&& r) noexcept
+              typename = std::enable_if_t<
+                      not std::is_same_v<std::decay_t<Str_>, basic_shared_string>
+                      && std::is_convertible_v<Str_, string_view_type>>>
+    basic_shared_string& operator=(Str_&& r)
     {
-        if (_string && *_string == r) { return *this; }  // Do not copy if identical
-        _string = std::make_shared<string_type>(std::forward<Str_>(r));
-    };
+        return *this = basic_shared_string{string_view_type{std::forward<Str_>(r)}};
+    }
 
    public:
-    std::string const& string() const noexcept { return *_string; }
-    bool is_valid() const noexcept { return _string; }
+    /**
+     * Get interned instance of given string.
+     */
+    static basic_shared_string intern(string_view_type str)
+    {
+        auto table = _intern_table();
+        basic_shared_string rv;
+        rv._tag = _tag_heap;
+
+        std::lock_guard _{table->lock};
+        if (auto iter = table->entries.find(str); iter != table->entries.end()) {
+            rv._block = iter->second;
+        } else {
+            rv._block = _new_block(str);
+            rv._block->interned = true;
+            rv._block->hash = std::hash<string_view_type>{}(str);
+
+            table->entries.try_emplace(string_view_type{rv._block->chars(), str.size()}, rv._block);
+        }
+
+        return rv;
+    }
+
+    //! Get interned instance of this string
+    basic_shared_string interned() const
+    {
+        return is_interned() ? *this : intern(view());
+    }
+
+   public:
+    bool is_valid() const noexcept { return _tag != _tag_null; }
+    bool is_inline() const noexcept { return _tag < _tag_heap; }
+    bool is_interned() const noexcept { return _tag == _tag_heap && _block->interned; }
     operator bool() const noexcept { return is_valid(); }
 
-    operator string_type const&() const noexcept { return *_string; }
-    operator string_view_type() const noexcept { return *_string; };
-    std::string const& operator*() const noexcept { return *_string; }
-    std::string const* operator->() const noexcept { return &*_string; }
+    CharTy_ const* data() const noexcept { return _tag == _tag_heap ? _block->chars() : _inline; }
+    CharTy_ const* c_str() const noexcept { return data(); }
 
-    size_t size() const noexcept { return _string->size(); }
-    bool empty() const noexcept { return _string->empty(); }
-    char const* c_str() const noexcept { return _string->c_str(); }
+    size_t size() const noexcept
+    {
+        return _tag == _tag_heap ? _block->size : _tag == _tag_null ? 0 : _tag;
+    }
 
-    auto begin() noexcept { return _string->begin(); }
-    auto end() noexcept { return _string->end(); }
-    auto rbegin() noexcept { return _string->rbegin(); }
-    auto rend() noexcept { return _string->rend(); }
+    bool empty() const noexcept { return size() == 0; }
 
-    auto begin() const noexcept { return _string->begin(); }
-    auto end() const noexcept { return _string->end(); }
-    auto cbegin() const noexcept { return _string->cbegin(); }
-    auto cend() const noexcept { return _string->cend(); }
-    auto rbegin() const noexcept { return _string->rbegin(); }
-    auto rend() const noexcept { return _string->end(); }
+    string_view_type view() const noexcept { return {data(), size()}; }
+    string_type string() const { return string_type{view()}; }
+
+    operator string_view_type() const noexcept { return view(); }
+    explicit operator string_type() const { return string(); }
+    string_view_type operator*() const noexcept { return view(); }
+
+    auto begin() const noexcept { return data(); }
+    auto end() const noexcept { return data() + size(); }
+    auto cbegin() const noexcept { return begin(); }
+    auto cend() const noexcept { return end(); }
+    auto rbegin() const noexcept { return std::make_reverse_iterator(end()); }
+    auto rend() const noexcept { return std::make_reverse_iterator(begin()); }
+
+    size_t hash() const noexcept
+    {
+        if (is_interned())
+            return _block->hash;
+        else
+            return std::hash<string_view_type>{}(view());
+    }
+
+   public:
+    friend bool operator==(basic_shared_string const& a, basic_shared_string const& b) noexcept
+    {
+        if (a._tag == _tag_heap && b._tag == _tag_heap) {
+            if (a._block == b._block) { return true; }
+            if (a._block->interned && b._block->interned) { return false; }
+        }
+
+        return a.view() == b.view();
+    }
+
+    friend bool operator==(basic_shared_string const& a, string_view_type b) noexcept { return a.view() == b; }
+    friend bool operator==(string_view_type a, basic_shared_string const& b) noexcept { return a == b.view(); }
+    friend bool operator==(basic_shared_string const& a, CharTy_ const* b) noexcept { return a.view() == b; }
+    friend bool operator==(CharTy_ const* a, basic_shared_string const& b) noexcept { return a == b.view(); }
+
+    template <typename Rhs_>
+    friend auto operator!=(basic_shared_string const& a, Rhs_ const& b) noexcept -> decltype(a == b) { return not(a == b); }
+    friend bool operator!=(string_view_type a, basic_shared_string const& b) noexcept { return not(a == b); }
+
+    friend bool operator<(basic_shared_string const& a, basic_shared_string const& b) noexcept { return a.view() < b.view(); }
 
    private:
-    std::shared_ptr<string_type>
-            _string;
+    static _intern_table_t* _intern_table()
+    {
+        static _intern_table_t table;
+        return &table;
+    }
+
+    static _block_t* _new_block(string_view_type str)
+    {
+        auto mem = ::operator new(sizeof(_block_t) + (str.size() + 1) * sizeof(CharTy_));
+        auto block = new (mem) _block_t{};
+
+        block->refcnt.store(1, std::memory_order_relaxed);
+        block->size = str.size();
+        Traits_::copy(block->chars(), str.data(), str.size());
+        block->chars()[str.size()] = CharTy_{};
+
+        return block;
+    }
+
+    void _copy_from(basic_shared_string const& r) noexcept
+    {
+        memcpy(&_inline, &r._inline, sizeof _inline);
+        _tag = r._tag;
+
+        if (_tag == _tag_heap && not _block->interned)
+            _block->refcnt.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void _move_from(basic_shared_string& r) noexcept
+    {
+        memcpy(&_inline, &r._inline, sizeof _inline);
+        _tag = r._tag;
+
+        r._block = nullptr;
+        r._tag = _tag_null;
+    }
+
+    void _release() noexcept
+    {
+        if (_tag == _tag_heap && not _block->interned)
+            if (_block->refcnt.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                _block->~_block_t();
+                ::operator delete(_block);
+            }
+
+        _block = nullptr;
+        _tag = _tag_null;
+    }
 };
 
 template <typename CharTy_,
@@ -110,3 +288,13 @@ using shared_string = basic_shared_string<char>;
 using wshared_string = basic_shared_string<wchar_t>;
 
 }  // namespace cpph
+
+namespace std {
+template <typename CharTy_, typename Traits_, typename Alloc_>
+struct hash<cpph::basic_shared_string<CharTy_, Traits_, Alloc_>> {
+    size_t operator()(cpph::basic_shared_string<CharTy_, Traits_, Alloc_> const& s) const noexcept
+    {
+        return s.hash();
+    }
+};
+}  // namespace std
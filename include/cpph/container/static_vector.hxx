@@ -27,9 +27,13 @@
 #pragma once
 
 //
+#include <algorithm>
+#include <array>
 #include <stdexcept>
 #include <type_traits>
 
+#include "../utility/relocatable.hxx"
+
 namespace cpph {
 /**
  * Static sized vector class
@@ -59,7 +63,7 @@ class static_vector
    private:
     void _verify_iterator(const_iterator iter) const
     {
-        if (not(iter >= _ptr && iter < _ptr + N_))
+        if (not(iter >= _ptr && iter <= _ptr + N_))
             throw std::out_of_range{"invalid access"};
     }
 
@@ -98,6 +102,8 @@ class static_vector
         (*ptr).~Ty_();
     }
 
+    // Relocates [begin, end) to uninitialized memory at to_begin. Trivially relocatable
+    //  elements are moved with single memmove.
     constexpr void
     _move_range(iterator begin, iterator end, iterator to_begin) noexcept(_nt_move&& _nt_dtor)
     {
@@ -105,28 +111,16 @@ class static_vector
             return;
 
         _verify_iterator_range(begin, end);
-        auto to_end = to_begin + (end - begin);
-
-        if (begin > to_begin) {
-            while (--end, --to_end != to_begin - 1) {
-                _construct_at(to_end, std::move(*end));
-                _destruct_at(end);
-            }
-        } else {
-            _verify_space(to_begin - begin);
-
-            for (; begin != end; ++begin, ++to_begin) {
-                _construct_at(to_begin, std::move(*begin));
-                _destruct_at(begin);
-            }
-        }
+        if (to_begin > begin) { _verify_space(to_begin - begin); }
+
+        uninitialized_relocate_overlapped_n(begin, end - begin, to_begin);
     }
 
     template <bool Move_, typename It_>
     void _insert(iterator at, It_ begin, It_ end) noexcept(_nt_dtor&& _nt_ctor_move)
     {
         auto num_insert = std::distance(begin, end);
-        _move_range(at, this->end(), begin + num_insert);
+        _move_range(at, this->end(), at + num_insert);
         _size += num_insert;
         for (; begin != end; ++begin)
             if constexpr (Move_)
@@ -164,12 +158,16 @@ class static_vector
 
     auto& operator=(static_vector const& r) noexcept(_nt_ctor_copy&& _nt_move&& _nt_dtor)
     {
+        if (this == &r) { return *this; }
+
         assign(r.begin(), r.end());
         return *this;
     }
 
     auto& operator=(static_vector&& r) noexcept(_nt_ctor_move&& _nt_dtor)
     {
+        if (this == &r) { return *this; }
+
         erase(begin(), end());
         _insert<true>(begin(), r.begin(), r.end());
         return *this;
@@ -334,7 +332,7 @@ class static_vector
     }
 
    private:
-    std::array<std::byte, sizeof(Ty_) * N_> _buffer;
+    alignas(Ty_) std::array<std::byte, sizeof(Ty_) * N_> _buffer;
     Ty_* _ptr = reinterpret_cast<Ty_*>(_buffer.data());
     size_t _size = 0;
 };
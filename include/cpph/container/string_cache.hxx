@@ -1,9 +1,15 @@
 #pragma once
 #include <algorithm>
 #include <cassert>
+#include <cpph/std/optional>
 #include <cpph/std/string>
 #include <cpph/std/string_view>
 #include <cpph/std/tuple>
+#include <cpph/std/vector>
+#include <cstring>
+#include <memory>
+
+#include "flat_hash_map.hxx"
 
 namespace cpph {
 /**
@@ -106,4 +112,142 @@ class string_cache
     static size_t align_ceil_(size_t len) noexcept { return (len + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1); }
     auto node_at_(size_t pos) const noexcept -> node const* { return (node const*)(payload_.data() + pos); }
 };
+
+/**
+ * Arena of strings, which never moves stored characters. Returned views stay valid until
+ *  clear() or release() is called.
+ *
+ * Strings are packed into fixed size pages, each followed by null terminator. Strings larger
+ *  than quarter of page get dedicated allocation, thus they don't waste rest of current page.
+ *
+ * intern() returns existing entry for duplicated string, which makes it proper key store for
+ *  parsers and logs producing many repetitive strings.
+ */
+class string_arena
+{
+    using page_ptr = std::unique_ptr<char[]>;
+
+   private:
+    size_t _page_size;
+
+    vector<page_ptr> _pages;
+    size_t _page_idx = 0;  // Index of page being filled
+    char* _head = nullptr;
+    char* _end = nullptr;
+
+    vector<page_ptr> _large;
+    size_t _num_large_bytes = 0;
+
+    flat_hash_set<string_view> _index;
+    size_t _num_strings = 0;
+    size_t _num_bytes = 0;
+
+   public:
+    explicit string_arena(size_t page_size = 64 << 10) noexcept
+            : _page_size(std::max<size_t>(page_size, 64)) {}
+
+    string_arena(string_arena&&) noexcept = default;
+    string_arena& operator=(string_arena&&) noexcept = default;
+
+   public:
+    /**
+     * Copies concatenation of given strings into arena, and returns stable view to it.
+     */
+    template <class... Str>
+    string_view push_back(Str&&... strings)
+    {
+        string_view views[] = {strings...};
+        size_t len = 0;
+        for (auto& s : views) { len += s.size(); }
+
+        char* dst = _allocate(len + 1);
+        char* p = dst;
+        for (auto& s : views) { p = std::copy(s.begin(), s.end(), p); }
+        *p = '\0';
+
+        ++_num_strings, _num_bytes += len;
+        return string_view{dst, len};
+    }
+
+    /**
+     * Returns view to stored string which equals to given one. String is copied into arena
+     *  only if it was not interned yet.
+     */
+    string_view intern(string_view str)
+    {
+        if (auto it = _index.find(str); it != _index.end()) { return *it; }
+
+        auto stored = push_back(str);
+        _index.insert(stored);
+        return stored;
+    }
+
+    //! Returns interned view which equals to str, or nullopt if not exist.
+    std::optional<string_view> find(string_view str) const noexcept
+    {
+        auto it = _index.find(str);
+        return it != _index.end() ? std::make_optional(*it) : std::nullopt;
+    }
+
+    bool contains(string_view str) const noexcept { return _index.contains(str); }
+
+    /**
+     * Invalidates every stored string. Pages are kept and reused, thus this does not depend
+     *  on number of stored strings, except for dedicated allocations of large strings.
+     */
+    void clear() noexcept
+    {
+        _large.clear();
+        _num_large_bytes = 0;
+        _index.clear();
+        _num_strings = _num_bytes = 0;
+
+        _page_idx = 0;
+        _head = _end = nullptr;
+        if (not _pages.empty()) { _head = _pages[0].get(), _end = _head + _page_size; }
+    }
+
+    //! Invalidates every stored string, and frees every page.
+    void release() noexcept
+    {
+        clear();
+        _pages.clear();
+        _pages.shrink_to_fit();
+        _head = _end = nullptr;
+    }
+
+    //! Number of push_back() and newly interned strings
+    size_t size() const noexcept { return _num_strings; }
+    bool empty() const noexcept { return _num_strings == 0; }
+
+    //! Total length of stored strings, excluding null terminators
+    size_t num_bytes() const noexcept { return _num_bytes; }
+    size_t num_interned() const noexcept { return _index.size(); }
+    size_t page_size() const noexcept { return _page_size; }
+
+    //! Bytes allocated for pages and large strings, excluding intern index
+    size_t memory_usage() const noexcept { return _pages.size() * _page_size + _num_large_bytes; }
+
+   private:
+    char* _allocate(size_t n)
+    {
+        if (n > _page_size / 4) {
+            _large.emplace_back(new char[n]);
+            _num_large_bytes += n;
+            return _large.back().get();
+        }
+
+        if (size_t(_end - _head) < n) {
+            if (_head != nullptr) { ++_page_idx; }
+            if (_page_idx == _pages.size()) { _pages.emplace_back(new char[_page_size]); }
+
+            _head = _pages[_page_idx].get();
+            _end = _head + _page_size;
+        }
+
+        auto p = _head;
+        _head += n;
+        return p;
+    }
+};
 }  // namespace cpph
@@ -26,6 +26,8 @@
 
 #ifndef CPPHEADERS_HELPER_UTILITY_MACROS_HXX
 #define CPPHEADERS_HELPER_UTILITY_MACROS_HXX
+#include <type_traits>
+
 #include "spdlog_macros.hxx"
 
 #define INTERNAL_CPPH_CONCAT2(A, B) A##B
@@ -91,6 +93,44 @@
 
 #define CPPH_REQUIRE(TemplateCond) class = std::enable_if_t<(TemplateCond)>
 
+/* loop hints ***********************************************************************************/
+// Asserts following loop has no loop-carried dependency, so that compiler can vectorize it.
+#if defined(__clang__)
+#    define CPPH_VECTORIZE_LOOP _Pragma("clang loop vectorize(enable) interleave(enable)")
+#elif defined(__GNUC__)
+#    define CPPH_VECTORIZE_LOOP _Pragma("GCC ivdep")
+#elif defined(_MSC_VER)
+#    define CPPH_VECTORIZE_LOOP __pragma(loop(ivdep))
+#else
+#    define CPPH_VECTORIZE_LOOP
+#endif
+
+// Requests following loop with small constant trip count to be fully unrolled.
+#if defined(__clang__)
+#    define CPPH_UNROLL_LOOP _Pragma("unroll")
+#elif defined(__GNUC__)
+#    define CPPH_UNROLL_LOOP _Pragma("GCC unroll 16")
+#else
+#    define CPPH_UNROLL_LOOP
+#endif
+
+/* constant evaluation **************************************************************************/
+// True if evaluated in constant expression. Without compiler support, this always yields true,
+//  which selects portable constexpr code path on runtime too.
+#if defined(__cpp_lib_is_constant_evaluated)
+#    define CPPH_IS_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#elif defined(__clang__) && defined(__has_builtin)
+#    if __has_builtin(__builtin_is_constant_evaluated)
+#        define CPPH_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#    endif
+#elif (defined(__GNUC__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+#    define CPPH_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+
+#if !defined(CPPH_IS_CONSTANT_EVALUATED)
+#    define CPPH_IS_CONSTANT_EVALUATED() true
+#endif
+
 /* alloca *****************************************************************************************/
 namespace cpph::_detail {
 static inline int& _tmp_int() noexcept
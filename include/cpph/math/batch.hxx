@@ -0,0 +1,394 @@
+// MIT License
+//
+// Copyright (c) 2021-2022. Seungwoo Kang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// project home: https://github.com/perfkitpp
+
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cpph/std/vector>
+#include <limits>
+#include <stdexcept>
+
+#include "../helper/macros.hxx"
+#include "../thread/thread_pool.hxx"
+#include "geometry.hxx"
+#include "matrix.hxx"
+#include "plane.hxx"
+
+/**
+ * Structure-of-arrays point container, and kernels which run over whole batch.
+ *
+ * Each component of points is stored in its own contiguous lane, thus kernels can process
+ *  multiple points in single instruction. All kernels accept same batch as source and
+ *  destination.
+ */
+namespace cpph::math {
+template <typename T, size_t Dim>
+class point_batch
+{
+    static_assert(std::is_floating_point_v<T>);
+
+   public:
+    using value_type = vector<T, Dim>;
+    using scalar_type = T;
+    enum { dimension = Dim };
+
+   private:
+    std::array<std::vector<T>, Dim> lanes_;
+
+   public:
+    point_batch() noexcept = default;
+    explicit point_batch(size_t n) { resize(n); }
+
+    explicit point_batch(array_view<value_type const> points) { assign(points); }
+
+   public:
+    size_t size() const noexcept { return lanes_[0].size(); }
+    bool empty() const noexcept { return lanes_[0].empty(); }
+
+    void resize(size_t n)
+    {
+        for (auto& lane : lanes_) { lane.resize(n); }
+    }
+
+    void reserve(size_t n)
+    {
+        for (auto& lane : lanes_) { lane.reserve(n); }
+    }
+
+    void clear() noexcept
+    {
+        for (auto& lane : lanes_) { lane.clear(); }
+    }
+
+    void shrink_to_fit()
+    {
+        for (auto& lane : lanes_) { lane.shrink_to_fit(); }
+    }
+
+    T* lane(size_t axis) noexcept { return lanes_[axis].data(); }
+    T const* lane(size_t axis) const noexcept { return lanes_[axis].data(); }
+
+   public:
+    value_type operator[](size_t i) const noexcept
+    {
+        value_type r;
+        for (size_t d = 0; d < Dim; ++d) { r.value[d] = lanes_[d][i]; }
+        return r;
+    }
+
+    void set(size_t i, value_type const& v) noexcept
+    {
+        for (size_t d = 0; d < Dim; ++d) { lanes_[d][i] = v.value[d]; }
+    }
+
+    void push_back(value_type const& v)
+    {
+        for (size_t d = 0; d < Dim; ++d) { lanes_[d].push_back(v.value[d]); }
+    }
+
+    //! Replace contents with array of points
+    void assign(array_view<value_type const> points)
+    {
+        resize(points.size());
+        for (size_t d = 0; d < Dim; ++d) {
+            auto dst = lanes_[d].data();
+            for (size_t i = 0; i < points.size(); ++i) { dst[i] = points[i].value[d]; }
+        }
+    }
+
+    //! Copy points out as array of points
+    void copy_to(array_view<value_type> out) const
+    {
+        if (out.size() < size()) { throw std::out_of_range{"output buffer too small"}; }
+
+        for (size_t d = 0; d < Dim; ++d) {
+            auto src = lanes_[d].data();
+            for (size_t i = 0; i < size(); ++i) { out[i].value[d] = src[i]; }
+        }
+    }
+};
+
+using batch_policy = parallel_policy;
+
+namespace _detail::batch {
+template <typename T, size_t Dim>
+void prepare_output(point_batch<T, Dim>& dst, size_t n)
+{
+    if (dst.size() != n) { dst.resize(n); }
+}
+}  // namespace _detail::batch
+
+/**
+ * dst[i] = R * src[i] + t
+ */
+template <typename T, size_t Dim>
+void transform(point_batch<T, Dim>& dst, point_batch<T, Dim> const& src,
+               matrix<T, int(Dim), int(Dim)> const& R, vector<T, Dim> const& t,
+               batch_policy const& exec = {})
+{
+    using namespace _detail::batch;
+    prepare_output(dst, src.size());
+
+    run_chunked(exec, src.size(), [&](size_t begin, size_t end) {
+        T const* in[Dim];
+        T* out[Dim];
+        for (size_t d = 0; d < Dim; ++d) { in[d] = src.lane(d), out[d] = dst.lane(d); }
+
+        // Keep coefficients in locals, so that they are not reloaded after each store.
+        auto const m = R;
+        auto const o = t;
+
+        CPPH_VECTORIZE_LOOP
+        for (size_t i = begin; i < end; ++i) {
+            T p[Dim];
+
+            CPPH_UNROLL_LOOP
+            for (size_t d = 0; d < Dim; ++d) { p[d] = in[d][i]; }
+
+            CPPH_UNROLL_LOOP
+            for (size_t row = 0; row < Dim; ++row) {
+                T r = o.value[row];
+
+                CPPH_UNROLL_LOOP
+                for (size_t col = 0; col < Dim; ++col) { r += m.value[row * Dim + col] * p[col]; }
+
+                out[row][i] = r;
+            }
+        }
+    });
+}
+
+/**
+ * Affine transform by [R|t] matrix.
+ */
+template <typename T, size_t Dim>
+void transform(point_batch<T, Dim>& dst, point_batch<T, Dim> const& src,
+               matrix<T, int(Dim), int(Dim) + 1> const& Rt, batch_policy const& exec = {})
+{
+    transform(dst, src, Rt.template submatx<0, 0, Dim, Dim>(), Rt.col(Dim), exec);
+}
+
+/**
+ * Rotate points by rotation vector, then translate. (See rodrigues())
+ */
+template <typename T>
+void rotate(point_batch<T, 3>& dst, point_batch<T, 3> const& src,
+            vector<T, 3> const& rvec, vector<T, 3> const& t = {},
+            batch_policy const& exec = {})
+{
+    transform(dst, src, rodrigues(rvec), t, exec);
+}
+
+/**
+ * dst[i] = src[i] / |src[i]|
+ */
+template <typename T, size_t Dim>
+void normalize(point_batch<T, Dim>& dst, point_batch<T, Dim> const& src, batch_policy const& exec = {})
+{
+    using namespace _detail::batch;
+    prepare_output(dst, src.size());
+
+    run_chunked(exec, src.size(), [&](size_t begin, size_t end) {
+        T const* in[Dim];
+        T* out[Dim];
+        for (size_t d = 0; d < Dim; ++d) { in[d] = src.lane(d), out[d] = dst.lane(d); }
+
+        CPPH_VECTORIZE_LOOP
+        for (size_t i = begin; i < end; ++i) {
+            T p[Dim], sqr = 0;
+
+            CPPH_UNROLL_LOOP
+            for (size_t d = 0; d < Dim; ++d) { p[d] = in[d][i], sqr += p[d] * p[d]; }
+
+            auto inv = T(1) / std::sqrt(sqr);
+
+            CPPH_UNROLL_LOOP
+            for (size_t d = 0; d < Dim; ++d) { out[d][i] = p[d] * inv; }
+        }
+    });
+}
+
+/**
+ * Signed distance of each point from plane. Positive value means point is on normal side.
+ */
+template <typename T, size_t Dim>
+void distance(array_view<T> out, point_batch<T, Dim> const& src, plane<T, Dim> const& pl,
+              batch_policy const& exec = {})
+{
+    using namespace _detail::batch;
+    if (out.size() < src.size()) { throw std::out_of_range{"output buffer too small"}; }
+
+    // (P - n*d).dot(n) == P.dot(n) - d, as n is normalized.
+    run_chunked(exec, src.size(), [&](size_t begin, size_t end) {
+        T const* in[Dim];
+        T n[Dim];
+        for (size_t d = 0; d < Dim; ++d) { in[d] = src.lane(d), n[d] = pl.n().value[d]; }
+
+        auto const offset = pl.d();
+        auto dst = out.data();
+
+        CPPH_VECTORIZE_LOOP
+        for (size_t i = begin; i < end; ++i) {
+            T r = -offset;
+
+            CPPH_UNROLL_LOOP
+            for (size_t d = 0; d < Dim; ++d) { r += n[d] * in[d][i]; }
+            dst[i] = r;
+        }
+    });
+}
+
+/**
+ * Project 3D points on normalized image plane, as (x/z, y/z)
+ */
+template <typename T>
+void project(point_batch<T, 2>& dst, point_batch<T, 3> const& src, batch_policy const& exec = {})
+{
+    using namespace _detail::batch;
+    prepare_output(dst, src.size());
+
+    run_chunked(exec, src.size(), [&](size_t begin, size_t end) {
+        auto x = src.lane(0), y = src.lane(1), z = src.lane(2);
+        auto u = dst.lane(0), v = dst.lane(1);
+
+        CPPH_VECTORIZE_LOOP
+        for (size_t i = begin; i < end; ++i) {
+            auto inv_z = T(1) / z[i];
+            u[i] = x[i] * inv_z;
+            v[i] = y[i] * inv_z;
+        }
+    });
+}
+
+namespace _detail::batch {
+template <typename T, size_t N_K>
+void distort_n(T const* x_u, T const* y_u, T* x_d, T* y_d, size_t n,
+               T const (&k)[N_K], T const (&p)[2])
+{
+    CPPH_VECTORIZE_LOOP
+    for (size_t i = 0; i < n; ++i) {
+        auto x = x_u[i], y = y_u[i];
+        auto r_sq = x * x + y * y;
+
+        T radial = 1;
+        T r_sq_pow = r_sq;
+
+        CPPH_UNROLL_LOOP
+        for (size_t j = 0; j < N_K; ++j) { radial += k[j] * r_sq_pow, r_sq_pow *= r_sq; }
+
+        x_d[i] = radial * x + 2 * p[0] * x * y + p[1] * (r_sq + 2 * x * x);
+        y_d[i] = radial * y + p[0] * (r_sq + 2 * y * y) + 2 * p[1] * x * y;
+    }
+}
+}  // namespace _detail::batch
+
+/**
+ * Batch version of distort_pixel()
+ */
+template <typename T, size_t N_K>
+void distort_pixel(point_batch<T, 2>& dst, point_batch<T, 2> const& src,
+                   T const (&k)[N_K], T const (&p)[2], batch_policy const& exec = {})
+{
+    using namespace _detail::batch;
+    prepare_output(dst, src.size());
+
+    run_chunked(exec, src.size(), [&](size_t begin, size_t end) {
+        distort_n(src.lane(0) + begin, src.lane(1) + begin,
+                  dst.lane(0) + begin, dst.lane(1) + begin, end - begin, k, p);
+    });
+}
+
+/**
+ * Batch version of undistort_pixel(). Yields same result with per-point version, and points
+ *  which failed to converge into number are filled with NaN.
+ *
+ * Points are iterated in small blocks, and each iteration updates every unconverged point
+ *  of block at once.
+ *
+ * @return Number of points which failed.
+ */
+template <typename T, size_t N_K>
+size_t undistort_pixel(point_batch<T, 2>& dst, point_batch<T, 2> const& src,
+                       T const (&k)[N_K], T const (&p)[2],
+                       T const (&error_thres)[2] = {1 / 3840., 1 / 2160.},  // Default 4K
+                       size_t max_iteration = 10,
+                       batch_policy const& exec = {})
+{
+    using namespace _detail::batch;
+    prepare_output(dst, src.size());
+
+    std::atomic_size_t num_failed = 0;
+
+    run_chunked(exec, src.size(), [&](size_t begin, size_t end) {
+        enum { block_size = 64 };
+
+        T ex[block_size], ey[block_size];
+        uint8_t active[block_size];
+        size_t num_failed_local = 0;
+
+        for (; begin < end; begin += block_size) {
+            auto const n = std::min<size_t>(block_size, end - begin);
+            auto x_d = src.lane(0) + begin, y_d = src.lane(1) + begin;
+            auto x_u = dst.lane(0) + begin, y_u = dst.lane(1) + begin;
+
+            std::copy_n(x_d, n, x_u);
+            std::copy_n(y_d, n, y_u);
+            std::fill_n(active, n, uint8_t(1));
+
+            for (size_t iter = 0, num_active = n; num_active && iter <= max_iteration; ++iter) {
+                // Distort approximated points, and feed error back to active ones.
+                distort_n(x_u, y_u, ex, ey, n, k, p);
+                num_active = 0;
+
+                CPPH_VECTORIZE_LOOP
+                for (size_t i = 0; i < n; ++i) {
+                    auto err_x = ex[i] - x_d[i];
+                    auto err_y = ey[i] - y_d[i];
+
+                    x_u[i] -= active[i] ? err_x : T(0);
+                    y_u[i] -= active[i] ? err_y : T(0);
+
+                    active[i] &= uint8_t(std::abs(err_x) > error_thres[0]
+                                         || std::abs(err_y) > error_thres[1]);
+                    num_active += active[i];
+                }
+            }
+
+            for (size_t i = 0; i < n; ++i) {
+                if (std::isnan(x_u[i]) || std::isnan(y_u[i])) {
+                    x_u[i] = y_u[i] = std::numeric_limits<T>::quiet_NaN();
+                    ++num_failed_local;
+                }
+            }
+        }
+
+        num_failed += num_failed_local;
+    });
+
+    return num_failed;
+}
+}  // namespace cpph::math
@@ -0,0 +1,492 @@
+// MIT License
+//
+// Copyright (c) 2021-2022. Seungwoo Kang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// project home: https://github.com/perfkitpp
+
+
+#pragma once
+#include <algorithm>
+#include <cpph/std/mutex>
+#include <cpph/std/vector>
+#include <limits>
+
+#include "batch.hxx"
+#include "rectangle.hxx"
+
+namespace cpph::math {
+/**
+ * Axis aligned bounding box. Points on max boundary are not contained, as rectangle_ does.
+ */
+template <typename T, size_t Dim = 3>
+struct aabb {
+    using vec_type = vector<T, Dim>;
+
+    vec_type min = vec_type::all(std::numeric_limits<T>::max());
+    vec_type max = vec_type::all(std::numeric_limits<T>::lowest());
+
+   public:
+    constexpr aabb() noexcept = default;
+    constexpr aabb(vec_type const& min_, vec_type const& max_) noexcept : min(min_), max(max_) {}
+
+    template <size_t D_ = Dim, typename = std::enable_if_t<D_ == 2>>
+    constexpr aabb(rectangle_<T> const& rect) noexcept : min(rect.tl()), max(rect.br()) {}
+
+   public:
+    constexpr bool empty() const noexcept
+    {
+        for (size_t i = 0; i < Dim; ++i)
+            if (min.value[i] > max.value[i]) { return true; }
+
+        return false;
+    }
+
+    constexpr vec_type center() const noexcept { return (min + max) / T(2); }
+    constexpr vec_type extent() const noexcept { return max - min; }
+
+    constexpr aabb& merge(aabb const& other) noexcept
+    {
+        for (size_t i = 0; i < Dim; ++i) {
+            min.value[i] = std::min(min.value[i], other.min.value[i]);
+            max.value[i] = std::max(max.value[i], other.max.value[i]);
+        }
+        return *this;
+    }
+
+    constexpr aabb& merge(vec_type const& pt) noexcept
+    {
+        return merge(aabb{pt, pt});
+    }
+
+    constexpr bool intersects(aabb const& other) const noexcept
+    {
+        for (size_t i = 0; i < Dim; ++i) {
+            if (other.max.value[i] < min.value[i]) { return false; }
+            if (max.value[i] < other.min.value[i]) { return false; }
+        }
+        return true;
+    }
+
+    constexpr bool contains(vec_type const& pt) const noexcept
+    {
+        for (size_t i = 0; i < Dim; ++i)
+            if (not(min.value[i] <= pt.value[i] && pt.value[i] < max.value[i])) { return false; }
+
+        return true;
+    }
+
+    //! Squared distance from point to box. Zero if point is inside.
+    constexpr T distance_sqr(vec_type const& pt) const noexcept
+    {
+        T sum = 0;
+        for (size_t i = 0; i < Dim; ++i) {
+            auto d = std::max({min.value[i] - pt.value[i], T(0), pt.value[i] - max.value[i]});
+            sum += d * d;
+        }
+        return sum;
+    }
+
+    /**
+     * Slab test against ray P + tD, where t in [0, t_max]
+     *
+     * @return Entering t of ray, or negative value if ray doesn't intersect.
+     */
+    T intersect_ray(vec_type const& P, vec_type const& inv_D, T t_max) const noexcept
+    {
+        T t0 = 0, t1 = t_max;
+        for (size_t i = 0; i < Dim; ++i) {
+            auto a = (min.value[i] - P.value[i]) * inv_D.value[i];
+            auto b = (max.value[i] - P.value[i]) * inv_D.value[i];
+            if (a > b) { std::swap(a, b); }
+
+            // NaN(0 * inf) comparison fails, thus leaves range unchanged.
+            if (a > t0) { t0 = a; }
+            if (b < t1) { t1 = b; }
+        }
+
+        return t0 <= t1 ? t0 : T(-1);
+    }
+};
+
+/**
+ * Bounding volume hierarchy, which is laid out in flat array in depth-first order.
+ *
+ * Tree is built by splitting items in half on longest axis of their centers, thus shape of tree
+ *  only depends on number of items. Each subtree's position is calculated in advance, and
+ *  subtrees are built in parallel. Left child of inner node always comes right after it.
+ */
+template <typename T, size_t Dim = 3>
+class bvh
+{
+   public:
+    using box_type = aabb<T, Dim>;
+    using vec_type = vector<T, Dim>;
+    using index_type = uint32_t;
+
+    enum : index_type { npos = ~index_type{} };
+    enum : size_t { leaf_size = 4 };
+
+   private:
+    struct node_type {
+        box_type box;
+        index_type first = 0;  // index of first item if leaf, otherwise right child node.
+        index_type count = 0;  // number of items. zero if inner node.
+    };
+
+    struct build_task {
+        index_type node;
+        size_t begin, end;
+    };
+
+   private:
+    std::vector<node_type> nodes_;
+    std::vector<box_type> boxes_;
+    std::vector<index_type> indices_;
+    std::vector<vec_type> centers_;
+
+    // For incremental refit: parent of each node, and leaf node of each item.
+    std::vector<index_type> parents_;
+    std::vector<index_type> leaves_;
+
+   public:
+    bvh() noexcept = default;
+    explicit bvh(array_view<box_type const> boxes, batch_policy const& exec = {}) { build(boxes, exec); }
+
+   public:
+    size_t size() const noexcept { return boxes_.size(); }
+    bool empty() const noexcept { return boxes_.empty(); }
+    size_t num_nodes() const noexcept { return nodes_.size(); }
+    box_type const& bounds(index_type item) const noexcept { return boxes_[item]; }
+
+    /**
+     * Build tree of items. Items are identified by their index in given array.
+     */
+    void build(array_view<box_type const> boxes, batch_policy const& exec = {})
+    {
+        if (boxes.size() >= npos) { throw std::length_error{"too many items for bvh"}; }
+
+        boxes_.assign(boxes.begin(), boxes.end());
+        centers_.resize(boxes_.size());
+        indices_.resize(boxes_.size());
+        for (size_t i = 0; i < boxes_.size(); ++i) { indices_[i] = index_type(i), centers_[i] = boxes_[i].center(); }
+
+        nodes_.clear();
+        parents_.clear();
+        leaves_.resize(boxes_.size());
+        if (boxes_.empty()) { return; }
+
+        nodes_.resize(_num_nodes(boxes_.size()));
+        parents_.resize(nodes_.size());
+        parents_[0] = npos;
+
+        if (not exec.pool || boxes_.size() < exec.parallel_threshold) {
+            _build(0, 0, boxes_.size(), nullptr);
+        } else {
+            // Split top levels until there are enough independent subtrees.
+            std::vector<build_task> tasks;
+            size_t depth_limit = 2;
+            for (auto n = exec.pool->num_workers() + 1; n > 1; n >>= 1) { ++depth_limit; }
+
+            _build(0, 0, boxes_.size(), &tasks, depth_limit, exec.min_chunk_size);
+            parallel_for(*exec.pool, tasks.size(), [&](size_t i) {
+                _build(tasks[i].node, tasks[i].begin, tasks[i].end, nullptr);
+            });
+        }
+
+        centers_.clear();
+    }
+
+    /**
+     * Update bounds of items without changing tree topology, which is cheaper than rebuilding
+     *  but degrades query performance as items move far.
+     */
+    void refit(array_view<box_type const> boxes)
+    {
+        if (boxes.size() != boxes_.size()) { throw std::invalid_argument{"number of items changed"}; }
+        std::copy(boxes.begin(), boxes.end(), boxes_.begin());
+
+        // Children always come after their parent.
+        for (size_t i = nodes_.size(); i-- > 0;) {
+            auto& node = nodes_[i];
+            node.box = {};
+
+            if (node.count) {
+                for (auto idx : _items(node)) { node.box.merge(boxes_[idx]); }
+            } else {
+                node.box.merge(nodes_[i + 1].box).merge(nodes_[node.first].box);
+            }
+        }
+    }
+
+    //! Update bounds of single item, and its ancestors.
+    void refit(index_type item, box_type const& box)
+    {
+        boxes_[item] = box;
+
+        for (auto idx_node = leaves_[item]; idx_node != npos; idx_node = parents_[idx_node]) {
+            auto& node = nodes_[idx_node];
+            node.box = {};
+
+            if (node.count)
+                for (auto idx : _items(node)) { node.box.merge(boxes_[idx]); }
+            else
+                node.box.merge(nodes_[idx_node + 1].box).merge(nodes_[node.first].box);
+        }
+    }
+
+   public:
+    /**
+     * Invoke fn(item) for every item which intersects with box.
+     * Iteration stops if fn returns false.
+     */
+    template <typename Fn_>
+    void query(box_type const& box, Fn_&& fn) const
+    {
+        _traverse([&](node_type const& node) { return node.box.intersects(box); },
+                  [&](index_type idx) { return boxes_[idx].intersects(box) ? _invoke(fn, idx) : true; });
+    }
+
+    /**
+     * Invoke fn(item) for every item which contains point.
+     * Iteration stops if fn returns false.
+     */
+    template <typename Fn_>
+    void query(vec_type const& pt, Fn_&& fn) const
+    {
+        _traverse([&](node_type const& node) { return node.box.contains(pt); },
+                  [&](index_type idx) { return boxes_[idx].contains(pt) ? _invoke(fn, idx) : true; });
+    }
+
+    /**
+     * Invoke fn(item, t) for every item which intersects with ray P + tD where 0 <= t <= t_max.
+     * t is entering position of ray. Iteration stops if fn returns false.
+     */
+    template <typename Fn_>
+    void raycast(vec_type const& P, vec_type const& D, Fn_&& fn,
+                 T t_max = std::numeric_limits<T>::max()) const
+    {
+        vec_type inv_D;
+        for (size_t i = 0; i < Dim; ++i) { inv_D.value[i] = T(1) / D.value[i]; }
+
+        _traverse([&](node_type const& node) { return node.box.intersect_ray(P, inv_D, t_max) >= 0; },
+                  [&](index_type idx) {
+                      auto t = boxes_[idx].intersect_ray(P, inv_D, t_max);
+                      return t >= 0 ? _invoke(fn, idx, t) : true;
+                  });
+    }
+
+    /**
+     * Find item nearest to point.
+     *
+     * @param distance_sqr Squared distance from point to item, which must not be less than
+     *  distance to its bounding box. e.g. calc_distance_sqr() for line items.
+     * @return Index of nearest item, or npos if there's no item within max_distance_sqr.
+     */
+    template <typename DistFn_,
+              typename = std::enable_if_t<std::is_invocable_r_v<T, DistFn_&, index_type>>>
+    index_type nearest(vec_type const& pt, DistFn_&& distance_sqr,
+                       T max_distance_sqr = std::numeric_limits<T>::max()) const
+    {
+        auto best = index_type(npos);
+        auto best_dist = max_distance_sqr;
+
+        // Visit nearer child first, to shrink search radius fast.
+        index_type stack[64];
+        size_t top = 0;
+        if (not nodes_.empty()) { stack[top++] = 0; }
+
+        while (top) {
+            auto& node = nodes_[stack[--top]];
+            if (node.box.distance_sqr(pt) > best_dist) { continue; }
+
+            if (node.count) {
+                for (auto idx : _items(node)) {
+                    if (boxes_[idx].distance_sqr(pt) > best_dist) { continue; }
+
+                    T dist = distance_sqr(idx);
+                    if (dist < best_dist || (dist == best_dist && idx < best)) { best = idx, best_dist = dist; }
+                }
+            } else {
+                index_type l = index_type(&node - nodes_.data()) + 1, r = node.first;
+                if (nodes_[l].box.distance_sqr(pt) < nodes_[r].box.distance_sqr(pt)) { std::swap(l, r); }
+
+                stack[top++] = l, stack[top++] = r;
+            }
+        }
+
+        return best;
+    }
+
+    //! Find item of which bounding box is nearest to point.
+    index_type nearest(vec_type const& pt, T max_distance_sqr = std::numeric_limits<T>::max()) const
+    {
+        return nearest(pt, [&](index_type idx) { return boxes_[idx].distance_sqr(pt); }, max_distance_sqr);
+    }
+
+   public:
+    /**
+     * Batch hit test. Writes item with smallest index which contains each point, or npos.
+     */
+    void hit_test(array_view<vec_type const> points, array_view<index_type> out,
+                  batch_policy const& exec = {}) const
+    {
+        if (out.size() < points.size()) { throw std::out_of_range{"output buffer too small"}; }
+
+        run_chunked(exec, points.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                index_type hit = npos;
+                query(points[i], [&](index_type idx) { hit = std::min(hit, idx); });
+                out[i] = hit;
+            }
+        });
+    }
+
+    /**
+     * Batch box query. Appends (query index, item index) pairs of every intersection, sorted by
+     *  query index.
+     */
+    void query(array_view<box_type const> boxes, std::vector<array<index_type, 2>>& out,
+               batch_policy const& exec = {}) const
+    {
+        std::vector<std::vector<array<index_type, 2>>> partials;
+        std::mutex mtx;
+
+        run_chunked(exec, boxes.size(), [&](size_t begin, size_t end) {
+            std::vector<array<index_type, 2>> local;
+            for (size_t i = begin; i < end; ++i)
+                query(boxes[i], [&](index_type idx) { local.push_back({index_type(i), idx}); });
+
+            std::lock_guard _{mtx};
+            partials.push_back(std::move(local));
+        });
+
+        std::sort(partials.begin(), partials.end(), [](auto& a, auto& b) {
+            return not b.empty() && (a.empty() || a[0][0] < b[0][0]);
+        });
+
+        for (auto& partial : partials) { out.insert(out.end(), partial.begin(), partial.end()); }
+    }
+
+   private:
+    array_view<index_type const> _items(node_type const& node) const noexcept
+    {
+        return {indices_.data() + node.first, node.count};
+    }
+
+    template <typename Fn_, typename... Args_>
+    static bool _invoke(Fn_& fn, Args_... args)
+    {
+        if constexpr (std::is_same_v<std::invoke_result_t<Fn_&, Args_...>, bool>) {
+            return fn(args...);
+        } else {
+            return fn(args...), true;
+        }
+    }
+
+    template <typename NodeFn_, typename ItemFn_>
+    void _traverse(NodeFn_&& visit_node, ItemFn_&& visit_item) const
+    {
+        index_type stack[64];
+        size_t top = 0;
+        if (not nodes_.empty()) { stack[top++] = 0; }
+
+        while (top) {
+            auto idx_node = stack[--top];
+            auto& node = nodes_[idx_node];
+            if (not visit_node(node)) { continue; }
+
+            if (node.count) {
+                for (auto idx : _items(node))
+                    if (not visit_item(idx)) { return; }
+            } else {
+                stack[top++] = node.first;
+                stack[top++] = idx_node + 1;
+            }
+        }
+    }
+
+    void _build(index_type idx_node, size_t begin, size_t end, std::vector<build_task>* tasks,
+                size_t depth_limit = 0, size_t min_task_size = 0)
+    {
+        auto& node = nodes_[idx_node];
+        node.box = {};
+        box_type center_bounds;
+
+        for (auto i = begin; i < end; ++i) {
+            node.box.merge(boxes_[indices_[i]]);
+            center_bounds.merge(centers_[indices_[i]]);
+        }
+
+        if (end - begin <= leaf_size) {
+            node.first = index_type(begin);
+            node.count = index_type(end - begin);
+
+            for (auto i = begin; i < end; ++i) { leaves_[indices_[i]] = idx_node; }
+            return;
+        }
+
+        // Split on longest axis
+        auto extent = center_bounds.extent();
+        auto axis = std::max_element(extent.begin(), extent.end()) - extent.begin();
+        auto mid = begin + (end - begin) / 2;
+
+        auto first = indices_.begin();
+        std::nth_element(first + begin, first + mid, first + end, [&](index_type a, index_type b) {
+            return centers_[a].value[axis] < centers_[b].value[axis];
+        });
+
+        auto idx_right = index_type(idx_node + 1 + _num_nodes(mid - begin));
+        node.first = idx_right;
+        node.count = 0;
+        parents_[idx_node + 1] = parents_[idx_right] = idx_node;
+
+        if (tasks && (depth_limit <= 1 || end - begin < min_task_size * 2)) {
+            tasks->push_back({idx_node + 1, begin, mid});
+            tasks->push_back({idx_right, mid, end});
+        } else {
+            _build(idx_node + 1, begin, mid, tasks, depth_limit - 1, min_task_size);
+            _build(idx_right, mid, end, tasks, depth_limit - 1, min_task_size);
+        }
+    }
+
+    //! Returns number of leaves of tree which has n, n+1 items, respectively.
+    static std::pair<size_t, size_t> _num_leaves_pair(size_t n) noexcept
+    {
+        if (n + 1 <= leaf_size) { return {1, 1}; }
+        if (n <= leaf_size) { return {1, 2}; }
+
+        // Both n and n+1 are split into halves of size n/2 or n/2 + 1.
+        auto [a, b] = _num_leaves_pair(n / 2);
+        if (n % 2 == 0)
+            return {a + a, a + b};
+        else
+            return {a + b, b + b};
+    }
+
+    static size_t _num_nodes(size_t n) noexcept
+    {
+        return _num_leaves_pair(n).first * 2 - 1;
+    }
+};
+
+template <typename T>
+using rect_bvh = bvh<T, 2>;
+}  // namespace cpph::math
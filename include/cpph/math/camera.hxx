@@ -3,6 +3,7 @@
 #include <cpph/std/vector>
 
 #include "cpph/utility/counter.hxx"
+#include "frustum.hxx"
 #include "geometry.hxx"
 #include "matrix.hxx"
 #include "plane.hxx"
@@ -66,6 +67,10 @@ auto undistort_pixel(vector<T, 2> const& P_d,
     return P_u_aprx;
 }
 
+/**
+ * Cull polyline against frustum planes. See frustum_culler for batch of polylines, which reuses
+ *  its buffers across calls.
+ */
 template <class T, size_t Dim>
 void cull_frustum(
         const_array_view<plane<T, Dim>> frustum,
@@ -78,10 +83,12 @@ void cull_frustum(
     out_seqs.push_back({0, io_dots.size()});
 
     for (auto& pl : frustum) {
-        auto current_segments = array_view{out_seqs}.subspan(latest_sequence_begin);
+        // Iterate by index, as culling appends to out_seqs, which may reallocate.
+        auto const current_begin = latest_sequence_begin;
         latest_sequence_begin = out_seqs.size();
 
-        for (auto [begin, end] : current_segments) {
+        for (size_t i = current_begin; i < latest_sequence_begin; ++i) {
+            auto const [begin, end] = out_seqs[i];
             auto const segment_size = end - begin;
             auto const initial_dots_size = io_dots.size();
 
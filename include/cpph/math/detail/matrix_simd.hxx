@@ -0,0 +1,198 @@
+// MIT License
+//
+// Copyright (c) 2021-2022. Seungwoo Kang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// project home: https://github.com/perfkitpp
+
+
+#pragma once
+#include <type_traits>
+
+#include "../../helper/macros.hxx"
+
+/*
+ * Instruction set detection. Define CPPH_MATH_NO_SIMD to disable SIMD kernels.
+ */
+#if !defined(CPPH_MATH_NO_SIMD)
+#    if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#        define INTERNAL_CPPH_MATH_SSE2 1
+#        include <emmintrin.h>
+#    endif
+#    if defined(__AVX__)
+#        define INTERNAL_CPPH_MATH_AVX 1
+#        include <immintrin.h>
+#    endif
+#    if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#        define INTERNAL_CPPH_MATH_NEON 1
+#        include <arm_neon.h>
+#    endif
+#endif
+
+namespace cpph::math::_detail::simd {
+/**
+ * Four lanes of float or double, which maps to single native register where available.
+ * Falls back to plain array, which is still vectorized by compiler in most cases.
+ */
+template <typename Ty_>
+struct x4;
+
+#if defined(INTERNAL_CPPH_MATH_SSE2)
+template <>
+struct x4<float> {
+    __m128 v;
+
+    static x4 load(float const* p) noexcept { return {_mm_loadu_ps(p)}; }
+    static x4 splat(float s) noexcept { return {_mm_set1_ps(s)}; }
+    void store(float* p) const noexcept { _mm_storeu_ps(p, v); }
+
+    friend x4 operator+(x4 a, x4 b) noexcept { return {_mm_add_ps(a.v, b.v)}; }
+    friend x4 operator*(x4 a, x4 b) noexcept { return {_mm_mul_ps(a.v, b.v)}; }
+
+    static void transpose(x4& r0, x4& r1, x4& r2, x4& r3) noexcept
+    {
+        _MM_TRANSPOSE4_PS(r0.v, r1.v, r2.v, r3.v);
+    }
+};
+#elif defined(INTERNAL_CPPH_MATH_NEON)
+template <>
+struct x4<float> {
+    float32x4_t v;
+
+    static x4 load(float const* p) noexcept { return {vld1q_f32(p)}; }
+    static x4 splat(float s) noexcept { return {vdupq_n_f32(s)}; }
+    void store(float* p) const noexcept { vst1q_f32(p, v); }
+
+    friend x4 operator+(x4 a, x4 b) noexcept { return {vaddq_f32(a.v, b.v)}; }
+    friend x4 operator*(x4 a, x4 b) noexcept { return {vmulq_f32(a.v, b.v)}; }
+
+    static void transpose(x4& r0, x4& r1, x4& r2, x4& r3) noexcept
+    {
+        auto t01 = vtrnq_f32(r0.v, r1.v);
+        auto t23 = vtrnq_f32(r2.v, r3.v);
+
+        r0.v = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+        r1.v = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+        r2.v = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+        r3.v = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+    }
+};
+#endif
+
+#if defined(INTERNAL_CPPH_MATH_AVX)
+template <>
+struct x4<double> {
+    __m256d v;
+
+    static x4 load(double const* p) noexcept { return {_mm256_loadu_pd(p)}; }
+    static x4 splat(double s) noexcept { return {_mm256_set1_pd(s)}; }
+    void store(double* p) const noexcept { _mm256_storeu_pd(p, v); }
+
+    friend x4 operator+(x4 a, x4 b) noexcept { return {_mm256_add_pd(a.v, b.v)}; }
+    friend x4 operator*(x4 a, x4 b) noexcept { return {_mm256_mul_pd(a.v, b.v)}; }
+
+    static void transpose(x4& r0, x4& r1, x4& r2, x4& r3) noexcept
+    {
+        auto t0 = _mm256_unpacklo_pd(r0.v, r1.v);
+        auto t1 = _mm256_unpackhi_pd(r0.v, r1.v);
+        auto t2 = _mm256_unpacklo_pd(r2.v, r3.v);
+        auto t3 = _mm256_unpackhi_pd(r2.v, r3.v);
+
+        r0.v = _mm256_permute2f128_pd(t0, t2, 0x20);
+        r1.v = _mm256_permute2f128_pd(t1, t3, 0x20);
+        r2.v = _mm256_permute2f128_pd(t0, t2, 0x31);
+        r3.v = _mm256_permute2f128_pd(t1, t3, 0x31);
+    }
+};
+#elif defined(INTERNAL_CPPH_MATH_SSE2)
+template <>
+struct x4<double> {
+    __m128d lo, hi;
+
+    static x4 load(double const* p) noexcept { return {_mm_loadu_pd(p), _mm_loadu_pd(p + 2)}; }
+    static x4 splat(double s) noexcept { return {_mm_set1_pd(s), _mm_set1_pd(s)}; }
+    void store(double* p) const noexcept { _mm_storeu_pd(p, lo), _mm_storeu_pd(p + 2, hi); }
+
+    friend x4 operator+(x4 a, x4 b) noexcept { return {_mm_add_pd(a.lo, b.lo), _mm_add_pd(a.hi, b.hi)}; }
+    friend x4 operator*(x4 a, x4 b) noexcept { return {_mm_mul_pd(a.lo, b.lo), _mm_mul_pd(a.hi, b.hi)}; }
+
+    static void transpose(x4& r0, x4& r1, x4& r2, x4& r3) noexcept
+    {
+        x4 o0 = {_mm_unpacklo_pd(r0.lo, r1.lo), _mm_unpacklo_pd(r2.lo, r3.lo)};
+        x4 o1 = {_mm_unpackhi_pd(r0.lo, r1.lo), _mm_unpackhi_pd(r2.lo, r3.lo)};
+        x4 o2 = {_mm_unpacklo_pd(r0.hi, r1.hi), _mm_unpacklo_pd(r2.hi, r3.hi)};
+        x4 o3 = {_mm_unpackhi_pd(r0.hi, r1.hi), _mm_unpackhi_pd(r2.hi, r3.hi)};
+
+        r0 = o0, r1 = o1, r2 = o2, r3 = o3;
+    }
+};
+#endif
+
+template <typename Ty_, typename = void>
+constexpr bool has_x4_v = false;
+
+template <typename Ty_>
+constexpr bool has_x4_v<Ty_, std::void_t<decltype(sizeof(x4<Ty_>))>> = true;
+
+/**
+ * out = a * b, for row-major 4x4 matrices.
+ *
+ * Each output row is linear combination of rows of b, thus no horizontal operation needed.
+ */
+template <typename Ty_>
+void mul_44(Ty_ const* a, Ty_ const* b, Ty_* out) noexcept
+{
+    using V = x4<Ty_>;
+    auto b0 = V::load(b + 0), b1 = V::load(b + 4), b2 = V::load(b + 8), b3 = V::load(b + 12);
+
+    for (int i = 0; i < 4; ++i) {
+        auto r = a + i * 4;
+        auto v = V::splat(r[0]) * b0 + V::splat(r[1]) * b1 + V::splat(r[2]) * b2 + V::splat(r[3]) * b3;
+        v.store(out + i * 4);
+    }
+}
+
+/**
+ * out = m * v, for row-major 4x4 matrix and 4-vector
+ */
+template <typename Ty_>
+void mul_44_41(Ty_ const* m, Ty_ const* v, Ty_* out) noexcept
+{
+    using V = x4<Ty_>;
+    auto c0 = V::load(m + 0), c1 = V::load(m + 4), c2 = V::load(m + 8), c3 = V::load(m + 12);
+    V::transpose(c0, c1, c2, c3);
+
+    auto r = c0 * V::splat(v[0]) + c1 * V::splat(v[1]) + c2 * V::splat(v[2]) + c3 * V::splat(v[3]);
+    r.store(out);
+}
+
+/**
+ * out = transpose(m), for row-major 4x4 matrix
+ */
+template <typename Ty_>
+void transpose_44(Ty_ const* m, Ty_* out) noexcept
+{
+    using V = x4<Ty_>;
+    auto r0 = V::load(m + 0), r1 = V::load(m + 4), r2 = V::load(m + 8), r3 = V::load(m + 12);
+    V::transpose(r0, r1, r2, r3);
+
+    r0.store(out + 0), r1.store(out + 4), r2.store(out + 8), r3.store(out + 12);
+}
+}  // namespace cpph::math::_detail::simd
@@ -0,0 +1,207 @@
+// MIT License
+//
+// Copyright (c) 2021-2022. Seungwoo Kang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// project home: https://github.com/perfkitpp
+
+
+#pragma once
+#include <cpph/std/array>
+#include <cpph/std/vector>
+
+#include "batch.hxx"
+#include "plane.hxx"
+
+namespace cpph::math {
+/**
+ * Culls batch of polylines against set of planes, which keeps parts on normal side of every
+ *  plane.
+ *
+ * Vertices are kept in structure-of-arrays form, and ping-pong between two buffers on each plane
+ *  pass. Signed distances of all vertices are evaluated at once before each pass. All buffers
+ *  are owned by culler and reused across calls, thus steady-state culling doesn't allocate.
+ */
+template <typename T, size_t Dim = 3>
+class frustum_culler
+{
+   public:
+    using vec_type = vector<T, Dim>;
+    using plane_type = plane<T, Dim>;
+    using sequence_type = array<size_t, 2>;
+
+   private:
+    struct buffer_type {
+        point_batch<T, Dim> dots;
+        std::vector<sequence_type> seqs;
+
+        void clear() noexcept { dots.clear(), seqs.clear(); }
+    };
+
+    buffer_type buffers_[2];
+    std::vector<T> dists_;
+
+   public:
+    /**
+     * @param frustum Planes to cull against.
+     * @param dots Vertices of all polylines.
+     * @param seqs Ranges of each polyline in dots, as [begin, end)
+     * @param out_dots Vertices of culled polylines. Cleared before written.
+     * @param out_seqs Ranges of culled polylines in out_dots. Cleared before written.
+     * @param is_closed Treat each polyline as closed polygon
+     */
+    void cull(array_view<plane_type const> frustum,
+              array_view<vec_type const> dots,
+              array_view<sequence_type const> seqs,
+              std::vector<vec_type>& out_dots,
+              std::vector<sequence_type>& out_seqs,
+              bool is_closed = false,
+              batch_policy const& exec = {})
+    {
+        auto* src = &buffers_[0];
+        auto* dst = &buffers_[1];
+
+        src->dots.assign(dots);
+        src->seqs.assign(seqs.begin(), seqs.end());
+
+        for (auto& pl : frustum) {
+            dists_.resize(src->dots.size());
+            math::distance(array_view<T>{dists_}, src->dots, pl, exec);
+
+            dst->clear();
+            for (auto& seq : src->seqs) {
+                if (is_closed)
+                    _cull_closed(*src, *dst, seq);
+                else
+                    _cull_open(*src, *dst, seq);
+            }
+
+            std::swap(src, dst);
+        }
+
+        out_dots.resize(src->dots.size());
+        src->dots.copy_to(out_dots);
+        out_seqs.assign(src->seqs.begin(), src->seqs.end());
+    }
+
+    //! Release scratch buffers
+    void shrink_to_fit()
+    {
+        for (auto& buf : buffers_) {
+            buf.clear();
+            buf.dots.shrink_to_fit();
+            buf.seqs.shrink_to_fit();
+        }
+
+        dists_.clear(), dists_.shrink_to_fit();
+    }
+
+   private:
+    bool _upper(size_t i) const noexcept { return dists_[i] > 0; }
+
+    void _emit(buffer_type const& src, buffer_type& dst, size_t i) const
+    {
+        vec_type v;
+        for (size_t d = 0; d < Dim; ++d) { v.value[d] = src.dots.lane(d)[i]; }
+        dst.dots.push_back(v);
+    }
+
+    //! Emit contact point of line segment a-b with plane
+    void _emit_contact(buffer_type const& src, buffer_type& dst, size_t a, size_t b) const
+    {
+        // Distance changes linearly along the segment.
+        auto u = dists_[a] / (dists_[a] - dists_[b]);
+
+        vec_type v;
+        for (size_t d = 0; d < Dim; ++d) {
+            auto lane = src.dots.lane(d);
+            v.value[d] = lane[a] + u * (lane[b] - lane[a]);
+        }
+
+        dst.dots.push_back(v);
+    }
+
+    void _fence(buffer_type& dst, size_t begin) const
+    {
+        if (dst.dots.size() - begin >= 2)
+            dst.seqs.push_back({begin, dst.dots.size()});
+        else
+            dst.dots.resize(begin);
+    }
+
+    void _cull_open(buffer_type const& src, buffer_type& dst, sequence_type const& seq) const
+    {
+        auto [begin, end] = seq;
+        if (end - begin < 2) { return; }
+
+        for (size_t i = begin;;) {
+            // Skip vertices under the plane
+            for (; i < end && not _upper(i); ++i) {}
+            if (i == end) { break; }
+
+            auto fence = dst.dots.size();
+            if (i > begin) { _emit_contact(src, dst, i - 1, i); }
+
+            for (; i < end && _upper(i); ++i) { _emit(src, dst, i); }
+            if (i < end) { _emit_contact(src, dst, i - 1, i); }
+
+            _fence(dst, fence);
+        }
+    }
+
+    void _cull_closed(buffer_type const& src, buffer_type& dst, sequence_type const& seq) const
+    {
+        auto [begin, end] = seq;
+        auto const n = end - begin;
+        if (n < 2) { return; }
+
+        // Start iteration from any vertex under the plane, thus every upper run is enclosed
+        //  with two contact points.
+        auto pivot = begin;
+        for (; pivot < end && _upper(pivot); ++pivot) {}
+
+        if (pivot == end) {
+            auto fence = dst.dots.size();
+            for (auto i = begin; i < end; ++i) { _emit(src, dst, i); }
+            return _fence(dst, fence);
+        }
+
+        auto at = [&](size_t k) { return begin + (pivot - begin + k) % n; };
+        size_t fence = 0;
+
+        for (size_t k = 1; k <= n; ++k) {
+            auto prev = at(k - 1), curr = at(k);
+            if (not _upper(curr)) { continue; }
+
+            if (not _upper(prev)) {
+                fence = dst.dots.size();
+                _emit_contact(src, dst, prev, curr);
+            }
+
+            _emit(src, dst, curr);
+
+            if (auto next = at(k + 1); not _upper(next)) {
+                _emit_contact(src, dst, curr, next);
+                _fence(dst, fence);
+            }
+        }
+    }
+};
+}  // namespace cpph::math
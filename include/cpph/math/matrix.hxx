@@ -30,6 +30,7 @@
 
 #include "../utility/array_view.hxx"
 #include "defs.hxx"
+#include "detail/matrix_simd.hxx"
 
 //
 
@@ -327,6 +328,14 @@ class matrix
     t() const noexcept
     {
         matx_type<num_cols, num_rows> result = {};
+
+        if constexpr (Row_ == 4 && Col_ == 4 && _detail::simd::has_x4_v<Ty_>) {
+            if (not CPPH_IS_CONSTANT_EVALUATED()) {
+                _detail::simd::transpose_44(value, result.value);
+                return result;
+            }
+        }
+
         for (int i = 0; i < num_rows; ++i)
             for (int j = 0; j < num_cols; ++j)
                 result(j, i) = (*this)(i, j);
@@ -494,18 +503,63 @@ class matrix
 
     template <int NewCol_>
     constexpr matx_type<Row_, NewCol_>
-    operator*(matx_type<Col_, NewCol_> other) const noexcept
+    operator*(matx_type<Col_, NewCol_> const& other) const noexcept
     {
         // performs matrix multiply
         matx_type<Row_, NewCol_> result = {};
 
-        for (int i = 0; i < Row_; ++i)
-            for (int j = 0; j < NewCol_; ++j)
-                result(i, j) = row(i).dot(other.col(j));
+        if constexpr (Row_ == 4 && Col_ == 4 && (NewCol_ == 4 || NewCol_ == 1)
+                      && _detail::simd::has_x4_v<Ty_>) {
+            if (not CPPH_IS_CONSTANT_EVALUATED()) {
+                if constexpr (NewCol_ == 4)
+                    _detail::simd::mul_44(value, other.value, result.value);
+                else
+                    _detail::simd::mul_44_41(value, other.value, result.value);
 
+                return result;
+            }
+        }
+
+        if constexpr (Row_ * Col_ * NewCol_ <= 64) {
+            // Small sizes are fully unrolled; each element is independent sum of products.
+            _mul_unrolled(other, result, std::make_index_sequence<Row_ * NewCol_>{});
+        } else {
+            // Accumulate rows of other on local row buffer, which never aliases operands.
+            for (int i = 0; i < Row_; ++i) {
+                value_type acc[NewCol_] = {};
+
+                for (int k = 0; k < Col_; ++k) {
+                    auto scale = value[i * Col_ + k];
+                    for (int j = 0; j < NewCol_; ++j)
+                        acc[j] += scale * other.value[k * NewCol_ + j];
+                }
+
+                for (int j = 0; j < NewCol_; ++j)
+                    result.value[i * NewCol_ + j] = acc[j];
+            }
+        }
         return result;
     }
 
+   private:
+    template <int NewCol_, size_t... K_>
+    constexpr value_type _mul_elem(matx_type<Col_, NewCol_> const& other, int i, int j,
+                                   std::index_sequence<K_...>) const noexcept
+    {
+        return ((value[i * Col_ + K_] * other.value[K_ * NewCol_ + j]) + ...);
+    }
+
+    template <int NewCol_, size_t... I_>
+    constexpr void _mul_unrolled(matx_type<Col_, NewCol_> const& other,
+                                 matx_type<Row_, NewCol_>& result,
+                                 std::index_sequence<I_...>) const noexcept
+    {
+        ((result.value[I_] = _mul_elem(other, I_ / NewCol_, I_ % NewCol_,
+                                       std::make_index_sequence<Col_>{})),
+         ...);
+    }
+
+   public:
     constexpr bool operator==(matrix const& other) const noexcept
     {
         for (int i = 0; i < length; ++i)
@@ -621,6 +675,15 @@ class matrix
      * @return false if there's no solution
      */
     constexpr optional<matrix> inv() const noexcept
+    {
+        if constexpr (Row_ == Col_ && 2 <= Row_ && Row_ <= 4 && std::is_floating_point_v<Ty_>)
+            return _inv_closed_form();
+        else
+            return _inv_gauss_jordan();
+    }
+
+   private:
+    constexpr optional<matrix> _inv_gauss_jordan() const noexcept
     {
         auto R = eye();
         auto s = *this;
@@ -662,6 +725,73 @@ class matrix
         return R;
     }
 
+    // Inverse by adjugate, for small square matrices
+    constexpr optional<matrix> _inv_closed_form() const noexcept
+    {
+        auto& a = value;
+        matrix r = {};
+
+        if constexpr (Row_ == 2) {
+            auto det = a[0] * a[3] - a[1] * a[2];
+            if (det == 0) { return {}; }
+
+            r = create(a[3], -a[1], -a[2], a[0]);
+            return r /= det;
+        } else if constexpr (Row_ == 3) {
+            auto c0 = a[4] * a[8] - a[5] * a[7];
+            auto c1 = a[5] * a[6] - a[3] * a[8];
+            auto c2 = a[3] * a[7] - a[4] * a[6];
+
+            auto det = a[0] * c0 + a[1] * c1 + a[2] * c2;
+            if (det == 0) { return {}; }
+
+            r = create(c0, a[2] * a[7] - a[1] * a[8], a[1] * a[5] - a[2] * a[4],
+                       c1, a[0] * a[8] - a[2] * a[6], a[2] * a[3] - a[0] * a[5],
+                       c2, a[1] * a[6] - a[0] * a[7], a[0] * a[4] - a[1] * a[3]);
+            return r *= Ty_(1) / det;
+        } else {
+            // 2x2 sub-determinants of upper and lower two rows
+            auto s0 = a[0] * a[5] - a[4] * a[1];
+            auto s1 = a[0] * a[6] - a[4] * a[2];
+            auto s2 = a[0] * a[7] - a[4] * a[3];
+            auto s3 = a[1] * a[6] - a[5] * a[2];
+            auto s4 = a[1] * a[7] - a[5] * a[3];
+            auto s5 = a[2] * a[7] - a[6] * a[3];
+
+            auto c5 = a[10] * a[15] - a[14] * a[11];
+            auto c4 = a[9] * a[15] - a[13] * a[11];
+            auto c3 = a[9] * a[14] - a[13] * a[10];
+            auto c2 = a[8] * a[15] - a[12] * a[11];
+            auto c1 = a[8] * a[14] - a[12] * a[10];
+            auto c0 = a[8] * a[13] - a[12] * a[9];
+
+            auto det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+            if (det == 0) { return {}; }
+
+            r = create(
+                    a[5] * c5 - a[6] * c4 + a[7] * c3,
+                    -a[1] * c5 + a[2] * c4 - a[3] * c3,
+                    a[13] * s5 - a[14] * s4 + a[15] * s3,
+                    -a[9] * s5 + a[10] * s4 - a[11] * s3,
+
+                    -a[4] * c5 + a[6] * c2 - a[7] * c1,
+                    a[0] * c5 - a[2] * c2 + a[3] * c1,
+                    -a[12] * s5 + a[14] * s2 - a[15] * s1,
+                    a[8] * s5 - a[10] * s2 + a[11] * s1,
+
+                    a[4] * c4 - a[5] * c2 + a[7] * c0,
+                    -a[0] * c4 + a[1] * c2 - a[3] * c0,
+                    a[12] * s4 - a[13] * s2 + a[15] * s0,
+                    -a[8] * s4 + a[9] * s2 - a[11] * s0,
+
+                    -a[4] * c3 + a[5] * c1 - a[6] * c0,
+                    a[0] * c3 - a[1] * c1 + a[2] * c0,
+                    -a[12] * s3 + a[13] * s1 - a[14] * s0,
+                    a[8] * s3 - a[9] * s1 + a[10] * s0);
+            return r *= Ty_(1) / det;
+        }
+    }
+
    public:
     value_type value[length];
 };
@@ -0,0 +1,287 @@
+// MIT License
+//
+// Copyright (c) 2021-2022. Seungwoo Kang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// project home: https://github.com/perfkitpp
+
+
+#pragma once
+#include <cpph/std/map>
+#include <cpph/std/memory>
+#include <cpph/std/mutex>
+#include <cpph/std/vector>
+#include <stdexcept>
+
+#include "../container/ndarray.hxx"
+#include "batch.hxx"
+
+/**
+ * Precomputed pixel mapping for lens undistortion.
+ *
+ * Undistorted image is built by sampling distorted source image on distorted position of each
+ *  destination pixel. As this direction only requires forward distortion model, which is closed
+ *  form, table is built without any iteration, and applying it on each frame is plain bilinear
+ *  sampling.
+ */
+namespace cpph::math {
+/**
+ * Pinhole camera with radial(k) and tangential(p) distortion coefficients.
+ */
+template <typename T, size_t N_K>
+struct pinhole_lens {
+    T fx = 1, fy = 1;
+    T cx = 0, cy = 0;
+    T k[N_K] = {};
+    T p[2] = {};
+};
+
+/**
+ * Maps each destination pixel to source image coordinate.
+ */
+class remap_table
+{
+   public:
+    //! Sentinel of x0 for pixels which sample outside of source image
+    enum : int32_t { invalid_tap = -1 };
+
+   public:
+    size_t width = 0;
+    size_t height = 0;
+
+    //! Top-left tap of bilinear sampling, and weight of right/bottom taps.
+    std::vector<int32_t> x0, y0;
+    std::vector<float> wx, wy;
+
+   public:
+    size_t size() const noexcept { return width * height; }
+
+    void resize(size_t w, size_t h)
+    {
+        width = w, height = h;
+        x0.resize(w * h), y0.resize(w * h);
+        wx.resize(w * h), wy.resize(w * h);
+    }
+
+    /**
+     * Update bilinear taps of n pixels from 'begin', with their source coordinates. Source
+     *  coordinates are not kept, as taps are all that remap() needs.
+     */
+    void compile(size_t begin, float const* mx, float const* my, size_t n) noexcept
+    {
+        auto const max_x = float(width - 1), max_y = float(height - 1);
+
+        for (size_t i = begin, end = begin + n; i < end; ++i, ++mx, ++my) {
+            auto x = *mx, y = *my;
+
+            // Negated comparison also filters NaN out.
+            if (not(x >= 0 && y >= 0 && x <= max_x && y <= max_y)) {
+                x0[i] = invalid_tap, y0[i] = 0, wx[i] = wy[i] = 0;
+                continue;
+            }
+
+            auto ix = int32_t(x), iy = int32_t(y);
+            x0[i] = ix, y0[i] = iy;
+            wx[i] = x - float(ix), wy[i] = y - float(iy);
+        }
+    }
+};
+
+namespace _detail::remap {
+//! Convert per-point policy into per-row one.
+inline batch_policy row_policy(batch_policy policy, size_t width) noexcept
+{
+    width = std::max<size_t>(width, 1);
+    policy.parallel_threshold = std::max<size_t>(policy.parallel_threshold / width, 1);
+    policy.min_chunk_size = std::max<size_t>(policy.min_chunk_size / width, 1);
+    return policy;
+}
+}  // namespace _detail::remap
+
+/**
+ * Build undistortion table of given lens and resolution. Rows are processed in parallel.
+ */
+template <typename T, size_t N_K>
+void build_undistort_table(remap_table& table, pinhole_lens<T, N_K> const& lens,
+                           size_t width, size_t height, batch_policy const& exec = {})
+{
+    table.resize(width, height);
+
+    auto const policy = _detail::remap::row_policy(exec, width);
+
+    run_chunked(policy, height, [&](size_t row_begin, size_t row_end) {
+        std::vector<T> buf(width * 4);
+        auto x_u = buf.data(), y_u = x_u + width, x_d = y_u + width, y_d = x_d + width;
+
+        std::vector<float> map(width * 2);
+        auto mx = map.data(), my = mx + width;
+
+        auto const inv_fx = T(1) / lens.fx, inv_fy = T(1) / lens.fy;
+
+        for (size_t i = 0; i < width; ++i) { x_u[i] = (T(i) - lens.cx) * inv_fx; }
+
+        for (size_t row = row_begin; row < row_end; ++row) {
+            std::fill_n(y_u, width, (T(row) - lens.cy) * inv_fy);
+            _detail::batch::distort_n(x_u, y_u, x_d, y_d, width, lens.k, lens.p);
+
+            CPPH_VECTORIZE_LOOP
+            for (size_t i = 0; i < width; ++i) {
+                mx[i] = float(x_d[i] * lens.fx + lens.cx);
+                my[i] = float(y_d[i] * lens.fy + lens.cy);
+            }
+
+            table.compile(row * width, mx, my, width);
+        }
+    });
+}
+
+/**
+ * Caches undistortion tables by lens parameters and resolution.
+ */
+class remap_cache
+{
+    using key_type = std::vector<double>;
+
+    struct entry_type {
+        std::shared_ptr<remap_table const> table;
+        uint64_t fence = 0;
+    };
+
+   private:
+    mutable std::mutex mtx_;
+    std::map<key_type, entry_type> tables_;
+    uint64_t fence_ = 0;
+    size_t capacity_;
+
+   public:
+    explicit remap_cache(size_t capacity = 8) noexcept : capacity_(std::max<size_t>(capacity, 1)) {}
+
+   public:
+    /**
+     * Find table of given lens, or build new one if it doesn't exist.
+     */
+    template <typename T, size_t N_K>
+    std::shared_ptr<remap_table const>
+    get(pinhole_lens<T, N_K> const& lens, size_t width, size_t height, batch_policy const& exec = {})
+    {
+        key_type key;
+        key.reserve(6 + N_K + 2);
+        key.insert(key.end(), {double(width), double(height), double(lens.fx), double(lens.fy),
+                               double(lens.cx), double(lens.cy), double(lens.p[0]), double(lens.p[1])});
+        key.insert(key.end(), std::begin(lens.k), std::end(lens.k));
+
+        {
+            std::lock_guard _{mtx_};
+            if (auto iter = tables_.find(key); iter != tables_.end()) {
+                iter->second.fence = ++fence_;
+                return iter->second.table;
+            }
+        }
+
+        // Build outside of lock, as it may take a while.
+        auto table = std::make_shared<remap_table>();
+        build_undistort_table(*table, lens, width, height, exec);
+
+        std::lock_guard _{mtx_};
+        auto [iter, is_new] = tables_.try_emplace(std::move(key), entry_type{std::move(table)});
+        iter->second.fence = ++fence_;
+
+        if (is_new && tables_.size() > capacity_) {
+            // Evict least recently used one
+            auto victim = tables_.begin();
+            for (auto it = tables_.begin(); it != tables_.end(); ++it)
+                if (it->second.fence < victim->second.fence) { victim = it; }
+
+            tables_.erase(victim);
+        }
+
+        return iter->second.table;
+    }
+
+    size_t size() const noexcept
+    {
+        std::lock_guard _{mtx_};
+        return tables_.size();
+    }
+
+    void clear() noexcept
+    {
+        std::lock_guard _{mtx_};
+        tables_.clear();
+    }
+};
+
+/**
+ * Apply remap table on image, which is laid out as (rows, cols, channels). Destination pixels
+ *  which sample outside of source are filled with border value.
+ */
+template <typename Px_>
+void remap(ndarray_view<Px_, 3> dst, ndarray_view<std::add_const_t<Px_>, 3> src,
+           remap_table const& table, std::remove_const_t<Px_> border = {}, batch_policy const& exec = {})
+{
+    auto const [height, width, channels] = dst.dims();
+
+    if (height != table.height || width != table.width)
+        throw std::invalid_argument{"destination does not match remap table"};
+    if (src.dims() != dst.dims())
+        throw std::invalid_argument{"source does not match destination"};
+
+    auto const policy = _detail::remap::row_policy(exec, width);
+
+    auto const [s_row, s_col, s_ch] = src.strides();
+    auto const [d_row, d_col, d_ch] = dst.strides();
+
+    run_chunked(policy, height, [&](size_t row_begin, size_t row_end) {
+        for (size_t row = row_begin; row < row_end; ++row) {
+            auto base = row * width;
+            auto x0 = table.x0.data() + base, y0 = table.y0.data() + base;
+            auto wx = table.wx.data() + base, wy = table.wy.data() + base;
+            auto out = dst.data() + row * d_row;
+
+            for (size_t col = 0; col < width; ++col, out += d_col) {
+                if (x0[col] == remap_table::invalid_tap) {
+                    for (size_t c = 0; c < channels; ++c) { out[c * d_ch] = border; }
+                    continue;
+                }
+
+                // Right/bottom taps are clamped, as their weights are zero on last row/column.
+                auto dx = x0[col] + 1 < ptrdiff_t(width) ? s_col : 0;
+                auto dy = y0[col] + 1 < ptrdiff_t(height) ? s_row : 0;
+
+                auto p00 = src.data() + y0[col] * s_row + x0[col] * s_col;
+                auto p01 = p00 + dx, p10 = p00 + dy, p11 = p10 + dx;
+                auto fx = wx[col], fy = wy[col];
+
+                for (size_t c = 0; c < channels; ++c) {
+                    auto ofs = c * s_ch;
+                    auto top = float(p00[ofs]) + (float(p01[ofs]) - float(p00[ofs])) * fx;
+                    auto bottom = float(p10[ofs]) + (float(p11[ofs]) - float(p10[ofs])) * fx;
+                    auto value = top + (bottom - top) * fy;
+
+                    if constexpr (std::is_integral_v<Px_>)
+                        out[c * d_ch] = Px_(std::floor(value + 0.5f));
+                    else
+                        out[c * d_ch] = Px_(value);
+                }
+            }
+        }
+    });
+}
+}  // namespace cpph::math
@@ -0,0 +1,258 @@
+// MIT License
+//
+// Copyright (c) 2021-2022. Seungwoo Kang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// project home: https://github.com/perfkitpp
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Allocation tracking of cpph allocators.
+ *
+ * Define CPPH_ALLOC_TRACKING=1 (or enable CMake option of same name) to let allocators of this
+ *  library report to alloc_registry. Otherwise, every tracking hook compiles to nothing, and
+ *  allocators don't carry tracker. It must be consistent across every translation unit.
+ *
+ * alloc_tracker itself is always available, thus user allocators can be tracked regardless.
+ */
+#ifndef CPPH_ALLOC_TRACKING
+#    define CPPH_ALLOC_TRACKING 0
+#endif
+
+#if CPPH_ALLOC_TRACKING
+#    define CPPH_ALLOC_TRACK(...) (__VA_ARGS__)
+#else
+#    define CPPH_ALLOC_TRACK(...) ((void)0)
+#endif
+
+namespace cpph {
+/**
+ * Snapshot of allocation counters.
+ */
+struct alloc_stats {
+    enum { num_histogram_buckets = 16 };
+
+    std::string name;
+
+    uint64_t bytes_live = 0;
+    uint64_t peak_bytes_live = 0;
+    uint64_t num_live = 0;
+    uint64_t num_allocs = 0;     // Total number of allocations ever made
+    uint64_t num_fallbacks = 0;  // Allocations served by fallback path, e.g. heap
+
+    // Allocation size histogram; bucket i counts sizes in (8 << i, 16 << i]. First bucket
+    //  includes every size under 16 bytes, and last one includes every size above.
+    std::array<uint64_t, num_histogram_buckets> size_histogram = {};
+
+    static size_t histogram_bucket(size_t n) noexcept
+    {
+        size_t bucket = 0;
+        for (n = (n - (n > 0)) >> 4; n && bucket + 1 < num_histogram_buckets; n >>= 1) { ++bucket; }
+        return bucket;
+    }
+};
+
+namespace _detail {
+struct alloc_counters {
+    std::string name;
+
+    std::atomic<uint64_t> bytes_live{0};
+    std::atomic<uint64_t> peak_bytes_live{0};
+    std::atomic<uint64_t> num_live{0};
+    std::atomic<uint64_t> num_allocs{0};
+    std::atomic<uint64_t> num_fallbacks{0};
+    std::array<std::atomic<uint64_t>, alloc_stats::num_histogram_buckets> histogram = {};
+
+    alloc_counters* prev = nullptr;
+    alloc_counters* next = nullptr;
+};
+}  // namespace _detail
+
+/**
+ * Enumerable registry of every living alloc_tracker.
+ */
+class alloc_registry
+{
+    friend class alloc_tracker;
+
+    mutable std::mutex _mtx;
+    _detail::alloc_counters* _head = nullptr;
+
+   public:
+    static alloc_registry& get() noexcept
+    {
+        static alloc_registry instance;
+        return instance;
+    }
+
+    template <typename Fn>
+    void for_each(Fn&& fn) const;
+
+    //! Snapshot of every tracker. If name is not empty, only trackers of that name are returned.
+    std::vector<alloc_stats> snapshot(std::string_view name = {}) const;
+
+    //! Sum of all trackers of given name.
+    alloc_stats total(std::string_view name) const;
+
+   private:
+    void _link(_detail::alloc_counters* c) noexcept
+    {
+        std::lock_guard _{_mtx};
+        c->next = _head;
+        if (_head) { _head->prev = c; }
+        _head = c;
+    }
+
+    void _unlink(_detail::alloc_counters* c) noexcept
+    {
+        std::lock_guard _{_mtx};
+        (c->prev ? c->prev->next : _head) = c->next;
+        if (c->next) { c->next->prev = c->prev; }
+    }
+};
+
+/**
+ * Per-allocator counters, registered to alloc_registry during lifetime.
+ *
+ * Counters live in separate heap block, thus tracker can be relocated freely, even by memcpy.
+ *  All updates are relaxed atomic operations.
+ */
+class alloc_tracker
+{
+    std::unique_ptr<_detail::alloc_counters> _c;
+
+   public:
+    explicit alloc_tracker(std::string_view name = "unnamed")
+            : _c(std::make_unique<_detail::alloc_counters>())
+    {
+        _c->name = name;
+        alloc_registry::get()._link(_c.get());
+    }
+
+    alloc_tracker(alloc_tracker&&) noexcept = default;
+    alloc_tracker& operator=(alloc_tracker&&) noexcept = default;
+
+    ~alloc_tracker() noexcept
+    {
+        if (_c) { alloc_registry::get()._unlink(_c.get()); }
+    }
+
+   public:
+    void on_allocate(size_t n) noexcept
+    {
+        auto live = _c->bytes_live.fetch_add(n, std::memory_order_relaxed) + n;
+        auto peak = _c->peak_bytes_live.load(std::memory_order_relaxed);
+
+        while (peak < live && not _c->peak_bytes_live.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+
+        _c->num_live.fetch_add(1, std::memory_order_relaxed);
+        _c->num_allocs.fetch_add(1, std::memory_order_relaxed);
+        _c->histogram[alloc_stats::histogram_bucket(n)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void on_deallocate(size_t n) noexcept
+    {
+        _c->bytes_live.fetch_sub(n, std::memory_order_relaxed);
+        _c->num_live.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    //! Counts allocation served by fallback path. Call in addition to on_allocate().
+    void on_fallback() noexcept
+    {
+        _c->num_fallbacks.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    alloc_stats snapshot() const { return _snapshot(*_c); }
+
+    //! Must not be called while registry is being enumerated concurrently.
+    void rename(std::string_view name)
+    {
+        std::lock_guard _{alloc_registry::get()._mtx};
+        _c->name = name;
+    }
+
+   private:
+    friend class alloc_registry;
+
+    static alloc_stats _snapshot(_detail::alloc_counters const& c)
+    {
+        alloc_stats s;
+        s.name = c.name;
+        s.bytes_live = c.bytes_live.load(std::memory_order_relaxed);
+        s.peak_bytes_live = c.peak_bytes_live.load(std::memory_order_relaxed);
+        s.num_live = c.num_live.load(std::memory_order_relaxed);
+        s.num_allocs = c.num_allocs.load(std::memory_order_relaxed);
+        s.num_fallbacks = c.num_fallbacks.load(std::memory_order_relaxed);
+
+        for (size_t i = 0; i < s.size_histogram.size(); ++i) {
+            s.size_histogram[i] = c.histogram[i].load(std::memory_order_relaxed);
+        }
+
+        return s;
+    }
+};
+
+template <typename Fn>
+void alloc_registry::for_each(Fn&& fn) const
+{
+    std::lock_guard _{_mtx};
+    for (auto c = _head; c; c = c->next) { fn(alloc_tracker::_snapshot(*c)); }
+}
+
+inline std::vector<alloc_stats> alloc_registry::snapshot(std::string_view name) const
+{
+    std::vector<alloc_stats> result;
+    for_each([&](alloc_stats&& s) {
+        if (name.empty() || s.name == name) { result.push_back(std::move(s)); }
+    });
+
+    return result;
+}
+
+inline alloc_stats alloc_registry::total(std::string_view name) const
+{
+    alloc_stats sum;
+    sum.name = name;
+
+    for_each([&](alloc_stats const& s) {
+        if (s.name != name) { return; }
+
+        sum.bytes_live += s.bytes_live;
+        sum.peak_bytes_live += s.peak_bytes_live;
+        sum.num_live += s.num_live;
+        sum.num_allocs += s.num_allocs;
+        sum.num_fallbacks += s.num_fallbacks;
+
+        for (size_t i = 0; i < s.size_histogram.size(); ++i) { sum.size_histogram[i] += s.size_histogram[i]; }
+    });
+
+    return sum;
+}
+}  // namespace cpph
@@ -0,0 +1,500 @@
+// MIT License
+//
+// Copyright (c) 2021-2022. Seungwoo Kang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// project home: https://github.com/perfkitpp
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cpph/std/vector>
+#include <memory>
+#include <new>
+#include <tuple>
+
+#include "alloc_tracker.hxx"
+#include "cpph/utility/generic.hxx"
+
+//
+
+namespace cpph {
+namespace _detail::cpool {
+struct alignas(std::max_align_t) node_base {
+    class core* owner = nullptr;
+    node_base* next = nullptr;
+    node_base* next_batch = nullptr;  // Only valid for first node of batch in global stack
+    uint32_t batch_size = 0;          // Only valid for first node of batch in global stack
+    bool constructed = false;
+
+    void* data() noexcept { return this + 1; }
+};
+
+struct slab {
+    slab* next = nullptr;
+    size_t count = 0;
+};
+
+/**
+ * Shared state of concurrent pool.
+ *
+ * Reference count holds owner, plus every node which is not in the global stack. Therefore,
+ *  core stays valid as long as any node is checked out or cached by any thread, without
+ *  touching reference count for each checkout.
+ *
+ * Once owner retires, objects returned to the core are destroyed instead of being kept idle.
+ */
+class core
+{
+    std::atomic<node_base*> _global{nullptr};  // Stack of batches
+    std::atomic<slab*> _slabs{nullptr};
+    std::atomic<size_t> _refs{1};
+    std::atomic_bool _retired{false};
+
+    void (*_dtor)(void*) noexcept;
+    size_t _stride;
+    uint32_t _batch;
+    uint64_t _id;
+
+#if CPPH_ALLOC_TRACKING
+    alloc_tracker _tracker{"concurrent_pool"};
+#endif
+
+   public:
+    core(void (*dtor)(void*) noexcept, size_t elem_size, uint32_t batch) noexcept
+            : _dtor(dtor),
+              _stride((sizeof(node_base) + elem_size + alignof(node_base) - 1) / alignof(node_base) * alignof(node_base)),
+              _batch(std::max<uint32_t>(batch, 1)),
+              _id(_next_id())
+    {
+    }
+
+    ~core() noexcept
+    {
+        for (auto s = _slabs.load(std::memory_order_acquire); s;) {
+            for (size_t i = 0; i < s->count; ++i) {
+                auto node = _node_at(s, i);
+                if (node->constructed) { _dtor(node->data()); }
+            }
+
+            CPPH_ALLOC_TRACK(_tracker.on_deallocate(sizeof(node_base) + _stride * s->count));
+            ::operator delete(std::exchange(s, s->next));
+        }
+    }
+
+    core(core const&) = delete;
+    core& operator=(core const&) = delete;
+
+   public:
+    uint64_t id() const noexcept { return _id; }
+    uint32_t batch() const noexcept { return _batch; }
+    bool retired() const noexcept { return _retired.load(std::memory_order_relaxed); }
+
+    //! Takes one batch from global stack, or allocates new slab if it's empty.
+    node_base* acquire_batch(uint32_t* count)
+    {
+        auto head = _pop_batch();
+
+        if (head == nullptr) {
+            head = _allocate_slab();
+            head->batch_size = _batch;
+        }
+
+        *count = head->batch_size;
+        _refs.fetch_add(*count, std::memory_order_relaxed);
+        return head;
+    }
+
+    //! Returns chain of nodes to global stack. Core may be destroyed during call.
+    void release_batch(node_base* head, uint32_t count) noexcept
+    {
+        if (_retired.load(std::memory_order_acquire)) { _destroy_chain(head); }
+
+        head->batch_size = count;
+        head->next_batch = nullptr;
+        _push_chain(head);
+        release(count);
+    }
+
+    void release(size_t n) noexcept
+    {
+        if (_refs.fetch_sub(n, std::memory_order_acq_rel) == n) { delete this; }
+    }
+
+    //! Destroys idle objects in global stack. Memory is retained.
+    void shrink() noexcept
+    {
+        auto head = _global.exchange(nullptr, std::memory_order_acquire);
+        if (head == nullptr) { return; }
+
+        for (auto batch = head; batch; batch = batch->next_batch) { _destroy_chain(batch); }
+        _push_chain(head);
+    }
+
+    //! Called by owner on destruction. Releases owner's reference.
+    void retire() noexcept
+    {
+        _retired.store(true, std::memory_order_release);
+        shrink();
+        release(1);
+    }
+
+   private:
+    void _destroy_chain(node_base* node) noexcept
+    {
+        for (; node; node = node->next) {
+            if (node->constructed) { _dtor(node->data()), node->constructed = false; }
+        }
+    }
+
+    static uint64_t _next_id() noexcept
+    {
+        static std::atomic<uint64_t> gen{0};
+        return ++gen;
+    }
+
+    node_base* _node_at(slab* s, size_t index) const noexcept
+    {
+        auto base = (char*)s + sizeof(node_base);  // Slab header occupies one node header size
+        return (node_base*)(base + _stride * index);
+    }
+
+    node_base* _allocate_slab()
+    {
+        static_assert(sizeof(slab) <= sizeof(node_base));
+
+        auto s = new (::operator new(sizeof(node_base) + _stride * _batch)) slab{nullptr, _batch};
+        CPPH_ALLOC_TRACK(_tracker.on_allocate(sizeof(node_base) + _stride * _batch));
+        node_base* head = nullptr;
+
+        for (auto i = s->count; i-- > 0;) {
+            auto node = new (_node_at(s, i)) node_base{};
+            node->owner = this;
+            node->next = head, head = node;
+        }
+
+        // Push only; no ABA problem here.
+        s->next = _slabs.load(std::memory_order_relaxed);
+        while (not _slabs.compare_exchange_weak(s->next, s, std::memory_order_release, std::memory_order_relaxed)) {}
+
+        return head;
+    }
+
+    node_base* _pop_batch() noexcept
+    {
+        // Popping single batch with CAS is prone to ABA problem. Instead, take whole stack,
+        //  which is safe, and put the rest back.
+        auto head = _global.exchange(nullptr, std::memory_order_acquire);
+        if (head == nullptr) { return nullptr; }
+
+        if (auto rest = std::exchange(head->next_batch, nullptr)) { _push_chain(rest); }
+        return head;
+    }
+
+    void _push_chain(node_base* chain) noexcept
+    {
+        auto tail = chain;
+        while (tail->next_batch) { tail = tail->next_batch; }
+
+        tail->next_batch = _global.load(std::memory_order_relaxed);
+        while (not _global.compare_exchange_weak(tail->next_batch, chain, std::memory_order_release, std::memory_order_relaxed)) {}
+    }
+};
+
+/**
+ * Per-thread cache of idle nodes, for each pool core.
+ *
+ * Entries whose count is zero may refer to destroyed core, thus they must not be dereferenced;
+ *  they are identified by core id, which is unique during process lifetime. Entries of retired
+ *  core are returned on next lookup miss, which destroys cached objects.
+ */
+class thread_cache
+{
+    struct entry {
+        core* owner;
+        uint64_t id;
+        node_base* head;
+        uint32_t count;
+    };
+
+    vector<entry> _entries;
+    size_t _last = 0;
+
+   public:
+    ~thread_cache() noexcept
+    {
+        _dead() = true;
+        for (auto& e : _entries) {
+            if (e.count) { e.owner->release_batch(e.head, e.count); }
+        }
+    }
+
+    static thread_cache* get() noexcept
+    {
+        if (_dead()) { return nullptr; }  // Thread is exiting
+
+        thread_local thread_cache cache;
+        return &cache;
+    }
+
+    node_base* checkout(core* c)
+    {
+        auto& e = _find(c);
+
+        if (e.count == 0) {
+            e.head = c->acquire_batch(&e.count);
+        }
+
+        auto node = e.head;
+        e.head = std::exchange(node->next, nullptr);
+        e.count -= 1;
+        return node;
+    }
+
+    void checkin(node_base* node) noexcept
+    {
+        auto c = node->owner;
+
+        if (c->retired()) {
+            _prune();
+            c->release_batch(node, 1);
+            return;
+        }
+
+        auto& e = _find(c);
+
+        node->next = e.head;
+        e.head = node;
+
+        if (++e.count < 2 * c->batch()) { return; }
+
+        // Return oldest half to global stack.
+        auto tail = e.head;
+        for (uint32_t i = 1; i < c->batch(); ++i) { tail = tail->next; }
+
+        auto chain = std::exchange(tail->next, nullptr);
+        e.count = c->batch();
+        c->release_batch(chain, e.count);
+    }
+
+    //! Returns every cached node of given core to global stack.
+    void flush(core* c) noexcept
+    {
+        auto& e = _find(c);
+        if (e.count == 0) { return; }
+
+        c->release_batch(e.head, e.count);
+        e.head = nullptr, e.count = 0;
+    }
+
+   private:
+    void _prune() noexcept
+    {
+        for (auto& e : _entries) {
+            if (e.count && e.owner->retired()) {
+                e.owner->release_batch(e.head, e.count);
+                e.head = nullptr, e.count = 0;
+            }
+        }
+    }
+
+    static bool& _dead() noexcept
+    {
+        thread_local bool dead = false;
+        return dead;
+    }
+
+    entry& _find(core* c) noexcept
+    {
+        if (_last < _entries.size()) {
+            if (auto& e = _entries[_last]; e.owner == c && e.id == c->id()) { return e; }
+        }
+
+        _prune();
+
+        size_t empty_slot = ~size_t{};
+        for (size_t i = 0; i < _entries.size(); ++i) {
+            auto& e = _entries[i];
+            if (e.owner == c && e.id == c->id()) { return _entries[_last = i]; }
+            if (e.count == 0) { empty_slot = i; }
+        }
+
+        if (empty_slot == ~size_t{}) {
+            empty_slot = _entries.size();
+            _entries.emplace_back();
+        }
+
+        _entries[empty_slot] = {c, c->id(), nullptr, 0};
+        return _entries[_last = empty_slot];
+    }
+};
+
+inline node_base* checkout(core* c)
+{
+    if (auto cache = thread_cache::get()) { return cache->checkout(c); }
+
+    uint32_t count;
+    auto head = c->acquire_batch(&count);
+    if (auto rest = std::exchange(head->next, nullptr)) { c->release_batch(rest, count - 1); }
+
+    return head;
+}
+
+inline void checkin(node_base* node) noexcept
+{
+    assert(node->next == nullptr);
+
+    if (auto cache = thread_cache::get()) {
+        cache->checkin(node);
+    } else {
+        node->owner->release_batch(node, 1);
+    }
+}
+}  // namespace _detail::cpool
+
+/**
+ * Handle of object checked out from concurrent_pool.
+ */
+template <typename T>
+class concurrent_pool_ptr
+{
+    _detail::cpool::node_base* _node = nullptr;
+
+   public:
+    using value_type = T;
+
+   public:
+    concurrent_pool_ptr() noexcept = default;
+    concurrent_pool_ptr(concurrent_pool_ptr&& other) noexcept : _node(std::exchange(other._node, nullptr)) {}
+    concurrent_pool_ptr& operator=(concurrent_pool_ptr&& other) noexcept { return std::swap(_node, other._node), *this; }
+
+    explicit concurrent_pool_ptr(_detail::cpool::node_base* node) noexcept : _node(node) {}
+
+    ~concurrent_pool_ptr() noexcept { checkin(); }
+
+   public:
+    void checkin() noexcept
+    {
+        if (auto node = std::exchange(_node, nullptr)) { _detail::cpool::checkin(node); }
+    }
+
+    T* get() const noexcept { return _node ? (T*)_node->data() : nullptr; }
+
+    bool valid() const noexcept { return _node; }
+    explicit operator bool() const noexcept { return valid(); }
+    T* operator->() const noexcept { return get(); }
+    T& operator*() const noexcept { return *get(); }
+
+    shared_ptr<T> share() &&
+    {
+        if (not _node)
+            return nullptr;
+
+        auto data = get();
+        return shared_ptr<T>{data, [disposer = std::move(*this)](auto) {}};
+    }
+};
+
+/**
+ * Object pool for heavily multi-threaded checkout/checkin.
+ *
+ * Compared to pool, each thread caches idle objects, and exchanges them with global lock-free
+ *  stack in batches. Objects are allocated in slabs of batch size. Returning object doesn't
+ *  touch any atomic variable, unless the thread's cache overflows.
+ *
+ * Objects are constructed on first checkout with pool's parameters, and reused thereafter.
+ *  Memory is retained until both the pool and every checked out object are destroyed. On
+ *  pool destruction, idle objects are destroyed, except for ones cached by other threads, which
+ *  are destroyed on those threads' next pool access or exit. Objects checked in after pool
+ *  destruction are destroyed immediately.
+ */
+template <typename T, typename... Params>
+class concurrent_pool : public tuple<Params...>
+{
+    static_assert(alignof(T) <= alignof(_detail::cpool::node_base));
+
+    _detail::cpool::core* _core = new _detail::cpool::core(&concurrent_pool::_dtor, sizeof(T), default_batch_size);
+
+   public:
+    enum : uint32_t { default_batch_size = 32 };
+    using handle_type = concurrent_pool_ptr<T>;
+
+   public:
+    concurrent_pool() = default;
+    concurrent_pool(concurrent_pool&& other) noexcept : tuple<Params...>(std::move(other)), _core(std::exchange(other._core, nullptr)) {}
+    concurrent_pool& operator=(concurrent_pool&& other) noexcept
+    {
+        tuple<Params...>::operator=(std::move(other));
+        std::swap(_core, other._core);
+        return *this;
+    }
+
+    using tuple<Params...>::tuple;
+
+    ~concurrent_pool() noexcept
+    {
+        if (_core == nullptr) { return; }
+        if (auto cache = _detail::cpool::thread_cache::get()) { cache->flush(_core); }
+
+        _core->retire();
+    }
+
+   private:
+    static void _dtor(void* p) noexcept
+    {
+        reinterpret_cast<T*>(p)->~T();
+    }
+
+   public:
+    handle_type checkout()
+    {
+        auto node = _detail::cpool::checkout(_core);
+
+        if (not node->constructed) {
+            try {
+                std::apply([&](auto&&... params) { new (node->data()) T{params...}; },
+                           static_cast<tuple<Params...>&>(*this));
+            } catch (...) {
+                _detail::cpool::checkin(node);
+                throw;
+            }
+
+            node->constructed = true;
+        }
+
+        return handle_type{node};
+    }
+
+    void checkin(handle_type h) noexcept
+    {
+        h.checkin();
+    }
+
+    //! Destroys idle objects which are not cached by other threads.
+    void shrink() noexcept
+    {
+        if (auto cache = _detail::cpool::thread_cache::get()) { cache->flush(_core); }
+        _core->shrink();
+    }
+};
+}  // namespace cpph
@@ -0,0 +1,346 @@
+// MIT License
+//
+// Copyright (c) 2021-2022. Seungwoo Kang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// project home: https://github.com/perfkitpp
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+namespace cpph {
+/**
+ * Huge page usage of page allocation
+ */
+enum class huge_page_mode : uint8_t {
+    none,         // Regular pages
+    transparent,  // Align to huge page boundary, and advise kernel to use transparent huge pages.
+    hugetlb,      // Explicit hugetlb pages, falls back to transparent if pool is exhausted.
+};
+
+enum : int {
+    numa_node_any = -1
+};
+
+/**
+ * Allocation policy of large buffers.
+ */
+struct page_policy {
+    huge_page_mode huge_pages = huge_page_mode::none;
+
+    // Preferred NUMA node of allocated pages. If numa_node_any, pages are placed on the node
+    //  which touches them first.
+    int numa_node = numa_node_any;
+
+    // 0: pages are faulted lazily. 1: prefault on calling thread. Otherwise, prefault in
+    //  parallel with given number of threads, which spreads pages across nodes of the threads.
+    size_t first_touch_threads = 0;
+
+    //! Prefers NUMA node of calling thread, e.g. for buffers owned by a worker thread.
+    static page_policy this_node(huge_page_mode huge = huge_page_mode::transparent) noexcept;
+
+    bool operator==(page_policy const& o) const noexcept
+    {
+        return huge_pages == o.huge_pages && numa_node == o.numa_node && first_touch_threads == o.first_touch_threads;
+    }
+
+    bool operator!=(page_policy const& o) const noexcept { return not(*this == o); }
+};
+
+namespace _detail::pages {
+enum : size_t {
+    small_page_size = 4 << 10,
+    huge_page_size = 2 << 20,
+};
+
+inline size_t round_up(size_t n, size_t align) noexcept { return (n + align - 1) / align * align; }
+
+#if defined(__linux__)
+inline void bind_node(void* p, size_t n, int node) noexcept
+{
+    enum { mpol_preferred = 1 };
+
+    if (node < 0 || node >= int(sizeof(unsigned long) * 8)) { return; }
+    unsigned long mask = 1ul << node;
+
+    // Failure is not fatal; pages just fall back to default policy.
+    syscall(SYS_mbind, p, n, mpol_preferred, &mask, sizeof mask * 8, 0);
+}
+
+inline void* map_huge_aligned(size_t n) noexcept
+{
+    // Over-allocate to align mapping on huge page boundary, then trim both ends.
+    auto raw = mmap(nullptr, n + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) { return nullptr; }
+
+    auto begin = (char*)raw;
+    auto aligned = (char*)round_up((uintptr_t)raw, huge_page_size);
+    auto end = begin + n + huge_page_size;
+
+    if (aligned != begin) { munmap(begin, aligned - begin); }
+    if (aligned + n != end) { munmap(aligned + n, end - (aligned + n)); }
+
+#    ifdef MADV_HUGEPAGE
+    madvise(aligned, n, MADV_HUGEPAGE);
+#    endif
+    return aligned;
+}
+#endif
+
+inline void touch(char* begin, char* end) noexcept
+{
+    for (auto p = begin; p < end; p += small_page_size) { *(volatile char*)p = 0; }
+}
+}  // namespace _detail::pages
+
+//! NUMA node of calling thread, or numa_node_any if unknown.
+inline int current_numa_node() noexcept
+{
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) { return int(node); }
+#endif
+    return numa_node_any;
+}
+
+inline page_policy page_policy::this_node(huge_page_mode huge) noexcept
+{
+    page_policy policy;
+    policy.huge_pages = huge;
+    policy.numa_node = current_numa_node();
+    return policy;
+}
+
+//! Actual number of bytes mapped for allocation of n bytes with given policy.
+inline size_t page_mapping_size(size_t n, page_policy const& policy) noexcept
+{
+    using namespace _detail::pages;
+    return round_up(std::max<size_t>(n, 1), policy.huge_pages == huge_page_mode::none ? small_page_size : huge_page_size);
+}
+
+/**
+ * Touches every page of given range, to fault them in from given number of threads.
+ */
+inline void first_touch(void* p, size_t n, size_t num_threads = 1)
+{
+    using namespace _detail::pages;
+    auto begin = (char*)p, end = begin + n;
+
+    if (num_threads <= 1 || n < num_threads * huge_page_size) {
+        touch(begin, end);
+        return;
+    }
+
+    // Each thread touches contiguous huge page aligned chunk
+    auto chunk = round_up(n / num_threads, huge_page_size);
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+
+    for (auto it = begin; it < end; it += chunk) {
+        threads.emplace_back([it, last = std::min(it + chunk, end)] { touch(it, last); });
+    }
+
+    for (auto& th : threads) { th.join(); }
+}
+
+/**
+ * Allocates page-aligned memory with given policy. Returned memory is zero-filled.
+ *
+ * Huge page and NUMA requests degrade gracefully to regular pages when they are unavailable.
+ *  Memory must be returned via deallocate_pages() with same size and policy.
+ */
+inline void* allocate_pages(size_t n, page_policy const& policy = {})
+{
+    using namespace _detail::pages;
+    auto len = page_mapping_size(n, policy);
+    void* mem = nullptr;
+
+#if defined(__linux__)
+#    ifdef MAP_HUGETLB
+    if (policy.huge_pages == huge_page_mode::hugetlb) {
+        mem = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (mem == MAP_FAILED) { mem = nullptr; }
+    }
+#    endif
+
+    if (mem == nullptr && policy.huge_pages != huge_page_mode::none) {
+        mem = map_huge_aligned(len);
+    }
+
+    if (mem == nullptr) {
+        mem = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) { throw std::bad_alloc{}; }
+    }
+
+    if (policy.numa_node != numa_node_any) { bind_node(mem, len, policy.numa_node); }
+#else
+    auto align = policy.huge_pages == huge_page_mode::none ? small_page_size : huge_page_size;
+    mem = ::operator new(len, std::align_val_t{align});
+    memset(mem, 0, len);
+#endif
+
+    if (policy.first_touch_threads) { first_touch(mem, len, policy.first_touch_threads); }
+    return mem;
+}
+
+inline void deallocate_pages(void* p, size_t n, page_policy const& policy = {}) noexcept
+{
+    if (p == nullptr) { return; }
+
+#if defined(__linux__)
+    munmap(p, page_mapping_size(n, policy));
+#else
+    using namespace _detail::pages;
+    auto align = policy.huge_pages == huge_page_mode::none ? small_page_size : huge_page_size;
+    ::operator delete(p, std::align_val_t{align});
+#endif
+}
+
+//! Size of mirrored mapping for n bytes; rounded up to system page size.
+inline size_t mirrored_mapping_size(size_t n) noexcept
+{
+    using namespace _detail::pages;
+
+#if defined(__linux__)
+    static size_t const page_size = size_t(sysconf(_SC_PAGESIZE));
+#else
+    size_t const page_size = small_page_size;
+#endif
+    return round_up(std::max<size_t>(n, 1), page_size);
+}
+
+/**
+ * Maps same mirrored_mapping_size(n) bytes of memory twice, back to back, thus p[i] and
+ *  p[i + mirrored_mapping_size(n)] refer to same byte. Ring buffers placed on this memory can
+ *  access any range across the wrap-around point as single contiguous span.
+ *
+ * Returns null if platform doesn't support it. Memory must be returned via
+ *  deallocate_mirrored_pages() with same size.
+ */
+inline void* allocate_mirrored_pages(size_t n) noexcept
+{
+#if defined(__linux__) && defined(SYS_memfd_create)
+    auto len = mirrored_mapping_size(n);
+
+    int fd = int(syscall(SYS_memfd_create, "cpph-mirror", 0));
+    if (fd < 0) { return nullptr; }
+
+    void* result = nullptr;
+
+    // Reserve contiguous address space first, then replace both halves with shared mapping.
+    if (ftruncate(fd, off_t(len)) == 0) {
+        auto base = (char*)mmap(nullptr, len * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (base != MAP_FAILED) {
+            auto lo = mmap(base, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+            auto hi = mmap(base + len, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+
+            if (lo != MAP_FAILED && hi != MAP_FAILED)
+                result = base;
+            else
+                munmap(base, len * 2);
+        }
+    }
+
+    close(fd);  // Mappings hold reference to the file
+    return result;
+#else
+    (void)n;
+    return nullptr;
+#endif
+}
+
+inline void deallocate_mirrored_pages(void* p, size_t n) noexcept
+{
+#if defined(__linux__)
+    if (p) { munmap(p, mirrored_mapping_size(n) * 2); }
+#else
+    (void)p, (void)n;
+#endif
+}
+
+/**
+ * STL allocator, which allocates large arrays with page policy.
+ *
+ * Allocations smaller than page_threshold are forwarded to std::allocator.
+ */
+template <typename T>
+class page_allocator
+{
+    template <typename>
+    friend class page_allocator;
+
+    page_policy _policy;
+
+   public:
+    using value_type = T;
+    enum : size_t { page_threshold = 256 << 10 };
+
+   public:
+    page_allocator() noexcept = default;
+    explicit page_allocator(page_policy const& policy) noexcept : _policy(policy) {}
+
+    template <typename U>
+    page_allocator(page_allocator<U> const& other) noexcept : _policy(other._policy) {}
+
+    T* allocate(size_t n)
+    {
+        auto nbytes = n * sizeof(T);
+
+        if (nbytes < page_threshold) {
+            return std::allocator<T>{}.allocate(n);
+        } else {
+            return (T*)allocate_pages(nbytes, _policy);
+        }
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        auto nbytes = n * sizeof(T);
+
+        if (nbytes < page_threshold) {
+            std::allocator<T>{}.deallocate(p, n);
+        } else {
+            deallocate_pages(p, nbytes, _policy);
+        }
+    }
+
+    page_policy const& policy() const noexcept { return _policy; }
+
+    template <typename U>
+    bool operator==(page_allocator<U> const& o) const noexcept { return _policy == o._policy; }
+
+    template <typename U>
+    bool operator!=(page_allocator<U> const& o) const noexcept { return _policy != o._policy; }
+};
+}  // namespace cpph
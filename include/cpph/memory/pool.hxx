@@ -25,6 +25,7 @@
 #pragma once
 #include <memory>
 
+#include "alloc_tracker.hxx"
 #include "cpph/thread/spinlock.hxx"
 #include "cpph/utility/generic.hxx"
 
@@ -101,6 +102,11 @@ class pool_base : public std::enable_shared_from_this<pool_base>
     ptr<if_pool_mutex> _mtx;
     void (*_dtor)(void*) noexcept;
 
+#if CPPH_ALLOC_TRACKING
+    alloc_tracker _tracker{"pool"};
+    size_t _node_bytes = 0;
+#endif
+
    public:
     pool_base(ptr<if_pool_mutex> mtx, decltype(_dtor) dtor) noexcept : _mtx(move(mtx)), _dtor(dtor)
     {
@@ -145,6 +151,8 @@ class pool_base : public std::enable_shared_from_this<pool_base>
         }
 
         node->owner = weak_from_this();
+
+        CPPH_ALLOC_TRACK(_node_bytes = sizeof(pool_node_base) + sizeof(T), _tracker.on_allocate(_node_bytes));
         return node;
     }
 
@@ -174,6 +182,8 @@ class pool_base : public std::enable_shared_from_this<pool_base>
 
             _dtor(node->data());
             pool_node_base::erase_memory(node);
+
+            CPPH_ALLOC_TRACK(_tracker.on_deallocate(_node_bytes));
         }
     }
 };
@@ -1,7 +1,38 @@
+// MIT License
+//
+// Copyright (c) 2021-2022. Seungwoo Kang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// project home: https://github.com/perfkitpp
+
 #pragma once
+#include <algorithm>
+#include <cassert>
 #include <cpph/std/list>
 #include <cpph/std/vector>
+#include <cstddef>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <functional>
+#include <utility>
 
 #include "cpph/thread/threading.hxx"
 #include "cpph/utility/generic.hxx"
@@ -10,51 +41,224 @@
 namespace cpph {
 namespace _detail {
 struct queue_allocator_node {
-    uint64_t occupied       : 1;
-    uint64_t section_offset : 31;
-    uint64_t block_count    : 32;
-    char data[];
+    uint64_t occupied      : 1;
+    uint64_t section_index : 31;
+    uint64_t block_count   : 32;
 };
 
 constexpr size_t queue_alloc_block_size = 16;
 static_assert(sizeof(queue_allocator_node) <= queue_alloc_block_size);
 }  // namespace _detail
 
+/**
+ * FIFO allocator, which bumps allocations through sequence of fixed size sections.
+ *
+ * Each section counts its live allocations. A section which is no longer being filled is
+ *  recycled as soon as every allocation from it is freed, thus memory is reclaimed quickly
+ *  when allocations are freed in roughly allocation order, e.g. message buffers of
+ *  producer/consumer pipeline. Unlike ring_allocator, it grows by adding sections instead of
+ *  falling back to heap when full.
+ *
+ * Allocations are aligned to 16 bytes. Every allocation must be freed before allocator is
+ *  destroyed.
+ */
 template <class Mutex = null_mutex>
-class queue_allocator : std::enable_shared_from_this<queue_allocator<Mutex>>
+class queue_allocator
 {
-    using section_buffer_pool_type = vector<pair<ptr<char>, size_t>>;
     using node_type = _detail::queue_allocator_node;
+    enum : size_t { block_size = _detail::queue_alloc_block_size };
+
+    struct section_t {
+        ptr<char[]> memory;
+        size_t num_blocks = 0;  // Capacity
+        size_t head = 0;        // Number of blocks bumped
+        size_t num_alive = 0;   // Number of live allocations
+    };
 
    public:
     using mutex_type = Mutex;
 
    private:
-    mutex_type mt_;
-    section_buffer_pool_type pool_;
+    mutable mutex_type mt_;
+    vector<section_t> pool_;
     vector<int> idle_pool_idxs_;  // List of available pools.
-
-    node_type* first_;
-    node_type* last_;
+    int current_ = -1;            // Section being filled
 
     size_t section_size_;
 
    public:
-    explicit queue_allocator(size_t default_section_size) noexcept : section_size_(default_section_size) {}
+    explicit queue_allocator(size_t default_section_size) noexcept
+            : section_size_(std::max<size_t>(_num_blocks(default_section_size), 2) * block_size) {}
+
+    queue_allocator(queue_allocator const&) = delete;
+    queue_allocator& operator=(queue_allocator const&) = delete;
+
+    ~queue_allocator() noexcept
+    {
+        assert(num_allocations() == 0 && "Every allocation must be freed before destruction!");
+    }
 
    public:
     template <typename T>
     struct dtor_adaptor {
         using pointer = T*;
-        sptr<queue_allocator<T>> d;
-        void operator()(T* ptr) noexcept {}
+        queue_allocator* d = nullptr;
+
+        void operator()(T* ptr) noexcept
+        {
+            ptr->~T();
+            d->deallocate(ptr);
+        }
     };
 
     template <typename T>
     using pointer_type = unique_ptr<T, dtor_adaptor<T>>;
 
    public:
+    /**
+     * Allocates n bytes. Allocation larger than section gets dedicated section, which is freed
+     *  instead of being recycled.
+     */
+    void* allocate(size_t n)
+    {
+        std::lock_guard _{mt_};
+        auto nblk = _num_blocks(n) + 1;  // Including header
+
+        if (current_ < 0 || pool_[current_].num_blocks - pool_[current_].head < nblk) {
+            _retire_current();
+            current_ = _acquire_section(nblk);
+        }
+
+        auto& sect = pool_[current_];
+        auto node = (node_type*)(sect.memory.get() + sect.head * block_size);
+        node->occupied = 1;
+        node->section_index = uint32_t(current_);
+        node->block_count = uint32_t(nblk);
+
+        sect.head += nblk;
+        sect.num_alive += 1;
+        return (char*)node + block_size;
+    }
+
+    void deallocate(void* p) noexcept
+    {
+        std::lock_guard _{mt_};
+        auto node = (node_type*)((char*)p - block_size);
+        assert(node->occupied);
+        node->occupied = 0;
+
+        auto index = int(node->section_index);
+        auto& sect = pool_[index];
+        assert(sect.num_alive > 0);
+
+        if (--sect.num_alive > 0) { return; }
+
+        if (index == current_) {
+            sect.head = 0;  // Rewind in place
+        } else {
+            _recycle(index);
+        }
+    }
+
     template <class T, class... Args>
-    auto construct() -> pointer_type<T>;
+    auto construct(Args&&... args) -> pointer_type<T>
+    {
+        static_assert(alignof(T) <= block_size);
+
+        auto mem = allocate(sizeof(T));
+        try {
+            return pointer_type<T>{new (mem) T(std::forward<Args>(args)...), dtor_adaptor<T>{this}};
+        } catch (...) {
+            deallocate(mem);
+            throw;
+        }
+    }
+
+    //! Number of live allocations
+    size_t num_allocations() const noexcept
+    {
+        std::lock_guard _{mt_};
+        size_t n = 0;
+        for (auto& s : pool_) { n += s.num_alive; }
+        return n;
+    }
+
+    //! Number of sections, including idle ones.
+    size_t num_sections() const noexcept
+    {
+        std::lock_guard _{mt_};
+        size_t n = 0;
+        for (auto& s : pool_) { n += s.memory != nullptr; }
+        return n;
+    }
+
+    size_t section_size() const noexcept { return section_size_; }
+
+    /**
+     * Frees idle sections. As live allocations refer their section by index, only trailing
+     *  slots are removed; freed slots in between stay idle, and are refilled first.
+     */
+    void shrink_to_fit() noexcept
+    {
+        std::lock_guard _{mt_};
+        for (auto idx : idle_pool_idxs_) { pool_[idx] = {}; }
+
+        while (not pool_.empty() && not pool_.back().memory && int(pool_.size()) - 1 != current_)
+            pool_.pop_back();
+
+        auto num_slots = int(pool_.size());
+        idle_pool_idxs_.erase(std::remove_if(idle_pool_idxs_.begin(), idle_pool_idxs_.end(),
+                                             [&](int idx) { return idx >= num_slots; }),
+                              idle_pool_idxs_.end());
+    }
+
+   private:
+    static size_t _num_blocks(size_t n) noexcept { return (n + block_size - 1) / block_size; }
+
+    //! Stop filling current section. It is recycled right away if nothing is alive in it.
+    void _retire_current() noexcept
+    {
+        if (current_ < 0) { return; }
+        if (pool_[current_].num_alive == 0) { _recycle(current_); }
+        current_ = -1;
+    }
+
+    void _recycle(int index) noexcept
+    {
+        auto& sect = pool_[index];
+        sect.head = 0;
+
+        if (sect.num_blocks * block_size != section_size_) {
+            sect = {};  // Dedicated section of large allocation; slot is reused later.
+        }
+
+        idle_pool_idxs_.push_back(index);
+    }
+
+    int _acquire_section(size_t nblk)
+    {
+        auto num_blocks = std::max(nblk, section_size_ / block_size);
+
+        // Reuse idle section if it's fit, otherwise take empty slot.
+        for (size_t i = idle_pool_idxs_.size(); i-- > 0;) {
+            auto idx = idle_pool_idxs_[i];
+            auto& sect = pool_[idx];
+
+            if (sect.memory && sect.num_blocks < num_blocks) { continue; }
+            idle_pool_idxs_.erase(idle_pool_idxs_.begin() + i);
+
+            if (not sect.memory) {
+                sect.memory.reset(new char[num_blocks * block_size]);
+                sect.num_blocks = num_blocks;
+            }
+
+            return idx;
+        }
+
+        auto& sect = pool_.emplace_back();
+        sect.memory.reset(new char[num_blocks * block_size]);
+        sect.num_blocks = num_blocks;
+        return int(pool_.size() - 1);
+    }
 };
 }  // namespace cpph
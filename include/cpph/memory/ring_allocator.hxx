@@ -69,12 +69,17 @@
  * \endcode
  */
 #pragma once
+#include <algorithm>
 #include <cassert>
+#include <cpph/std/optional>
+#include <cpph/std/vector>
 #include <cstring>
 #include <memory>
 #include <stdexcept>
 
+#include "alloc_tracker.hxx"
 #include "cpph/utility/generic.hxx"
+#include "page_allocator.hxx"
 
 //
 namespace cpph {
@@ -143,6 +148,10 @@ class basic_ring_allocator : private _detail::ring_fallback_allocator<FallbackAl
     void (*_dealloc)(void*, void*) = {};
     void* _user = {};
 
+#if CPPH_ALLOC_TRACKING
+    alloc_tracker _tracker{"ring_allocator"};
+#endif
+
    public:
     explicit basic_ring_allocator(void* buffer, size_t size, void (*dealloc)(void*, void*), void* user) noexcept
             : _memory((node_t*)buffer),
@@ -170,6 +179,23 @@ class basic_ring_allocator : private _detail::ring_fallback_allocator<FallbackAl
     {
     }
 
+    /**
+     * Allocates ring buffer with given page policy. Capacity is rounded up to page size.
+     *
+     * Buffer is not touched here, thus first touch policy of given policy is respected.
+     */
+    basic_ring_allocator(size_t size, page_policy const& policy)
+            : _memory((node_t*)allocate_pages(size, policy)),
+              _capacity(_node_size_floor(page_mapping_size(size, policy))),
+              _user((void*)page_mapping_size(size, policy))
+    {
+        if (policy.huge_pages == huge_page_mode::none) {
+            _dealloc = [](void* p, void* len) { deallocate_pages(p, (size_t)len); };
+        } else {
+            _dealloc = [](void* p, void* len) { deallocate_pages(p, (size_t)len, {huge_page_mode::transparent}); };
+        }
+    }
+
     basic_ring_allocator() noexcept
             : _dealloc([](auto, auto) {})
     {
@@ -177,7 +203,7 @@ class basic_ring_allocator : private _detail::ring_fallback_allocator<FallbackAl
 
     ~basic_ring_allocator() noexcept
     {
-        _dealloc(_memory, _user);
+        if (_dealloc) { _dealloc(_memory, _user); }
     }
 
    public:
@@ -221,10 +247,13 @@ class basic_ring_allocator : private _detail::ring_fallback_allocator<FallbackAl
                     node->fallback_allocated = true;
                     node->pending_kill = false;
                     node->extent = n;
+
+                    CPPH_ALLOC_TRACK(_tracker.on_fallback());
                 }
             }
         }
 
+        if (vp) { CPPH_ALLOC_TRACK(_tracker.on_allocate(extent(vp) + node_size)); }
         return vp;
     }
 
@@ -235,6 +264,8 @@ class basic_ring_allocator : private _detail::ring_fallback_allocator<FallbackAl
 
     void deallocate(void* vp) noexcept
     {
+        CPPH_ALLOC_TRACK(_tracker.on_deallocate(extent(vp) + node_size));
+
         if constexpr (has_fallback_allocator) {
             if (is_ring_allocated(vp)) {
                 _deallocate_ring(vp);
@@ -273,6 +304,17 @@ class basic_ring_allocator : private _detail::ring_fallback_allocator<FallbackAl
         }
     }
 
+#if CPPH_ALLOC_TRACKING
+    alloc_tracker& tracker() noexcept { return _tracker; }
+#endif
+
+    //! Checks if given allocation is placed in ring buffer memory.
+    bool contains(void const* p) const noexcept
+    {
+        auto node = (node_t const*)p - 1;
+        return _memory <= node && node < _memory + _capacity;
+    }
+
     static size_t extent(void* memory) noexcept
     {
         return _retr_node(memory)->extent * node_size;
@@ -388,4 +430,211 @@ class basic_ring_allocator : private _detail::ring_fallback_allocator<FallbackAl
 
 using ring_allocator = basic_ring_allocator<>;
 using ring_allocator_with_fb = basic_ring_allocator<std::allocator<char>>;
+
+/**
+ * Ring allocator which grows by chaining extra segments when full.
+ *
+ * Allocations are always made from the newest segment. When it is full, a new segment of
+ *  twice the capacity is chained, and older segments are only drained; each of them is retired
+ *  as soon as its last allocation is freed. Thus a queue can start small, and adapt to bursts.
+ *
+ * If maximum capacity is reached, allocate_nt() returns null.
+ */
+class growable_ring_allocator
+{
+   public:
+    struct statistics {
+        size_t bytes_in_use = 0;       // Including node headers
+        size_t peak_bytes_in_use = 0;  // High-water mark of bytes_in_use
+        size_t capacity = 0;           // Sum of segment capacities
+        size_t peak_capacity = 0;      // High-water mark of capacity
+        size_t num_segments = 0;
+        size_t peak_num_segments = 0;
+        size_t num_grows = 0;  // Number of segments chained after construction
+    };
+
+   private:
+    vector<ring_allocator> _segments;  // Oldest first; allocation is made from back.
+    size_t _initial_capacity;
+    size_t _max_capacity;
+    statistics _stat;
+
+    optional<page_policy> _policy;
+
+#if CPPH_ALLOC_TRACKING
+    alloc_tracker _tracker{"growable_ring_allocator"};
+#endif
+
+   public:
+    /**
+     * @param initial_capacity Capacity of the first segment
+     * @param max_capacity Upper bound of sum of segment capacities
+     */
+    explicit growable_ring_allocator(size_t initial_capacity, size_t max_capacity = ~size_t{})
+            : _initial_capacity(initial_capacity),
+              _max_capacity(std::max(initial_capacity, max_capacity))
+    {
+        _add_segment(initial_capacity);
+    }
+
+    /**
+     * Segments are allocated with given page policy.
+     */
+    growable_ring_allocator(size_t initial_capacity, size_t max_capacity, page_policy const& policy)
+            : _initial_capacity(initial_capacity),
+              _max_capacity(std::max(initial_capacity, max_capacity)),
+              _policy(policy)
+    {
+        _add_segment(initial_capacity);
+    }
+
+   public:
+    void* allocate(size_t n)
+    {
+        if (auto ptr = allocate_nt(n)) {
+            return ptr;
+        } else {
+            throw std::bad_alloc{};
+        }
+    }
+
+    void* allocate_nt(size_t n) noexcept
+    {
+        auto ptr = _segments.back().allocate_nt(n);
+
+        if (ptr == nullptr) {
+            // Allocation requires at least two more nodes than payload; one for header, and one
+            //  for gap between head and tail.
+            auto required = (n + 3 * ring_allocator::node_size - 1) / ring_allocator::node_size * ring_allocator::node_size;
+            auto capacity = std::max(_segments.back().capacity() * 2, required);
+            auto available = _max_capacity - _stat.capacity;
+
+            // Empty segment is too small; as nothing will be freed to it, replace it.
+            auto replaced = _segments.back().empty();
+            if (replaced) { available += _segments.back().capacity(); }
+
+            capacity = std::min(capacity, available);
+            if (capacity < required) { return nullptr; }
+            if (not _add_segment_nt(capacity)) { return nullptr; }
+
+            if (replaced) {
+                auto iter = _segments.end() - 2;
+                _stat.capacity -= iter->capacity();
+                _segments.erase(iter);
+                _stat.num_segments = _segments.size();
+            }
+
+            _stat.num_grows += 1;
+            ptr = _segments.back().allocate_nt(n);
+            assert(ptr);
+        }
+
+        _stat.bytes_in_use += ring_allocator::extent(ptr) + ring_allocator::node_size;
+        CPPH_ALLOC_TRACK(_tracker.on_allocate(ring_allocator::extent(ptr) + ring_allocator::node_size));
+        _stat.peak_bytes_in_use = std::max(_stat.peak_bytes_in_use, _stat.bytes_in_use);
+        return ptr;
+    }
+
+    void* allocate(size_t n, std::nothrow_t) noexcept
+    {
+        return allocate_nt(n);
+    }
+
+    void deallocate(void* p) noexcept
+    {
+        _stat.bytes_in_use -= ring_allocator::extent(p) + ring_allocator::node_size;
+        CPPH_ALLOC_TRACK(_tracker.on_deallocate(ring_allocator::extent(p) + ring_allocator::node_size));
+
+        // In FIFO usage, allocation usually belongs to the oldest segment.
+        auto iter = std::find_if(_segments.begin(), _segments.end(), [&](auto& s) { return s.contains(p); });
+        assert(iter != _segments.end() && "Allocation is not from this allocator!");
+
+        iter->deallocate(p);
+
+        if (iter->empty() && iter + 1 != _segments.end()) {
+            // Retire drained segment
+            _stat.capacity -= iter->capacity();
+            _segments.erase(iter);
+            _stat.num_segments = _segments.size();
+        }
+    }
+
+    bool empty() const noexcept
+    {
+        return _segments.size() == 1 && _segments.back().empty();
+    }
+
+    size_t capacity() const noexcept { return _stat.capacity; }
+    size_t max_capacity() const noexcept { return _max_capacity; }
+    size_t num_segments() const noexcept { return _segments.size(); }
+
+    statistics const& stats() const noexcept { return _stat; }
+
+#if CPPH_ALLOC_TRACKING
+    alloc_tracker& tracker() noexcept { return _tracker; }
+#endif
+
+    //! Resets high-water marks to current values.
+    void reset_peak() noexcept
+    {
+        _stat.peak_bytes_in_use = _stat.bytes_in_use;
+        _stat.peak_capacity = _stat.capacity;
+        _stat.peak_num_segments = _stat.num_segments;
+    }
+
+    /**
+     * If allocator is empty, replaces grown segment with one of initial capacity.
+     */
+    void shrink_to_fit()
+    {
+        if (not empty() || _segments.back().capacity() <= _initial_capacity) { return; }
+
+        _stat.capacity = 0;
+        _segments.clear();
+        _add_segment(_initial_capacity);
+    }
+
+   private:
+    bool _add_segment_nt(size_t capacity) noexcept
+    {
+        try {
+            _add_segment(capacity);
+            return true;
+        } catch (std::bad_alloc&) {
+            return false;
+        }
+    }
+
+    void _add_segment(size_t capacity)
+    {
+        if (_policy) {
+            _segments.reserve(_segments.size() + 1);
+            _segments.emplace_back(capacity, *_policy);
+            _on_segment_added();
+            return;
+        }
+
+        auto mem = malloc(capacity);
+        if (mem == nullptr) { throw std::bad_alloc{}; }
+
+        // Reserve before construction, to prevent leak on failure.
+        try {
+            _segments.reserve(_segments.size() + 1);
+        } catch (...) {
+            free(mem);
+            throw;
+        }
+
+        _segments.emplace_back(mem, capacity, [](void* p) { free(p); });
+        _on_segment_added();
+    }
+
+    void _on_segment_added() noexcept
+    {
+        _stat.capacity += _segments.back().capacity();
+        _stat.num_segments = _segments.size();
+        _stat.peak_capacity = std::max(_stat.peak_capacity, _stat.capacity);
+        _stat.peak_num_segments = std::max(_stat.peak_num_segments, _stat.num_segments);
+    }
+};
 }  // namespace cpph
\ No newline at end of file
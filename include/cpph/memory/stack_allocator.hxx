@@ -21,3 +21,295 @@
 // SOFTWARE.
 //
 // project home: https://github.com/perfkitpp
+
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#if __has_include(<memory_resource>)
+#    include <memory_resource>
+#    if __cpp_lib_memory_resource >= 201603L
+#        define INTERNAL_CPPH_STACK_ALLOC_PMR 1
+#    endif
+#endif
+
+namespace cpph {
+namespace _detail {
+struct stack_alloc_block {
+    stack_alloc_block* next;
+    size_t capacity;  // Bytes available after header
+    bool owning;
+
+    char* data() noexcept { return (char*)this + header_size(); }
+    char* end() noexcept { return data() + capacity; }
+
+    static constexpr size_t header_size() noexcept
+    {
+        constexpr auto align = alignof(std::max_align_t);
+        return (sizeof(stack_alloc_block) + align - 1) / align * align;
+    }
+};
+}  // namespace _detail
+
+/**
+ * Monotonic bump allocator.
+ *
+ * Allocation is a pointer bump in current block. When current block is exhausted, next block
+ *  in chain is reused if it fits, otherwise new block is allocated from heap and linked. Memory
+ *  is never returned individually, except the most recent allocation; instead, whole allocator
+ *  is rewound to a marker, or reset, in O(1). Blocks are retained for reuse until release().
+ *
+ * \code
+ *   stack_allocator<4096> scratch;
+ *
+ *   for (auto& request : requests) {
+ *       auto _ = scratch.scope();  // Everything allocated below is freed at scope exit
+ *       std::vector<int, stack_stl_allocator<int>> temp{scratch.stl<int>()};
+ *       ...
+ *   }
+ * \endcode
+ *
+ * Not thread-safe.
+ */
+class basic_stack_allocator
+#if INTERNAL_CPPH_STACK_ALLOC_PMR
+        : public std::pmr::memory_resource
+#endif
+{
+    using block_t = _detail::stack_alloc_block;
+
+   public:
+    struct marker {
+        block_t* block = nullptr;
+        char* head = nullptr;
+    };
+
+    class scope_guard
+    {
+        basic_stack_allocator* _owner;
+        marker _mark;
+
+       public:
+        explicit scope_guard(basic_stack_allocator* owner) noexcept
+                : _owner(owner), _mark(owner->mark()) {}
+
+        scope_guard(scope_guard const&) = delete;
+        scope_guard& operator=(scope_guard const&) = delete;
+
+        ~scope_guard() noexcept { _owner->rewind(_mark); }
+    };
+
+   private:
+    block_t* _first = nullptr;
+    block_t* _block = nullptr;  // Current block; null before first allocation
+    char* _head = nullptr;
+    char* _end = nullptr;
+
+    size_t _block_size;
+
+   public:
+    /**
+     * @param block_size Default capacity of overflow blocks
+     */
+    explicit basic_stack_allocator(size_t block_size = 64 << 10) noexcept
+            : _block_size(block_size) {}
+
+    /**
+     * Uses given buffer as initial block, which is never freed by this allocator.
+     */
+    basic_stack_allocator(void* buffer, size_t size, size_t block_size = 64 << 10) noexcept
+            : _block_size(block_size)
+    {
+        auto align = alignof(std::max_align_t);
+        auto begin = (char*)(((uintptr_t)buffer + align - 1) / align * align);
+        auto end = (char*)buffer + size;
+
+        if (begin + block_t::header_size() < end) {
+            _first = new (begin) block_t{nullptr, size_t(end - begin) - block_t::header_size(), false};
+        }
+    }
+
+    basic_stack_allocator(basic_stack_allocator const&) = delete;
+    basic_stack_allocator& operator=(basic_stack_allocator const&) = delete;
+
+    ~basic_stack_allocator() noexcept { release(); }
+
+   public:
+    void* allocate(size_t n, size_t align = alignof(std::max_align_t))
+    {
+        assert(align && (align & (align - 1)) == 0);
+        auto p = (char*)(((uintptr_t)_head + align - 1) & ~(uintptr_t)(align - 1));
+
+        if (_head != nullptr && p + n <= _end) {
+            _head = p + n;
+            return p;
+        }
+
+        return _allocate_slow(n, align);
+    }
+
+    /**
+     * Only the most recent allocation is actually returned, which lets containers grow in-place
+     *  cheaply. Other deallocations are no-op.
+     */
+    void deallocate(void* p, size_t n, size_t align = alignof(std::max_align_t)) noexcept
+    {
+        (void)align;
+        if ((char*)p + n == _head) { _head = (char*)p; }
+    }
+
+    marker mark() const noexcept { return {_block, _head}; }
+
+    //! Frees everything allocated after marker was taken.
+    void rewind(marker m) noexcept
+    {
+        _block = m.block;
+        _head = m.head;
+        _end = _block ? _block->end() : nullptr;
+    }
+
+    //! Rewinds to given marker on scope exit.
+    scope_guard scope() noexcept { return scope_guard{this}; }
+
+    //! Frees every allocation in O(1), while retaining blocks.
+    void reset() noexcept { rewind({}); }
+
+    //! Frees every allocation, and returns overflow blocks to heap.
+    void release() noexcept
+    {
+        reset();
+
+        block_t** link = &_first;
+        while (auto blk = *link) {
+            if (blk->owning) {
+                *link = blk->next;
+                free(blk);
+            } else {
+                link = &blk->next;
+            }
+        }
+    }
+
+    //! Total bytes of blocks held by this allocator
+    size_t capacity() const noexcept
+    {
+        size_t n = 0;
+        for (auto blk = _first; blk; blk = blk->next) { n += blk->capacity; }
+        return n;
+    }
+
+    template <typename T>
+    auto stl() noexcept;
+
+#if INTERNAL_CPPH_STACK_ALLOC_PMR
+   protected:
+    void* do_allocate(size_t n, size_t align) override { return allocate(n, align); }
+    void do_deallocate(void* p, size_t n, size_t align) override { deallocate(p, n, align); }
+    bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override { return this == &other; }
+#endif
+
+   private:
+    void* _allocate_slow(size_t n, size_t align)
+    {
+        auto const required = n + (align > alignof(std::max_align_t) ? align : 0);
+        auto next = _block ? _block->next : _first;
+
+        while (next && next->capacity < required) {
+            // Retained block doesn't fit; skip it.
+            next = next->next;
+        }
+
+        if (next == nullptr) {
+            auto capacity = std::max(_block_size, required);
+            auto mem = malloc(block_t::header_size() + capacity);
+            if (mem == nullptr) { throw std::bad_alloc{}; }
+
+            next = new (mem) block_t{nullptr, capacity, true};
+            _link_after(_block, next);
+        }
+
+        _block = next;
+        _head = next->data();
+        _end = next->end();
+
+        return allocate(n, align);
+    }
+
+    void _link_after(block_t* prev, block_t* blk) noexcept
+    {
+        if (prev == nullptr) {
+            blk->next = _first, _first = blk;
+        } else {
+            blk->next = prev->next, prev->next = blk;
+        }
+    }
+};
+
+/**
+ * Stack allocator with inline initial storage.
+ */
+template <size_t InlineBytes = 0>
+class stack_allocator : public basic_stack_allocator
+{
+    alignas(std::max_align_t) char _storage[InlineBytes];
+
+   public:
+    explicit stack_allocator(size_t block_size = 64 << 10) noexcept
+            : basic_stack_allocator(_storage, InlineBytes, block_size) {}
+};
+
+template <>
+class stack_allocator<0> : public basic_stack_allocator
+{
+   public:
+    using basic_stack_allocator::basic_stack_allocator;
+};
+
+/**
+ * STL allocator adaptor, which allocates from referenced stack allocator.
+ */
+template <typename T>
+class stack_stl_allocator
+{
+    template <typename>
+    friend class stack_stl_allocator;
+
+    basic_stack_allocator* _source;
+
+   public:
+    using value_type = T;
+
+    explicit stack_stl_allocator(basic_stack_allocator* source) noexcept : _source(source) {}
+
+    template <typename U>
+    stack_stl_allocator(stack_stl_allocator<U> const& other) noexcept : _source(other._source) {}
+
+    T* allocate(size_t n)
+    {
+        return (T*)_source->allocate(n * sizeof(T), alignof(T));
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        _source->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    basic_stack_allocator* source() const noexcept { return _source; }
+
+    template <typename U>
+    bool operator==(stack_stl_allocator<U> const& o) const noexcept { return _source == o._source; }
+
+    template <typename U>
+    bool operator!=(stack_stl_allocator<U> const& o) const noexcept { return _source != o._source; }
+};
+
+template <typename T>
+auto basic_stack_allocator::stl() noexcept
+{
+    return stack_stl_allocator<T>{this};
+}
+}  // namespace cpph
@@ -0,0 +1,529 @@
+// MIT License
+//
+// Copyright (c) 2021-2022. Seungwoo Kang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// project home: https://github.com/perfkitpp
+
+#pragma once
+#include <cstring>
+
+#include "../detail/if_archive.hxx"
+#include "detail/compact.hxx"
+
+namespace cpph::archive::compact {
+CPPH_DECLARE_EXCEPTION(type_mismatch_exception, error::reader_recoverable_exception);
+
+class reader : public archive::if_reader
+{
+    union key_t {
+        context_key data;
+        struct
+        {
+            uint32_t id;
+            uint32_t index;
+        };
+    };
+
+    struct scope_t {
+        enum type_t {
+            type_object,
+            type_array,
+            type_binary
+        };
+
+        key_t ctxkey;
+        type_t type;
+
+        uint64_t elems_left;
+        bool reading_key = false;
+    };
+
+   private:
+    std::vector<scope_t> _scope;
+    uint32_t _scope_key_gen = 0;
+
+    uint64_t _header_hash = 0;
+    bool _schema_matched = false;
+
+   public:
+    explicit reader(std::streambuf* buf, size_t reserved_depth = 0)
+            : archive::if_reader(buf)
+    {
+        reserve_depth(reserved_depth);
+        config.positional_object = true;
+    }
+
+    void reserve_depth(size_t n) { _scope.reserve(n); }
+
+    //! Clears internal parsing state
+    void clear() override { if_reader::clear(), _scope.clear(), _scope_key_gen = 0; }
+
+    /**
+     * Read stream header. Object encoding mode of reader will be set as the header specifies.
+     *
+     * @return Layout hash of archived object
+     */
+    uint64_t read_header()
+    {
+        char header[header_size];
+        if (_buf->sgetn(header, sizeof header) != sizeof header)
+            throw error::reader_unexpected_end_of_file{this};
+
+        if (uint8_t(header[0]) != header_magic)
+            throw error::reader_parse_failed{this, "invalid header magic: %02x", header[0]};
+        if (uint8_t(header[1]) != header_version)
+            throw error::reader_parse_failed{this, "unsupported version: %d", header[1]};
+
+        config.positional_object = header[2] & header_flag_positional;
+
+        _header_hash = 0;
+        for (int i = 0; i < 8; ++i)
+            _header_hash |= uint64_t(uint8_t(header[3 + i])) << (i * 8);
+
+        return _header_hash;
+    }
+
+    /**
+     * Read stream header, and compare archived layout with given object metadata.
+     *
+     * Header only detects layout mismatch; it carries no key table, thus positional records
+     *  are never remapped. Positional objects can be restored only into identical layout, and
+     *  reader_check_failed is thrown on mismatch. Keyed objects (writer without
+     *  positional_object) are matched by key, thus layout may differ, within the tolerance of
+     *  allow_missing_argument / allow_unknown_argument configuration. Choosing between them is
+     *  up to writer.
+     *
+     * @return true if both layout matches.
+     */
+    bool read_header(refl::object_metadata_t meta)
+    {
+        _schema_matched = (read_header() == schema_hash(meta));
+
+        if (not _schema_matched && config.positional_object)
+            throw error::reader_check_failed{this, "positional layout mismatch: %016llx",
+                                             (unsigned long long)_header_hash};
+
+        return _schema_matched;
+    }
+
+    //! Check if last header read matched with expected layout
+    bool schema_matched() const noexcept { return _schema_matched; }
+
+   private:
+    uint8_t _verify_eof(std::streambuf::traits_type::int_type value) const
+    {
+        if (value == std::streambuf::traits_type::eof())
+            throw error::reader_unexpected_end_of_file{this};
+
+        return uint8_t(value);
+    }
+
+    uint8_t _peek() const { return _verify_eof(_buf->sgetc()); }
+    uint8_t _bump() { return _verify_eof(_buf->sbumpc()); }
+
+    typecode _typecode(uint8_t v) const
+    {
+        if (v & uint8_t(typecode::fixuint))
+            return typecode::fixuint;
+        if (v > uint8_t(typecode::map))
+            throw error::reader_parse_failed{this, "invalid typecode %02x", v};
+
+        return typecode(v);
+    }
+
+    uint64_t _get_varint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            auto byte = _bump();
+            value |= uint64_t(byte & 0x7f) << shift;
+
+            if (not(byte & 0x80))
+                return value;
+        }
+
+        throw error::reader_parse_failed{this, "varint too long"};
+    }
+
+    template <typename UInt_>
+    UInt_ _get_le()
+    {
+        unsigned char buf[sizeof(UInt_)];
+        if (_buf->sgetn((char*)buf, sizeof buf) != sizeof buf)
+            throw error::reader_unexpected_end_of_file{this};
+
+        UInt_ value = 0;
+        for (size_t i = 0; i < sizeof(UInt_); ++i)
+            value |= UInt_(buf[i]) << (i * 8);
+
+        return value;
+    }
+
+    template <typename ValTy_>
+    ValTy_ _read_number()
+    {
+        auto header = _peek();
+        switch (_typecode(header)) {
+            case typecode::fixuint: return _bump(), ValTy_(header & 0x7f);
+            case typecode::uint: return _bump(), ValTy_(_get_varint());
+
+            case typecode::sint: {
+                _bump();
+                auto zz = _get_varint();
+                return ValTy_(int64_t(zz >> 1) ^ -int64_t(zz & 1));
+            }
+
+            case typecode::bool_false: return _bump(), ValTy_(0);
+            case typecode::bool_true: return _bump(), ValTy_(1);
+
+            case typecode::float32: {
+                _bump();
+                float value;
+                auto bits = _get_le<uint32_t>();
+                memcpy(&value, &bits, sizeof value);
+                return ValTy_(value);
+            }
+
+            case typecode::float64: {
+                _bump();
+                double value;
+                auto bits = _get_le<uint64_t>();
+                memcpy(&value, &bits, sizeof value);
+                return ValTy_(value);
+            }
+
+            default:
+                throw type_mismatch_exception{
+                        (if_reader*)this, "number type expected: %02x", header};
+        }
+    }
+
+    uint64_t _read_elem_count(typecode expected)
+    {
+        auto header = _peek();
+        if (_typecode(header) != expected)
+            throw type_mismatch_exception{
+                    this, "type error: %02x expected, %02x found", int(expected), header};
+
+        _bump();
+        return _get_varint();
+    }
+
+    template <typename T_>
+    if_reader& _quick_get_num(T_& ref)
+    {
+        ref = _read_number<T_>();
+        _step_context();
+        return *this;
+    }
+
+   public:
+    if_reader& read(nullptr_t) override
+    {
+        // skip single item
+        _skip_once();
+        return *this;
+    }
+
+    if_reader& read(bool& v) override { return _quick_get_num(v); }
+    if_reader& read(int8_t& v) override { return _quick_get_num(v); }
+    if_reader& read(int16_t& v) override { return _quick_get_num(v); }
+    if_reader& read(int32_t& v) override { return _quick_get_num(v); }
+    if_reader& read(int64_t& v) override { return _quick_get_num(v); }
+    if_reader& read(uint8_t& v) override { return _quick_get_num(v); }
+    if_reader& read(uint16_t& v) override { return _quick_get_num(v); }
+    if_reader& read(uint32_t& v) override { return _quick_get_num(v); }
+    if_reader& read(uint64_t& v) override { return _quick_get_num(v); }
+    if_reader& read(float& v) override { return _quick_get_num(v); }
+    if_reader& read(double& v) override { return _quick_get_num(v); }
+
+    if_reader& read(std::string& v) override
+    {
+        auto buflen = _read_elem_count(typecode::str);
+        _step_context();
+
+        v.resize(buflen);
+        if (_buf->sgetn(v.data(), v.size()) != std::streamsize(v.size()))
+            throw error::reader_unexpected_end_of_file{this};
+
+        return *this;
+    }
+
+    size_t elem_left() const override { return _scope_ref().elems_left; }
+
+    bool should_break(const context_key& key) const override
+    {
+        auto scope = &_scope.back();
+        return key.value == scope->ctxkey.data.value && scope->elems_left == 0;
+    }
+
+    context_key begin_object() override
+    {
+        _verify_not_key_type();
+
+        auto n_elem = _read_elem_count(typecode::map);
+        _step_context();
+        return _new_scope(scope_t::type_object, n_elem)->ctxkey.data;
+    }
+
+    void end_object(context_key key) override
+    {
+        auto nbrk = _calc_num_break_scope(scope_t::type_object, key);
+        while (nbrk--) { _break_scope(); }
+    }
+
+    size_t begin_binary() override
+    {
+        auto buflen = _read_elem_count(typecode::bin);
+        _step_context();
+        _new_scope(scope_t::type_binary, buflen);
+        return buflen;
+    }
+
+    size_t binary_read_some(mutable_buffer_view v) override
+    {
+        auto scope = _verify_scope(scope_t::type_binary);
+        auto n_read = std::min<uint64_t>(v.size(), scope->elems_left);
+
+        if (_buf->sgetn(v.data(), n_read) != std::streamsize(n_read))
+            throw error::reader_unexpected_end_of_file{this};
+
+        scope->elems_left -= n_read;
+        return n_read;
+    }
+
+    void end_binary() override
+    {
+        // consume rest of bytes
+        auto scope = _verify_scope(scope_t::type_binary);
+        _discard_n_bytes(scope->elems_left);
+
+        _scope.pop_back();
+    }
+
+    context_key begin_array() override
+    {
+        _verify_not_key_type();
+
+        auto n_elem = _read_elem_count(typecode::array);
+        _step_context();
+        return _new_scope(scope_t::type_array, n_elem)->ctxkey.data;
+    }
+
+    void end_array(context_key key) override
+    {
+        auto nbrk = _calc_num_break_scope(scope_t::type_array, key);
+        while (nbrk--) { _break_scope(); }
+    }
+
+    void read_key_next() override
+    {
+        auto scope = _verify_scope(scope_t::type_object);
+
+        if (scope->elems_left & 1)
+            throw error::reader_invalid_context{this, "not a valid order for key!"};
+        if (scope->reading_key)
+            throw error::reader_invalid_context{this, "duplicated call for read_key_next()"};
+
+        scope->reading_key = true;
+    }
+
+    entity_type type_next() const override
+    {
+        switch (_typecode(_peek())) {
+            case typecode::nil: return entity_type::null;
+
+            case typecode::bool_false:
+            case typecode::bool_true: return entity_type::boolean;
+
+            case typecode::fixuint:
+            case typecode::uint:
+            case typecode::sint: return entity_type::integer;
+
+            case typecode::float32:
+            case typecode::float64: return entity_type::floating_point;
+
+            case typecode::str: return entity_type::string;
+            case typecode::bin: return entity_type::binary;
+            case typecode::array: return entity_type::array;
+            case typecode::map: return entity_type::dictionary;
+
+            default:
+                throw error::reader_parse_failed{this, "unsupported format: %02x", _peek()};
+        }
+    }
+
+   private:
+    void _break_scope()
+    {
+        for (auto scope = &_scope_ref(); scope->elems_left > 0;) {
+            if (scope->type == scope_t::type_object && (scope->elems_left & 1) == 0)
+                scope->reading_key = true;
+
+            _skip_once();
+        }
+
+        _scope.pop_back();
+    }
+
+    void _skip_once()
+    {
+        // intentionally uses peek instead of bump
+        auto header = _peek();
+        uint64_t skip_bytes = 0;
+
+        switch (_typecode(header)) {
+            case typecode::nil:
+            case typecode::bool_false:
+            case typecode::bool_true:
+            case typecode::fixuint:
+                _bump();
+                break;
+
+            case typecode::uint:
+            case typecode::sint:
+                _bump(), _get_varint();
+                break;
+
+            case typecode::float32: skip_bytes = 5; break;
+            case typecode::float64: skip_bytes = 9; break;
+
+            case typecode::str:
+            case typecode::bin:
+                _bump(), skip_bytes = _get_varint();
+                break;
+
+            case typecode::array:
+                end_array(begin_array());
+                return;
+
+            case typecode::map:
+                end_object(begin_object());
+                return;
+
+            default:
+                throw error::reader_parse_failed{this, "unsupported format: %02x", header};
+        }
+
+        _step_context_on_skip();
+        _discard_n_bytes(skip_bytes);
+    }
+
+    size_t _calc_num_break_scope(scope_t::type_t type, context_key key)
+    {
+        // check if given context key exists in scopes
+        for (auto it = _scope.rbegin(), end = _scope.rend(); it != end; ++it)
+            if (it->ctxkey.data.value == key.value) {
+                if (it->type == type)
+                    return it - _scope.rbegin() + 1;
+                else
+                    throw error::reader_check_failed{this, "type mismatch with context!"};
+            }
+
+        throw error::reader_invalid_context{this, "too early scope end call!"};
+    }
+
+    scope_t* _new_scope(scope_t::type_t ty, uint64_t n_elems)
+    {
+        auto scope = &_scope.emplace_back();
+        scope->type = ty;
+        scope->elems_left = n_elems * (ty == scope_t::type_object ? 2 : 1);
+        scope->reading_key = false;
+        scope->ctxkey.index = uint32_t(_scope.size() - 1);
+        scope->ctxkey.id = ++_scope_key_gen;
+
+        return scope;
+    }
+
+    void _verify_not_key_type()
+    {
+        if (_scope.empty()) { return; }
+
+        auto const& scope = _scope.back();
+        if (scope.type != scope_t::type_object) { return; }
+
+        if ((scope.elems_left & 1) == 0)
+            throw error::reader_check_failed{this, "context is in key order"};
+        if (scope.reading_key)
+            throw error::reader_check_failed{this, "reading_key is set"};
+    }
+
+    void _step_context()
+    {
+        if (_scope.empty()) { return; }
+
+        auto scope = &_scope.back();
+        if (scope->type == scope_t::type_binary)
+            throw error::reader_check_failed{this, "binary can not have any subobject!"};
+
+        if (scope->type == scope_t::type_object && not(scope->elems_left & 1)) {
+            if (not scope->reading_key)
+                throw error::reader_check_failed{this, "read_key_next is not called!"};
+            else
+                scope->reading_key = false;
+        }
+
+        if (scope->elems_left-- == 0)
+            throw error::reader_check_failed{this, "all elements read"};
+    }
+
+    void _step_context_on_skip()
+    {
+        if (_scope.empty()) { return; }
+
+        // On skipping context, do not validate object key-array context
+        if (_scope.back().elems_left-- == 0)
+            throw error::reader_check_failed{this, "all elements read"};
+    }
+
+    scope_t const& _scope_ref() const
+    {
+        auto size = _scope.size();
+        if (size == 0)
+            throw error::reader_check_failed{(if_reader*)this, "not in any valid scope!"};
+
+        return _scope[size - 1];
+    }
+
+    scope_t& _scope_ref() { return (scope_t&)((reader const*)this)->_scope_ref(); }
+
+    scope_t* _verify_scope(scope_t::type_t t)
+    {
+        auto scope = &_scope_ref();
+        if (scope->type != t)
+            throw error::reader_check_failed{
+                    this, "invalid scope type: was %d - %d expected", scope->type, t};
+
+        return scope;
+    }
+
+    void _discard_n_bytes(uint64_t bytes)
+    {
+        char buf[256];
+        for (size_t to_read; bytes > 0; bytes -= to_read) {
+            to_read = std::min<uint64_t>(sizeof buf, bytes);
+
+            if (_buf->sgetn(buf, to_read) != std::streamsize(to_read))
+                throw error::reader_unexpected_end_of_file{this};
+        }
+    }
+};
+}  // namespace cpph::archive::compact
@@ -0,0 +1,251 @@
+// MIT License
+//
+// Copyright (c) 2021-2022. Seungwoo Kang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// project home: https://github.com/perfkitpp
+
+#pragma once
+#include <cstring>
+
+#include "detail/compact.hxx"
+#include "detail/context_helper.hxx"
+
+namespace cpph::archive::compact {
+class writer : public archive::if_writer
+{
+   private:
+    archive::_detail::write_context_helper _ctx;
+
+   public:
+    void clear() override { if_writer::clear(), _ctx.clear(); }
+
+   private:
+    template <typename UInt_>
+    void _putle(UInt_ value)
+    {
+        char buf[sizeof(UInt_)];
+        for (size_t i = 0; i < sizeof(UInt_); ++i)
+            buf[i] = char(value >> (i * 8));
+
+        sputn(buf, sizeof buf);
+    }
+
+    void _putvarint(uint64_t value)
+    {
+        char buf[10];
+        size_t n = 0;
+
+        for (; value >= 0x80; value >>= 7)
+            buf[n++] = char(value | 0x80);
+
+        buf[n++] = char(value);
+        sputn(buf, n);
+    }
+
+    void _ap(typecode code)
+    {
+        sputc(char(code));
+    }
+
+    void _ap(typecode code, uint64_t varint)
+    {
+        _ap(code), _putvarint(varint);
+    }
+
+    if_writer& _write_uint(uint64_t value)
+    {
+        _ctx.write_next();
+
+        if (value < 0x80)
+            sputc(char(uint8_t(typecode::fixuint) | value));
+        else
+            _ap(typecode::uint, value);
+
+        return *this;
+    }
+
+    if_writer& _write_int(int64_t value)
+    {
+        if (value >= 0)
+            return _write_uint(value);
+
+        _ctx.write_next();
+        _ap(typecode::sint, (uint64_t(value) << 1) ^ uint64_t(value >> 63));
+        return *this;
+    }
+
+   public:
+    explicit writer(std::streambuf* buf, size_t depth_estimated = 0)
+            : archive::if_writer(buf)
+    {
+        _ctx.reserve_depth(depth_estimated);
+        config.positional_object = true;
+    }
+
+    void reserve_depth(size_t n) { _ctx.reserve_depth(n); }
+
+    /**
+     * Write stream header, which carries layout hash of object to be archived next.
+     */
+    void write_header(refl::object_metadata_t meta)
+    {
+        write_header(schema_hash(meta));
+    }
+
+    void write_header(uint64_t hash)
+    {
+        uint8_t flags = 0;
+        if (config.positional_object) { flags |= header_flag_positional; }
+
+        sputc(char(header_magic));
+        sputc(char(header_version));
+        sputc(char(flags));
+        _putle(hash);
+    }
+
+    if_writer& write(nullptr_t) override
+    {
+        _ctx.write_next();
+        _ap(typecode::nil);
+        return *this;
+    }
+
+    if_writer& write(bool v) override
+    {
+        _ctx.write_next();
+        _ap(v ? typecode::bool_true : typecode::bool_false);
+        return *this;
+    }
+
+    if_writer& write(std::string_view v) override
+    {
+        _ctx.write_next();
+        _ap(typecode::str, v.size());
+        sputn(v.data(), v.size());
+        return *this;
+    }
+
+    if_writer& write(float v) override
+    {
+        uint32_t bits;
+        memcpy(&bits, &v, sizeof v);
+
+        _ctx.write_next();
+        _ap(typecode::float32), _putle(bits);
+        return *this;
+    }
+
+    if_writer& write(double v) override
+    {
+        uint64_t bits;
+        memcpy(&bits, &v, sizeof v);
+
+        _ctx.write_next();
+        _ap(typecode::float64), _putle(bits);
+        return *this;
+    }
+
+    if_writer& write(int8_t v) override { return _write_int(v); }
+    if_writer& write(int16_t v) override { return _write_int(v); }
+    if_writer& write(int32_t v) override { return _write_int(v); }
+    if_writer& write(int64_t v) override { return _write_int(v); }
+
+    if_writer& write(uint8_t v) override { return _write_uint(v); }
+    if_writer& write(uint16_t v) override { return _write_uint(v); }
+    if_writer& write(uint32_t v) override { return _write_uint(v); }
+    if_writer& write(uint64_t v) override { return _write_uint(v); }
+
+    if_writer& binary_push(size_t total) override
+    {
+        _ctx.write_next();
+        _ctx.push_binary(total);
+
+        _ap(typecode::bin, total);
+        return *this;
+    }
+
+    if_writer& binary_write_some(const_buffer_view view) override
+    {
+        _ctx.binary_write_some(view.size());
+        sputn(view.data(), view.size());
+        return *this;
+    }
+
+    if_writer& binary_pop() override
+    {
+        _ctx.pop_binary();
+        return *this;
+    }
+
+    if_writer& object_push(size_t num_elems) override
+    {
+        _ctx.write_next();
+        _ctx.push_object(num_elems);
+
+        _ap(typecode::map, num_elems);
+        return *this;
+    }
+
+    if_writer& object_pop() override
+    {
+        _ctx.pop_object();
+        return *this;
+    }
+
+    if_writer& array_push(size_t num_elems) override
+    {
+        _ctx.write_next();
+        _ctx.push_array(num_elems);
+
+        _ap(typecode::array, num_elems);
+        return *this;
+    }
+
+    if_writer& array_pop() override
+    {
+        _ctx.pop_array();
+        return *this;
+    }
+
+    void write_key_next() override
+    {
+        _ctx.write_key_next();
+    }
+
+    std::unique_ptr<if_writer> fork(std::streambuf* buf, size_t num_skip) const override
+    {
+        auto wr = std::make_unique<writer>(buf);
+        wr->config = config;
+
+        wr->_ctx = _ctx;
+        wr->_ctx.self = wr.get();
+        wr->_ctx.advance(num_skip);
+        return wr;
+    }
+
+    if_writer& join(const_buffer_view encoded, size_t num_elems) override
+    {
+        _ctx.advance(num_elems);
+        sputn(encoded.data(), encoded.size());
+        return *this;
+    }
+};
+}  // namespace cpph::archive::compact
@@ -0,0 +1,142 @@
+// MIT License
+//
+// Copyright (c) 2021-2022. Seungwoo Kang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// project home: https://github.com/perfkitpp
+
+#pragma once
+#include <algorithm>
+#include <cpph/std/vector>
+
+#include "../../../utility/hasher.hxx"
+#include "../../detail/object_core.hxx"
+
+/**
+ * Schema-driven compact binary format.
+ *
+ * Every value is prefixed with single byte typecode. Integers are stored as varint, or zigzag
+ *  varint for negative values. Floating points are stored as raw little endian bytes.
+ *
+ * Objects are archived as positional arrays by default (see archive_config::positional_object),
+ *  thus no key string appears on stream. Optional stream header carries hash of archived
+ *  object's layout, which lets reader detect layout mismatch before restoring. Writers whose
+ *  readers may have different layout should disable positional_object.
+ */
+namespace cpph::archive::compact {
+enum class typecode : uint8_t {
+    nil = 0x00,
+    bool_false = 0x01,
+    bool_true = 0x02,
+
+    uint = 0x03,  // varint
+    sint = 0x04,  // zigzag varint
+
+    float32 = 0x05,  // little endian
+    float64 = 0x06,  // little endian
+
+    str = 0x07,  // varint length + bytes
+    bin = 0x08,  // varint length + bytes
+
+    array = 0x09,  // varint number of elements
+    map = 0x0a,    // varint number of key-value pairs
+
+    // 0b1xxx'xxxx: unsigned integer 0~127, embedded in typecode
+    fixuint = 0x80,
+};
+
+/**
+ * Stream header
+ *
+ *   [magic: 1][version: 1][flags: 1][schema hash: 8, little endian]
+ */
+enum : uint8_t {
+    header_magic = 0xcb,
+    header_version = 1,
+    header_size = 11,
+};
+
+enum header_flag : uint8_t {
+    header_flag_positional = 1 << 0,
+};
+
+namespace _detail {
+template <typename Ty_>
+uint64_t schema_hash_mix(Ty_ const& value, uint64_t hash)
+{
+    return hasher::fnv1a_64((char const*)&value, (char const*)(&value + 1), hash);
+}
+
+inline uint64_t schema_hash_impl(refl::object_metadata_t meta,
+                                 std::vector<refl::object_metadata_t>* path,
+                                 uint64_t hash)
+{
+    // Recursive type refers enclosing type by depth
+    if (auto it = std::find(path->begin(), path->end(), meta); it != path->end())
+        return schema_hash_mix(uint64_t(it - path->begin()), schema_hash_mix('@', hash));
+
+    path->push_back(meta);
+    hash = schema_hash_mix(uint16_t(meta->type()), hash);
+
+    if (meta->is_primitive()) {
+        // Layout of primitives are identified by their type names, and element types.
+        if (auto info = meta->type_info())
+            hash = hasher::fnv1a_64(std::string_view{info->name()}, hash);
+        if (auto elem = meta->element_type())
+            hash = schema_hash_impl(elem, path, hash);
+    } else if (meta->is_object()) {
+        std::vector<refl::property_metadata const*> props;
+        props.reserve(meta->properties().size());
+
+        for (auto& prop : meta->properties()) { props.push_back(&prop); }
+        std::sort(props.begin(), props.end(),
+                  [](auto a, auto b) { return a->name_key_self < b->name_key_self; });
+
+        for (auto prop : props) {
+            hash = schema_hash_mix(prop->name_key_self, hash);
+            hash = hasher::fnv1a_64(std::string_view{prop->name}, hash);
+            hash = schema_hash_impl(prop->type, path, hash);
+        }
+    } else {
+        for (auto& prop : meta->properties())
+            hash = schema_hash_impl(prop.type, path, hash);
+    }
+
+    path->pop_back();
+    return hash;
+}
+}  // namespace _detail
+
+/**
+ * Calculates hash of object layout, which is written on compact stream header.
+ */
+inline uint64_t schema_hash(refl::object_metadata_t meta)
+{
+    std::vector<refl::object_metadata_t> path;
+    return _detail::schema_hash_impl(meta, &path, hasher::FNV_OFFSET_BASE);
+}
+
+template <typename Ty_>
+uint64_t schema_hash()
+{
+    static uint64_t const hash = schema_hash(refl::get_object_metadata<Ty_>());
+    return hash;
+}
+}  // namespace cpph::archive::compact
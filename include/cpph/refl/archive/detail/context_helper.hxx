@@ -193,6 +193,26 @@ class write_context_helper
         _assert_scope_size_valid(elem);
     }
 
+    //! Mark n elements of current array or object as written, without actual write.
+    //! Used for joining elements encoded elsewhere.
+    void advance(size_t n)
+    {
+        _assert_scope_not_empty();
+        auto elem = &_scopes.back();
+
+        if (elem->type == scope_type::object) {
+            if (elem->is_key_current())
+                throw error::writer_invalid_state{self, "value expected!"};
+
+            n *= 2;
+        } else if (elem->type != scope_type::array) {
+            throw error::writer_invalid_state{self, "array or object expected!"};
+        }
+
+        elem->size += n;
+        _assert_scope_size_valid(elem);
+    }
+
     //! Pop array
     //! @return number of elements
     size_t pop_array()
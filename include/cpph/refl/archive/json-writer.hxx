@@ -219,6 +219,26 @@ class writer : public archive::if_writer
         _ctx.write_key_next();
     }
 
+    std::unique_ptr<if_writer> fork(std::streambuf* buf, size_t num_skip) const override
+    {
+        auto wr = std::make_unique<writer>(buf);
+        wr->config = config;
+        wr->indent = indent;
+        memcpy(wr->double_fmt_buf_, double_fmt_buf_, sizeof double_fmt_buf_);
+
+        wr->_ctx = _ctx;
+        wr->_ctx.self = wr.get();
+        wr->_ctx.advance(num_skip);
+        return wr;
+    }
+
+    if_writer& join(const_buffer_view encoded, size_t num_elems) override
+    {
+        _ctx.advance(num_elems);
+        sputn(encoded.data(), encoded.size());
+        return *this;
+    }
+
    private:
     void _on_write_value_only()
     {
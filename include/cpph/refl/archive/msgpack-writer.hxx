@@ -268,5 +268,23 @@ class writer : public archive::if_writer
     {
         _ctx.write_key_next();
     }
+
+    std::unique_ptr<if_writer> fork(std::streambuf* buf, size_t num_skip) const override
+    {
+        auto wr = std::make_unique<writer>(buf);
+        wr->config = config;
+
+        wr->_ctx = _ctx;
+        wr->_ctx.self = wr.get();
+        wr->_ctx.advance(num_skip);
+        return wr;
+    }
+
+    if_writer& join(const_buffer_view encoded, size_t num_elems) override
+    {
+        _ctx.advance(num_elems);
+        sputn(encoded.data(), encoded.size());
+        return *this;
+    }
 };
 }  // namespace cpph::archive::msgpack
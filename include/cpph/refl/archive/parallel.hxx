@@ -0,0 +1,62 @@
+// MIT License
+//
+// Copyright (c) 2021-2022. Seungwoo Kang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// project home: https://github.com/perfkitpp
+
+
+#pragma once
+#include "../../thread/thread_pool.hxx"
+#include "../detail/if_archive.hxx"
+
+namespace cpph::archive {
+/**
+ * Parallel executor which runs chunks on thread pool.
+ *
+ * Usage:
+ *      thread_pool pool;
+ *      archive::thread_pool_executor exec{&pool};
+ *
+ *      archive::msgpack::writer writer{&buf};
+ *      writer.parallel = &exec;
+ *      writer.serialize(large_vector);
+ */
+class thread_pool_executor : public if_parallel_executor
+{
+    thread_pool* _pool;
+    size_t _min_chunk_size;
+
+   public:
+    explicit thread_pool_executor(thread_pool* pool, size_t min_chunk_size = 4096) noexcept
+            : _pool(pool), _min_chunk_size(min_chunk_size)
+    {
+    }
+
+    size_t min_chunk_size() const noexcept override { return _min_chunk_size; }
+
+    size_t concurrency() const noexcept override { return _pool->num_workers() + 1; }
+
+    void invoke_n(size_t n, ufunction<void(size_t)> const& fn) override
+    {
+        parallel_for(*_pool, n, fn);
+    }
+};
+}  // namespace cpph::archive
@@ -23,11 +23,16 @@
 // project home: https://github.com/perfkitpp
 
 #pragma once
+#include <algorithm>
 #include <cpph/std/string_view>
+#include <cpph/std/vector>
+#include <memory>
 #include <stdexcept>
 #include <streambuf>
 
 #include "../../helper/exception.hxx"
+#include "../../streambuf/chunked.hxx"
+#include "../../streambuf/string.hxx"
 #include "../../utility/array_view.hxx"
 #include "../../utility/cleanup.hxx"
 #include "cpph/utility/functional.hxx"
@@ -168,6 +173,10 @@ struct archive_config {
     // Writer configurations
     bool use_integer_key : 1;
 
+    // Archive objects as arrays of properties in name key order, without keys.
+    //  Both ends must share identical object layouts; records are never remapped by name.
+    bool positional_object : 1;
+
     // Reader configurations
     bool allow_missing_argument : 1;
     bool allow_unknown_argument : 1;
@@ -176,6 +185,7 @@ struct archive_config {
    public:
     archive_config() noexcept
             : use_integer_key(false),
+              positional_object(false),
               allow_missing_argument(true),
               allow_unknown_argument(true),
               merge_on_read(false)
@@ -183,6 +193,24 @@ struct archive_config {
     }
 };
 
+/**
+ * Executes archiving of large containers in parallel. See if_writer::parallel
+ */
+class if_parallel_executor
+{
+   public:
+    virtual ~if_parallel_executor() = default;
+
+    //! Minimum number of elements for single chunk. Smaller containers are archived serially.
+    virtual size_t min_chunk_size() const noexcept { return 4096; }
+
+    //! Maximum number of chunks that single container is split into.
+    virtual size_t concurrency() const noexcept = 0;
+
+    //! Invoke fn(index) for every index in [0, n), and wait until all of them finish.
+    virtual void invoke_n(size_t n, ufunction<void(size_t)> const& fn) = 0;
+};
+
 class if_archive_base
 {
    protected:
@@ -224,6 +252,12 @@ class if_archive_base
  */
 class if_writer : public if_archive_base
 {
+   public:
+    //! If set, large arrays and dictionaries are split into chunks which are encoded
+    //!  concurrently on forked writers, then joined in order. Output is identical to serial
+    //!  archiving. Takes effect only on writers which implement fork() and join().
+    if_parallel_executor* parallel = nullptr;
+
    public:
     explicit if_writer(std::streambuf* buf) noexcept : if_archive_base(buf) {}
     ~if_writer() override { flush(); }
@@ -321,8 +355,90 @@ class if_writer : public if_archive_base
 
     //! Assert to write key next
     virtual void write_key_next() = 0;
+
+   public:
+    //! Creates writer of same format and configuration on 'buf', which continues currently
+    //!  open array or object as if 'num_skip' elements were already written.
+    //! Returns nullptr if this writer does not support forking.
+    virtual std::unique_ptr<if_writer> fork(std::streambuf* /*buf*/, size_t /*num_skip*/) const
+    {
+        return nullptr;
+    }
+
+    //! Appends 'num_elems' elements of currently open array or object, which were encoded by
+    //!  forked writer.
+    virtual if_writer& join(const_buffer_view /*encoded*/, size_t /*num_elems*/)
+    {
+        throw error::writer_invalid_state{this, "join() is not supported"};
+    }
 };
 
+/**
+ * Writes 'n' elements from 'begin' on currently open array or object, by calling
+ *  write_elem(strm, *iter) for each.
+ *
+ * If parallel executor is assigned to writer and range is large enough, range is split into
+ *  chunks, which are encoded on forked writers concurrently and then joined in order.
+ */
+template <typename It_, typename WriteFn_>
+void write_elements(if_writer* strm, It_ begin, size_t n, WriteFn_&& write_elem)
+{
+    auto exec = strm->parallel;
+    size_t num_chunks = 0;
+
+    if (exec) {
+        auto min_chunk = std::max<size_t>(exec->min_chunk_size(), 1);
+        num_chunks = std::min(n / min_chunk, exec->concurrency());
+    }
+
+    if (num_chunks < 2) {
+        for (size_t i = 0; i < n; ++i, ++begin) { write_elem(strm, *begin); }
+        return;
+    }
+
+    struct chunk_t {
+        It_ begin;
+        size_t size = 0;
+        std::unique_ptr<if_writer> writer;
+    };
+
+    // Forked writers flush on destruction, thus buffers must outlive them. Encoded chunks are
+    //  written into pages, thus large chunk is never copied on growth.
+    std::unique_ptr<streambuf::chunkbuf[]> bufs{new streambuf::chunkbuf[num_chunks]};
+    std::vector<chunk_t> chunks(num_chunks);
+    auto first = begin;
+
+    for (size_t i = 0, offset = 0; i < num_chunks; ++i) {
+        auto chunk = &chunks[i];
+
+        chunk->size = n / num_chunks + (i < n % num_chunks);
+        chunk->begin = begin;
+        chunk->writer = strm->fork(&bufs[i], offset);
+
+        if (chunk->writer == nullptr) {
+            // Not supported by this writer
+            for (size_t k = 0; k < n; ++k, ++first) { write_elem(strm, *first); }
+            return;
+        }
+
+        std::advance(begin, chunk->size);
+        offset += chunk->size;
+    }
+
+    exec->invoke_n(num_chunks, [&](size_t index) {
+        auto chunk = &chunks[index];
+        auto iter = chunk->begin;
+
+        for (size_t i = 0; i < chunk->size; ++i, ++iter) { write_elem(chunk->writer.get(), *iter); }
+        chunk->writer->flush();
+    });
+
+    for (size_t i = 0; i < num_chunks; ++i) {
+        for (auto page : bufs[i].chunks()) { strm->join(const_buffer_view{page.data(), page.size()}, 0); }
+        strm->join({}, chunks[i].size);
+    }
+}
+
 /**
  * A context key to represent current parsing context
  */
@@ -508,6 +508,14 @@ class object_metadata
         return _primitive->status(data);
     }
 
+    /**
+     * Underlying element type, if this is container-like primitive.
+     */
+    object_metadata_t element_type() const noexcept
+    {
+        return is_primitive() ? _primitive->element_type() : nullptr;
+    }
+
     /**
      * Extent of this object
      */
@@ -598,7 +606,24 @@ class object_metadata
         if (is_primitive()) {
             _primitive->archive(strm, data, this, opt_property);
         } else {
-            if (is_object()) {
+            if (is_object() && strm->config.positional_object) {
+                // Archive as tuple, in name key order.
+                strm->array_push(_key_indices.size());
+                for (auto& [key, index] : _key_indices) {
+                    auto& prop = _props.at(index);
+
+                    auto child = prop.type;
+                    auto child_data = retrieve_self(data, prop);
+                    assert(child_data);
+
+                    if (child->requirement_status(child_data) == reqstat_t::optional_empty) {
+                        *strm << nullptr;
+                    } else {
+                        child->_archive_to(strm, child_data, &prop);
+                    }
+                }
+                strm->array_pop();
+            } else if (is_object()) {
                 size_t num_filled = 0;
                 for (auto& [key, index] : _keys) {
                     auto& prop = _props.at(index);
@@ -679,6 +704,43 @@ class object_metadata
 
         if (is_primitive()) {
             _primitive->restore(strm, data, this, opt_property);
+        } else if (is_object() && strm->config.positional_object) {
+            if (not strm->is_array_next())
+                throw error::invalid_read_state{strm, "positional 'object' expected"};
+
+            auto context_key = strm->begin_array();
+            int num_retrieved = 0;
+
+            // Properties are archived in name key order, without keys. As elements can't be
+            //  matched by key, archive must have exactly the same number of elements.
+            for (auto& [key, index] : _key_indices) {
+                if (strm->should_break(context_key))
+                    break;
+
+                ++num_retrieved;
+                auto& prop = _props.at(index);
+                auto child = prop.type;
+                if (child->is_optional() && strm->is_null_next()) {
+                    nullptr_t nul{};
+                    *strm >> nul;
+                    continue;
+                }
+
+                auto child_data = retrieve_self(data, prop);
+                child->_restore_from(strm, child_data, context, &prop);
+            }
+
+            if (not strm->should_break(context_key)) {
+                strm->end_array(context_key);
+                throw error::unkown_entity{strm, "too many positional properties!"};
+            }
+
+            strm->end_array(context_key);
+
+            if (num_retrieved != int(_key_indices.size()))
+                throw error::missing_entity{strm, "%d positional elems missing [total:%d]",
+                                            int(_key_indices.size()) - num_retrieved,
+                                            int(_key_indices.size())};
         } else if (is_object()) {
             if (not strm->is_object_next())
                 throw error::invalid_read_state{strm, "'object' expected"};
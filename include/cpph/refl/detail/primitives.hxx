@@ -294,10 +294,9 @@ auto get_list_like_descriptor() -> object_metadata_t
             auto container = &data;
 
             strm->array_push(container->size());
-            {
-                for (auto& elem : *container)
-                    *strm << elem;
-            }
+            archive::write_elements(
+                    strm, std::begin(*container), container->size(),
+                    [](archive::if_writer* wr, auto&& elem) { *wr << elem; });
             strm->array_pop();
         }
         void impl_restore(archive::if_reader* strm,
@@ -371,11 +370,13 @@ auto get_dictionary_descriptor() -> object_metadata_t
         void impl_archive(archive::if_writer* strm, const Map_& data, object_metadata_t desc_self, optional_property_metadata opt_as_property) const override
         {
             strm->object_push(data.size());
-            for (auto& [k, v] : data) {
-                strm->write_key_next();
-                *strm << k;
-                *strm << v;
-            }
+            archive::write_elements(
+                    strm, std::begin(data), data.size(),
+                    [](archive::if_writer* wr, auto&& pair) {
+                        wr->write_key_next();
+                        *wr << pair.first;
+                        *wr << pair.second;
+                    });
             strm->object_pop();
         }
 
@@ -435,6 +436,11 @@ INTERNAL_CPPH_define_(
             return get_object_metadata<value_type>()->type();
         }
 
+        object_metadata_t element_type() const noexcept override
+        {
+            return get_object_metadata<value_type>();
+        }
+
        protected:
         void impl_archive(archive::if_writer* strm, const ValTy_& data, object_metadata_t desc_self, optional_property_metadata opt_as_property) const override
         {
@@ -24,64 +24,84 @@
  * project home: https://github.com/perfkitpp
  ******************************************************************************/
 
+
 #pragma once
+#include <cstring>
+#include <mutex>
+
 #include "../../../container/circular_queue.hxx"
-#include "../../../thread/event_wait.hxx"
+#include "../../../streambuf/circular.hxx"
 #include "../detail/connection.hxx"
-#include "thread/threading.hxx"
 
 namespace cpph::rpc::conn {
-class inmemory_pipe : public if_connection, public std::streambuf
+/**
+ * Connection pair within single process, of which each direction is lock-free SPSC ring.
+ *
+ * Writer never blocks; when ring is full, output spills into mutex-guarded backlog which
+ *  grows without bound, and is moved back into ring as reader makes space. Reader takes bytes
+ *  directly from backlog if writer does not come back to drain it.
+ */
+class inmemory_pipe : public if_connection, public streambuf::circular
 {
     struct pipe {
-        thread::event_wait lock;
-        circular_queue<char> strm{1024};
-        size_t total{0};
+        streambuf::circular_ring ring;
+
+        // Cleared by receiver when it waits for data signal
+        std::atomic_flag no_signal = ATOMIC_FLAG_INIT;
 
-        inmemory_pipe* receiver;
+        std::mutex receiver_lock;
+        inmemory_pipe* receiver = nullptr;
+
+        // Bytes which didn't fit into ring. Always follow bytes in ring.
+        std::mutex backlog_lock;
+        circular_queue<char> backlog{0};
+
+        explicit pipe(size_t buffer_size) : ring(buffer_size) { no_signal.test_and_set(); }
     };
 
    private:
     shared_ptr<pipe> _in, _out;
 
-    char _ibuf[2048];
+    // Put area is placed here instead of ring while backlog is not empty.
     char _obuf[2048];
+    bool _put_backlog = false;
 
-    std::atomic_flag _no_signal;
+    // Get area is placed here when it holds bytes taken from backlog.
+    char _ibuf[2048];
+    bool _get_backlog = false;
 
    private:
-    inmemory_pipe()
-            : if_connection(this, "INMEMORY" + std::to_string((intptr_t)this))
+    inmemory_pipe(shared_ptr<pipe> in, shared_ptr<pipe> out)
+            : if_connection(this, "INMEMORY" + std::to_string((intptr_t)this)),
+              circular({in, &in->ring}, {out, &out->ring}),
+              _in(std::move(in)),
+              _out(std::move(out))
     {
-        _no_signal.test_and_set();
     }
 
    public:
-    static auto create()
+    static auto create(size_t buffer_size = 64 << 10)
     {
-        unique_ptr<inmemory_pipe> insts[2];
         shared_ptr<pipe> pipes[2];
+        for (auto& p : pipes) { p = std::make_shared<pipe>(buffer_size); }
 
-        for (auto& p : insts) { p.reset(new inmemory_pipe); }
-        for (auto& p : pipes) { p = std::make_shared<pipe>(); }
-
-        {
-            auto& [ia, ib] = insts;
-            auto& [pa, pb] = pipes;
-            ia->_in = ib->_out = pa;
-            ia->_out = ib->_in = pb;
+        auto& [pa, pb] = pipes;
+        unique_ptr<inmemory_pipe> ia{new inmemory_pipe(pa, pb)};
+        unique_ptr<inmemory_pipe> ib{new inmemory_pipe(pb, pa)};
 
-            pa->receiver = &*ia;
-            pb->receiver = &*ib;
-        }
+        pa->receiver = &*ia;
+        pb->receiver = &*ib;
 
-        return std::make_pair(std::move(insts[0]), std::move(insts[1]));
+        return std::make_pair(std::move(ia), std::move(ib));
     }
 
    public:
     ~inmemory_pipe() override
     {
         inmemory_pipe::close();
+
+        // Put area may be on backlog buffer, which base class must not publish into ring.
+        setp(nullptr, nullptr);
     }
 
     void initialize() noexcept override
@@ -90,115 +110,176 @@ class inmemory_pipe : public if_connection, public std::streambuf
 
     void start_data_receive() noexcept override
     {
-        lock_guard _lc_{_in->lock.mutex()};
+        // Clear flag before checking data, so that either this or writer raises the signal.
+        _in->no_signal.clear();
 
-        if (not _in->strm.empty() || in_avail() != 0)
+        if (in_avail() != 0 && not _in->no_signal.test_and_set())
             this->on_data_receive();
-        else
-            _no_signal.clear();
     }
 
     void close() noexcept override
     {
-        // Set pipe's 'receiver' field nullptr.
-        _in->lock.notify_all([&] { _in->receiver = nullptr; });
-        _out->lock.notify_all([&] { _in->receiver = nullptr; });
+        {
+            std::lock_guard _{_in->receiver_lock};
+            _in->receiver = nullptr;
+        }
+
+        // Writer may be sending from other thread; it sees closed ring on next flush.
+        _out->ring.close();
+        _in->ring.close();
     }
 
     void get_total_rw(size_t* num_read, size_t* num_write) override
     {
-        {
-            lock_guard _{_in->lock.mutex()};
-            *num_read = _in->total;
-        }
-        {
-            lock_guard _{_out->lock.mutex()};
-            *num_write = _out->total;
-        }
+        *num_read = _in->ring.total_written();
+        *num_write = _out->ring.total_written();
     }
 
    protected:
-    int_type overflow(int_type int_type) override
+    int_type overflow(int_type ch) override
     {
-        if (not _do_sync())
-            return traits_type::eof();
+        _flush();
+        _signal_receiver();
+
+        if (_out->ring.is_closed()) { return traits_type::eof(); }
 
-        *_obuf = traits_type::to_char_type(int_type);
+        if (not _put_backlog) {
+            if (auto region = _out->ring.acquire_write(false); not region.empty())
+                setp(region.data(), region.data() + region.size());
+            else
+                _put_backlog = true;
+        }
+
+        if (_put_backlog) { setp(_obuf, _obuf + sizeof _obuf); }
+        if (traits_type::eq_int_type(ch, traits_type::eof())) { return traits_type::not_eof(ch); }
+
+        *pptr() = traits_type::to_char_type(ch);
         pbump(1);
+        return ch;
+    }
+
+    int sync() override
+    {
+        _flush();
+        _signal_receiver();
 
-        return int_type;
+        return _out->ring.is_closed() ? -1 : 0;
     }
 
     int_type underflow() override
     {
-        // Wait until valid data receive
-        size_t nread = 0;
+        _release_input();
+
+        for (;;) {
+            auto closed = _in->ring.is_closed();
+            if (_acquire_input()) { return traits_type::to_int_type(*gptr()); }
+            if (closed) { return traits_type::eof(); }
+
+            // Writer moves any new backlog into ring, which is empty now, thus wakes us up.
+            if (auto region = _in->ring.acquire_read(true); not region.empty()) {
+                setg(region.data(), region.data(), region.data() + region.size());
+                return traits_type::to_int_type(*gptr());
+            }
+        }
+    }
 
-        {
-            bool expired = false;
+    std::streamsize showmanyc() override
+    {
+        _release_input();
+        if (auto n = _in->ring.size()) { return n; }
 
-            auto _lc_ = _in->lock.wait([&] {
-                return (expired = (_in->receiver == nullptr)) || not _in->strm.empty();
-            });
+        std::lock_guard _{_in->backlog_lock};
+        if (auto n = _in->backlog.size()) { return n; }
 
-            if (expired)
-                return traits_type::eof();
+        return _in->ring.is_closed() ? -1 : 0;
+    }
 
-            nread = std::min(sizeof _ibuf, _in->strm.size());
-            _in->strm.dequeue_n(nread, _ibuf);
-        }
+    std::streamsize xsgetn(char_type* s, std::streamsize count) override
+    {
+        auto n = std::streambuf::xsgetn(s, count);
+        if (gptr() == egptr()) { _release_input(); }
 
-        setg(_ibuf, _ibuf, _ibuf + nread);
-        return traits_type::to_int_type(_ibuf[0]);
+        return n;
     }
 
-    int sync() override
+   private:
+    void _signal_receiver() noexcept
     {
-        if (not _do_sync())
-            return traits_type::eof();
+        if (_out->no_signal.test_and_set()) { return; }
 
-        return basic_streambuf::sync();
+        std::lock_guard _{_out->receiver_lock};
+        if (_out->receiver) { _out->receiver->on_data_receive(); }
     }
 
-   private:
-    bool _do_sync()
+    void _flush() noexcept
     {
-        auto wbeg = pbase();
-        auto wend = pptr();
-        auto nwrite = wend - wbeg;
+        if (not _put_backlog) { return circular::_publish(); }
 
-        if (nwrite > 0) {
-            bool disconnect = false;
-            decltype(this) recv = nullptr;
+        auto out = &*_out;
+        std::lock_guard _{out->backlog_lock};
 
-            _out->lock.notify_one([&] {
-                auto strm = &_out->strm;
+        if (auto n = pptr() - pbase()) {
+            auto q = &out->backlog;
+            if (q->capacity() - q->size() < size_t(n))
+                q->reserve_shrink(std::max(q->capacity() * 2, q->capacity() + n));
 
-                if (_out->receiver == nullptr) {
-                    disconnect = true;
-                    return;
-                }
+            q->enqueue_n(pbase(), n);
+        }
 
-                if (strm->capacity() - strm->size() < nwrite)
-                    strm->reserve_shrink(std::max(strm->capacity() * 2, strm->capacity() + nwrite));
+        setp(_obuf, _obuf + sizeof _obuf);
 
-                strm->enqueue_n(wbeg, nwrite);
-                _out->total += nwrite;
+        // Move backlog into ring as much as possible; ring never runs ahead of backlog.
+        while (not out->backlog.empty()) {
+            auto region = out->ring.acquire_write(false);
+            if (region.empty()) { break; }
 
-                if (not _out->receiver->_no_signal.test_and_set())
-                    recv = _out->receiver;
-            });
+            auto n = std::min(region.size(), out->backlog.size());
+            out->backlog.dequeue_n(n, region.data());
+            out->ring.publish(n);
+        }
 
-            if (recv)
-                recv->on_data_receive();
+        if (out->backlog.empty()) {
+            _put_backlog = false;
+            setp(nullptr, nullptr);
+        }
+    }
 
-            if (disconnect)
-                return false;
+    bool _acquire_input() noexcept
+    {
+        if (auto region = _in->ring.acquire_read(false); not region.empty()) {
+            setg(region.data(), region.data(), region.data() + region.size());
+            return true;
         }
 
-        setp(_obuf, _obuf + sizeof _obuf);
+        std::lock_guard _{_in->backlog_lock};
+
+        // Writer may have filled ring, then spilled into backlog since last check.
+        if (auto region = _in->ring.acquire_read(false); not region.empty()) {
+            setg(region.data(), region.data(), region.data() + region.size());
+            return true;
+        }
+
+        if (_in->backlog.empty()) { return false; }
+
+        auto n = std::min(sizeof _ibuf, _in->backlog.size());
+        _in->backlog.dequeue_n(n, _ibuf);
+
+        _get_backlog = true;
+        setg(_ibuf, _ibuf, _ibuf + n);
         return true;
     }
+
+    void _release_input() noexcept
+    {
+        if (_get_backlog) {
+            if (gptr() != egptr()) { return; }
+
+            _get_backlog = false;
+            setg(nullptr, nullptr, nullptr);
+        } else {
+            circular::_release();
+        }
+    }
 };
 
 }  // namespace cpph::rpc::conn
@@ -30,6 +30,7 @@
 #include <cpph/std/string_view>
 #include <system_error>
 
+#include "../../../utility/functional.hxx"
 #include "../../detail/object_core.hxx"
 
 namespace cpph::rpc {
@@ -58,6 +59,13 @@ using error_code = std::error_code;
 using std::enable_if_t;
 using std::is_same_v;
 
+/**
+ * Callback of rpc handlers, completions and events. Inline storage is large enough for lambdas
+ *  which capture a shared_ptr and a couple of strings, thus they don't allocate on heap.
+ */
+template <typename Signature>
+using rpc_function = basic_ufunction<Signature, 120>;
+
 class service;
 class service_builder;
 
@@ -25,7 +25,8 @@
 #pragma once
 #include <cpph/std/set>
 
-#include "../../../memory/pool.hxx"
+#include "../../../memory/concurrent_pool.hxx"
+#include "../../../utility/cleanup.hxx"
 #include "session.hxx"
 
 namespace cpph::rpc {
@@ -42,7 +43,7 @@ class session_group
    private:
     mutable std::mutex _mtx;
     container_type _sessions;
-    pool<array_type> _tmp_pool;
+    concurrent_pool<array_type> _tmp_pool;
 
     size_t _rt_off = 0, _wt_off = 0;
 
@@ -51,6 +52,8 @@ class session_group
     size_t notify_filter(string_view method, Filter&& fn, Params const&... params)
     {
         auto parr = _tmp_pool.checkout();
+        auto _f0_ = cleanup([&] { parr->clear(); });  // Don't keep sessions alive in pooled array
+
         {
             lock_guard _{_mtx};
             parr->clear();
@@ -39,6 +39,12 @@ using std::weak_ptr;
 
 class remote_procedure_message_proxy;
 
+/**
+ * Callable posted to event procedure. Inline storage is large enough to hold completion and
+ *  handler callbacks of session, which capture weak reference, handler package and message id.
+ */
+using event_message = rpc_function<void()>;
+
 class if_event_proc
 {
    public:
@@ -49,17 +55,17 @@ class if_event_proc
      *
      * Low priority.
      */
-    virtual void post_rpc_completion(ufunction<void()>&& fn) { post_internal_message(std::move(fn)); }
+    virtual void post_rpc_completion(event_message&& fn) { post_internal_message(std::move(fn)); }
 
     /**
      * Post incoming request/notify handler callback. Median priority.
      */
-    virtual void post_handler_callback(ufunction<void()>&& fn) { post_internal_message(std::move(fn)); };
+    virtual void post_handler_callback(event_message&& fn) { post_internal_message(std::move(fn)); };
 
     /**
      * Post internal messages. High priority.
      */
-    virtual void post_internal_message(ufunction<void()>&& fn) = 0;
+    virtual void post_internal_message(event_message&& fn) = 0;
 };
 
 /**
@@ -25,7 +25,7 @@
 #pragma once
 #include <mutex>
 
-#include "../../../container/flat_map.hxx"
+#include "../../../container/flat_hash_map.hxx"
 #include "../../../memory/pool.hxx"
 #include "../../../thread/event_wait.hxx"
 #include "connection.hxx"
@@ -36,7 +36,7 @@
 #include "session_profile.hxx"
 
 namespace cpph::rpc {
-using request_complete_handler = ufunction<void(error_code const&, string_view json_error)>;
+using request_complete_handler = rpc_function<void(error_code const&, string_view json_error)>;
 
 template <int>
 class basic_session_builder;
@@ -121,7 +121,7 @@ class session : public if_session, public std::enable_shared_from_this<session>
         pool<rpc_request_node> request_node_pool;
 
         // List of active RPC requests
-        flat_map<int, pool_ptr<rpc_request_node>> requests;
+        flat_hash_map<int, pool_ptr<rpc_request_node>> requests;
     };
 
    private:
@@ -56,10 +56,10 @@ class signature_t<RetVal, std::tuple<Params...>>
 {
    public:
     using return_type = RetVal;
-    using rpc_signature = ufunction<void(RetVal*, Params...)>;
-    using serve_signature_0 = ufunction<RetVal(Params&...)>;
-    using serve_signature_1 = ufunction<void(RetVal*, Params&...)>;
-    using serve_signature_full = ufunction<void(session_profile_view, RetVal*, Params&...)>;
+    using rpc_signature = rpc_function<void(RetVal*, Params...)>;
+    using serve_signature_0 = rpc_function<RetVal(Params&...)>;
+    using serve_signature_1 = rpc_function<void(RetVal*, Params&...)>;
+    using serve_signature_full = rpc_function<void(session_profile_view, RetVal*, Params&...)>;
 
     // Helper for clion code inspection ...
     using guide_t = void (*)(session_profile_view, RetVal*, Params&...);
@@ -93,7 +93,7 @@ class signature_t<RetVal, std::tuple<Params...>>
             optional<string> errstr;
 
             auto fn_on_complete = [&](error_code const& ec, auto str) { result = (request_result)ec.value(), errstr.emplace(str); };
-            auto handle = _rpc->async_request(_host->name(), static_cast<ufunction<void(const error_code&, string_view)>>(fn_on_complete), retval, args...);
+            auto handle = _rpc->async_request(_host->name(), static_cast<rpc_function<void(const error_code&, string_view)>>(fn_on_complete), retval, args...);
 
             if (not handle) {
                 return {request_result::invalid_connection, {}};
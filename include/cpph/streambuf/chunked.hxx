@@ -0,0 +1,161 @@
+// MIT License
+//
+// Copyright (c) 2021-2022. Seungwoo Kang
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// project home: https://github.com/perfkitpp
+
+
+#pragma once
+#include <algorithm>
+#include <cpph/std/string>
+#include <cpph/std/vector>
+#include <cstring>
+#include <memory>
+#include <streambuf>
+
+#include "../utility/array_view.hxx"
+
+namespace cpph::streambuf {
+
+/**
+ * Growable output buffer, which consists of fixed size pages.
+ *
+ * Unlike stringbuf, written content never moves on growth. Pages are kept on clear(), thus
+ *  once buffer grows large enough to contain largest message, encoding messages repeatedly
+ *  on same buffer does not allocate at all.
+ *
+ * Written content can be retrieved as list of chunks, which can be sent directly with
+ *  gather(scatter/gather io) write.
+ */
+class chunkbuf : public std::streambuf
+{
+    size_t _page_size;
+    std::vector<std::unique_ptr<char[]>> _pages;
+    size_t _num_used = 0;
+
+    std::vector<array_view<char const>> _chunks;
+
+   public:
+    explicit chunkbuf(size_t page_size = 4096) noexcept
+            : _page_size(page_size ? page_size : 1)
+    {
+        setp(nullptr, nullptr);
+    }
+
+    chunkbuf(chunkbuf const&) = delete;
+    chunkbuf& operator=(chunkbuf const&) = delete;
+
+   public:
+    //! Rewind to empty state. Allocated pages are kept for reuse.
+    void clear() noexcept
+    {
+        _num_used = 0;
+        setp(nullptr, nullptr);
+    }
+
+    //! Ensure total capacity to be at least n bytes
+    void reserve(size_t n)
+    {
+        while (capacity() < n) { _pages.emplace_back(new char[_page_size]); }
+    }
+
+    //! Release pages which are not in use.
+    void shrink_to_fit()
+    {
+        _pages.resize(_num_used);
+        _pages.shrink_to_fit();
+    }
+
+    size_t page_size() const noexcept { return _page_size; }
+    size_t num_pages() const noexcept { return _pages.size(); }
+    size_t capacity() const noexcept { return _pages.size() * _page_size; }
+    bool empty() const noexcept { return size() == 0; }
+
+    //! Number of bytes written
+    size_t size() const noexcept
+    {
+        return _num_used ? (_num_used - 1) * _page_size + (pptr() - pbase()) : 0;
+    }
+
+    /**
+     * List of written chunks in order. Returned view is valid until next call to this
+     *  function, or any write operation.
+     */
+    array_view<array_view<char const> const> chunks()
+    {
+        _chunks.clear();
+
+        for (size_t i = 0; i < _num_used; ++i) {
+            auto len = i + 1 < _num_used ? _page_size : size_t(pptr() - pbase());
+            if (len > 0) { _chunks.emplace_back(_pages[i].get(), len); }
+        }
+
+        return {_chunks.data(), _chunks.size()};
+    }
+
+    //! Copy all written content to given buffer, which must be larger than size()
+    void copy_to(char* dst) const noexcept
+    {
+        for (size_t i = 0; i < _num_used; ++i) {
+            auto len = i + 1 < _num_used ? _page_size : size_t(pptr() - pbase());
+            memcpy(dst, _pages[i].get(), len), dst += len;
+        }
+    }
+
+    //! Append all written content to given string
+    void copy_to(std::string* str) const
+    {
+        auto offset = str->size();
+        str->resize(offset + size());
+        copy_to(str->data() + offset);
+    }
+
+   protected:
+    int_type overflow(int_type ch) override
+    {
+        if (ch == traits_type::eof()) { return traits_type::not_eof(ch); }
+        if (_num_used == _pages.size()) { _pages.emplace_back(new char[_page_size]); }
+
+        auto page = _pages[_num_used++].get();
+        setp(page, page + _page_size);
+
+        *page = traits_type::to_char_type(ch);
+        pbump(1);
+
+        return ch;
+    }
+
+    std::streamsize xsputn(char const* data, std::streamsize len) override
+    {
+        for (std::streamsize left = len; left > 0;) {
+            if (pptr() == epptr()) { overflow(traits_type::to_int_type(*data++)), --left; }
+
+            auto n = std::min<std::streamsize>(left, epptr() - pptr());
+            memcpy(pptr(), data, n);
+            pbump(int(n));
+
+            data += n, left -= n;
+        }
+
+        return len;
+    }
+};
+}  // namespace cpph::streambuf
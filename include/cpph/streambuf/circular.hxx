@@ -22,8 +22,358 @@
 //
 // project home: https://github.com/perfkitpp
 
+
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <streambuf>
+#include <thread>
+
+#include "../memory/page_allocator.hxx"
+#include "../utility/array_view.hxx"
+
+#if defined(__linux__)
+#    include <linux/futex.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+namespace cpph::streambuf {
+namespace _detail {
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
 
-namespace cpph {
+inline void futex_wait(std::atomic<uint32_t>* addr, uint32_t expected) noexcept
+{
+#if defined(__linux__)
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    // Spurious wakeup is allowed; callers always re-check their condition.
+    if (addr->load() == expected) { std::this_thread::sleep_for(std::chrono::microseconds{50}); }
+#endif
+}
 
+inline void futex_wake_all(std::atomic<uint32_t>* addr) noexcept
+{
+#if defined(__linux__)
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)addr;
+#endif
 }
+}  // namespace _detail
+
+/**
+ * Single-producer/single-consumer wait-free byte ring.
+ *
+ * Producer acquires contiguous free region, writes to it, then publishes written bytes.
+ *  Consumer acquires contiguous readable region, reads it, then releases consumed bytes.
+ *  Both sides cache index of the other side, thus touch shared cache line only when their
+ *  cached view runs out.
+ *
+ * Each side may be driven by different threads over time, as long as calls of that side are
+ *  serialized externally.
+ */
+class circular_ring
+{
+   public:
+    enum : size_t { cache_line = 64 };
+    enum : int { spin_count = 64 };
+
+   private:
+    char* _data = nullptr;
+    size_t _capacity = 0;  // Always power of 2
+    bool _mirrored = false;
+
+    // Producer side. Indices are monotonic byte positions; slot is position & (capacity - 1)
+    alignas(cache_line) std::atomic<size_t> _head{0};
+    size_t _tail_cache = 0;
+
+    // Consumer side
+    alignas(cache_line) std::atomic<size_t> _tail{0};
+    size_t _head_cache = 0;
+
+    // Blocking wait
+    alignas(cache_line) std::atomic<uint32_t> _data_event{0};
+    std::atomic<uint32_t> _space_event{0};
+    std::atomic<bool> _reader_waiting{false};
+    std::atomic<bool> _writer_waiting{false};
+    std::atomic<bool> _closed{false};
+
+   public:
+    /**
+     * @param capacity Rounded up to power of 2. Ring is placed on mirrored memory if possible,
+     *  thus every acquired region spans all available bytes.
+     */
+    explicit circular_ring(size_t capacity = 64 << 10)
+    {
+        _capacity = 64;
+        while (_capacity < capacity) { _capacity <<= 1; }
+
+        if (mirrored_mapping_size(_capacity) == _capacity) {
+            _data = (char*)allocate_mirrored_pages(_capacity);
+            _mirrored = _data != nullptr;
+        }
+
+        if (not _data) { _data = new char[_capacity]; }
+    }
+
+    ~circular_ring() noexcept
+    {
+        if (_mirrored)
+            deallocate_mirrored_pages(_data, _capacity);
+        else
+            delete[] _data;
+    }
+
+    circular_ring(circular_ring const&) = delete;
+    circular_ring& operator=(circular_ring const&) = delete;
+
+   public:
+    size_t capacity() const noexcept { return _capacity; }
+    bool is_mirrored() const noexcept { return _mirrored; }
+    bool is_closed() const noexcept { return _closed.load(std::memory_order_acquire); }
+
+    //! Number of published bytes not yet released. Exact only on consumer side.
+    size_t size() const noexcept { return _head.load() - _tail.load(std::memory_order_relaxed); }
+
+    size_t total_written() const noexcept { return _head.load(std::memory_order_relaxed); }
+    size_t total_read() const noexcept { return _tail.load(std::memory_order_relaxed); }
+
+    /**
+     * Wakes both sides, and makes further acquire_write() fail. Consumer can still read bytes
+     *  published before.
+     */
+    void close() noexcept
+    {
+        _closed.store(true);
+
+        for (auto event : {&_data_event, &_space_event}) {
+            event->fetch_add(1);
+            _detail::futex_wake_all(event);
+        }
+    }
+
+   public:
+    /**
+     * Acquires contiguous free region. Returns empty region if ring is closed, or if it's full
+     *  and wait is false.
+     */
+    array_view<char> acquire_write(bool wait = true) noexcept
+    {
+        auto head = _head.load(std::memory_order_relaxed);
+
+        for (int spin = 0;; ++spin) {
+            if (_closed.load(std::memory_order_acquire)) { return {}; }
+
+            auto space = _capacity - (head - _tail_cache);
+            if (space == 0) {
+                _tail_cache = _tail.load(std::memory_order_acquire);
+                space = _capacity - (head - _tail_cache);
+            }
+
+            if (space > 0) { return _region(head, space); }
+            if (not wait) { return {}; }
+
+            if (spin < spin_count) {
+                std::this_thread::yield();
+            } else {
+                _wait(_writer_waiting, _space_event, [&] {
+                    return _tail.load() != _tail_cache || _closed.load();
+                });
+            }
+        }
+    }
+
+    //! Makes n bytes written on acquired region visible to consumer.
+    void publish(size_t n) noexcept
+    {
+        _head.store(_head.load(std::memory_order_relaxed) + n, std::memory_order_release);
+        _notify(_reader_waiting, _data_event);
+    }
+
+    /**
+     * Acquires contiguous readable region. Returns empty region if ring is closed and drained,
+     *  or if it's empty and wait is false.
+     */
+    array_view<char> acquire_read(bool wait = true) noexcept
+    {
+        auto tail = _tail.load(std::memory_order_relaxed);
+
+        for (int spin = 0;; ++spin) {
+            if (auto n = _head_cache - tail) { return _region(tail, n); }
+
+            // Check closed first; bytes published before close are always visible after it.
+            auto closed = _closed.load(std::memory_order_acquire);
+            _head_cache = _head.load(std::memory_order_acquire);
+
+            if (auto n = _head_cache - tail) { return _region(tail, n); }
+            if (closed || not wait) { return {}; }
+
+            if (spin < spin_count) {
+                std::this_thread::yield();
+            } else {
+                _wait(_reader_waiting, _data_event, [&] {
+                    return _head.load() != tail || _closed.load();
+                });
+            }
+        }
+    }
+
+    //! Returns n bytes of acquired region to producer.
+    void release(size_t n) noexcept
+    {
+        _tail.store(_tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+        _notify(_writer_waiting, _space_event);
+    }
+
+   private:
+    array_view<char> _region(size_t position, size_t n) const noexcept
+    {
+        auto offset = position & (_capacity - 1);
+        return {_data + offset, _mirrored ? n : std::min(n, _capacity - offset)};
+    }
+
+    template <typename Ready_>
+    static void _wait(std::atomic<bool>& waiting, std::atomic<uint32_t>& event, Ready_&& ready) noexcept
+    {
+        waiting.store(true);
+        auto expected = event.load();
+
+        if (not ready()) { _detail::futex_wait(&event, expected); }
+        waiting.store(false, std::memory_order_relaxed);
+    }
+
+    static void _notify(std::atomic<bool>& waiting, std::atomic<uint32_t>& event) noexcept
+    {
+        // Pairs with store of waiting flag; either waiter sees updated index, or we see the flag.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (waiting.load(std::memory_order_relaxed)) {
+            event.fetch_add(1);
+            _detail::futex_wake_all(&event);
+        }
+    }
+};
+
+/**
+ * Stream buffer which reads from one circular_ring, and writes to another.
+ *
+ * Put area and get area are placed directly on ring memory, thus bytes are copied only once
+ *  on each side. Written bytes become visible to reader on pubsync(), or when put area is
+ *  exhausted; consumed space returns to writer when get area is exhausted by sgetn(), or on
+ *  next underflow() or in_avail() call.
+ *
+ * Either ring can be null, for single-direction streams. Use different instance for each
+ *  thread, e.g. one holding only output ring and the other holding the same ring as input.
+ */
+class circular : public std::streambuf
+{
+    std::shared_ptr<circular_ring> _in;
+    std::shared_ptr<circular_ring> _out;
+    bool _blocking = true;
+
+   public:
+    /**
+     * @param blocking If false, underflow returns eof instead of waiting for data, and overflow
+     *  returns eof instead of waiting for space.
+     */
+    explicit circular(std::shared_ptr<circular_ring> in,
+                      std::shared_ptr<circular_ring> out = nullptr,
+                      bool blocking = true) noexcept
+            : _in(std::move(in)), _out(std::move(out)), _blocking(blocking)
+    {
+    }
+
+    ~circular() override
+    {
+        if (_out) { _publish(); }
+    }
+
+    circular(circular const&) = delete;
+    circular& operator=(circular const&) = delete;
+
+   public:
+    circular_ring* in_ring() const noexcept { return _in.get(); }
+    circular_ring* out_ring() const noexcept { return _out.get(); }
+
+    //! Publishes pending output, then closes both rings.
+    void close() noexcept
+    {
+        if (_out) { _publish(), _out->close(); }
+        if (_in) { _in->close(); }
+    }
+
+   protected:
+    int_type overflow(int_type ch) override
+    {
+        if (not _out) { return traits_type::eof(); }
+        _publish();
+
+        auto region = _out->acquire_write(_blocking);
+        setp(region.data(), region.data() + region.size());
+
+        if (region.empty()) { return traits_type::eof(); }
+        if (traits_type::eq_int_type(ch, traits_type::eof())) { return traits_type::not_eof(ch); }
+
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+        return ch;
+    }
+
+    int sync() override
+    {
+        if (not _out) { return 0; }
+
+        _publish();
+        return _out->is_closed() ? -1 : 0;
+    }
+
+    int_type underflow() override
+    {
+        if (not _in) { return traits_type::eof(); }
+        _release();
+
+        auto region = _in->acquire_read(_blocking);
+        setg(region.data(), region.data(), region.data() + region.size());
+
+        if (region.empty()) { return traits_type::eof(); }
+        return traits_type::to_int_type(*gptr());
+    }
+
+    std::streamsize showmanyc() override
+    {
+        if (not _in) { return -1; }
+        _release();
+
+        auto n = _in->size();
+        return n == 0 && _in->is_closed() ? -1 : std::streamsize(n);
+    }
+
+    std::streamsize xsgetn(char_type* s, std::streamsize count) override
+    {
+        auto n = std::streambuf::xsgetn(s, count);
+
+        // Writer may be waiting for space; don't hold consumed bytes until next read.
+        if (_in && gptr() == egptr()) { _release(); }
+        return n;
+    }
+
+   protected:
+    void _publish() noexcept
+    {
+        if (auto n = pptr() - pbase()) { _out->publish(n); }
+
+        // Rest of put area is still owned by this side
+        setp(pptr(), epptr());
+    }
+
+    void _release() noexcept
+    {
+        if (auto n = gptr() - eback()) { _in->release(n); }
+        setg(gptr(), gptr(), egptr());
+    }
+};
+}  // namespace cpph::streambuf
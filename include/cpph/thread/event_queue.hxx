@@ -55,6 +55,9 @@ class basic_event_queue
 {
     struct function_node {
         bool is_ring_allocated_;
+#if CPPH_ALLOC_TRACKING
+        uint32_t alloc_size_;
+#endif
         function_node* next_;
         void (*disposer_)(function_node*);
         void (*invoke_)(function_node*, add_reference_t<Args>...);
@@ -68,7 +71,11 @@ class basic_event_queue
     mutable spinlock alloc_lock_;
     mutable spinlock msg_lock_;
 
-    ring_allocator alloc_;
+    growable_ring_allocator alloc_;
+
+#if CPPH_ALLOC_TRACKING
+    alloc_tracker tracker_{"event_queue"};
+#endif
     thread::event_wait ewait_;
     atomic_bool stopped_ = false;
     function_node* front_ = nullptr;
@@ -79,14 +86,14 @@ class basic_event_queue
      * Creates new message procedure.
      *
      * @param queue_buffer_size
-     *    Queue buffer size. As it does not resized, set this value big enough on construction.
+     *    Maximum queue buffer size. Buffer starts from \c initial_buffer_size, and grows on
+     *     demand up to this value. Messages which don't fit are allocated from heap.
      *
-     * @param num_initial_message_queue_size
-     *    Number of initial image queue size. As this circular queue resizes on demand,
-     *     determining this value is less important than setting \c num_queue_buffer correctly.
+     * @param initial_buffer_size
+     *    Initial queue buffer size.
      */
-    explicit basic_event_queue(size_t queue_buffer_size)
-            : alloc_(queue_buffer_size) {}
+    explicit basic_event_queue(size_t queue_buffer_size, size_t initial_buffer_size = 16 << 10)
+            : alloc_(std::min(initial_buffer_size, queue_buffer_size), queue_buffer_size) {}
 
     /**
      * Destruct this message procedure
@@ -145,6 +152,7 @@ class basic_event_queue
 
     void _release(function_node* p_func) noexcept
     {
+        CPPH_ALLOC_TRACK(tracker_.on_deallocate(p_func->alloc_size_));
         (*p_func).~function_node();
 
         if (p_func->is_ring_allocated_) {
@@ -156,6 +164,13 @@ class basic_event_queue
     }
 
    public:
+    //! Statistics of queue buffer
+    auto buffer_stats() const noexcept
+    {
+        lock_guard _{alloc_lock_};
+        return alloc_.stats();
+    }
+
     bool empty() const
     {
         return lock_guard{msg_lock_}, front_ == nullptr;
@@ -266,8 +281,12 @@ class basic_event_queue
         } else {
             p_func = (function_node*)new char[sizeof(function_node) + sizeof(Message)];
             p_func->is_ring_allocated_ = false;
+            CPPH_ALLOC_TRACK(tracker_.on_fallback());
         }
 
+        CPPH_ALLOC_TRACK(p_func->alloc_size_ = sizeof(function_node) + sizeof(Message),
+                         tracker_.on_allocate(p_func->alloc_size_));
+
         auto p_msg = new (p_func->data) Message{std::forward<Message>(message)};
 
         p_func->next_ = nullptr;
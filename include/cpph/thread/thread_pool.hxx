@@ -29,8 +29,11 @@
 //
 
 #pragma once
+#include <algorithm>
 #include <atomic>
 #include <cpph/std/vector>
+#include <exception>
+#include <memory>
 #include <thread>
 
 #include "cpph/utility/counter.hxx"
@@ -87,8 +90,121 @@ class thread_pool
     {
         return &_proc;
     }
+
+    size_t num_workers() const noexcept
+    {
+        return _workers.size();
+    }
+};
+
+/**
+ * Invokes fn(index) for every index in [0, n) on thread pool, and waits until all of them finish.
+ *
+ * Calling thread also takes indices from same counter, thus this never deadlocks even if it's
+ *  called from worker thread of same pool. First exception thrown from fn is rethrown.
+ */
+template <typename Fn_>
+void parallel_for(thread_pool& pool, size_t n, Fn_&& fn)
+{
+    if (n == 0) { return; }
+    if (n == 1 || pool.num_workers() == 0) {
+        for (size_t i = 0; i < n; ++i) { fn(i); }
+        return;
+    }
+
+    struct state_t {
+        std::remove_reference_t<Fn_>* fn;
+        size_t n;
+        std::atomic_size_t next = 0;
+
+        thread::event_wait wait;
+        size_t num_done = 0;
+        std::exception_ptr error;
+
+        void run()
+        {
+            for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < n;) {
+                std::exception_ptr except;
+                try {
+                    (*fn)(i);
+                } catch (...) {
+                    except = std::current_exception();
+                }
+
+                wait.notify_all([&] {
+                    ++num_done;
+                    if (except && not error) { error = std::move(except); }
+                });
+            }
+        }
+    };
+
+    // Posted handlers may outlive this call, after every index is consumed.
+    auto state = std::make_shared<state_t>();
+    state->fn = &fn;
+    state->n = n;
+
+    auto num_helpers = std::min(n - 1, pool.num_workers());
+    for (size_t i = 0; i < num_helpers; ++i) { pool.post([state] { state->run(); }); }
+
+    state->run();
+    state->wait.wait([&] { return state->num_done == n; });
+
+    if (state->error) { std::rethrow_exception(state->error); }
+}
+
+/**
+ * Describes how bulk operation splits its input into chunks, which run on thread pool.
+ */
+struct parallel_policy {
+    //! Thread pool to run on. Runs on calling thread if null.
+    thread_pool* pool = nullptr;
+
+    //! Inputs smaller than this run on calling thread
+    size_t parallel_threshold = 1 << 16;
+
+    //! Minimum number of elements per chunk
+    size_t min_chunk_size = 1 << 14;
+
+    //! Number of chunks to split n items into, which consist of num_elems elements in total.
+    size_t num_chunks(size_t n, size_t num_elems) const noexcept
+    {
+        if (not pool || num_elems < parallel_threshold) { return 1; }
+
+        auto elems_per_item = std::max<size_t>(num_elems / std::max<size_t>(n, 1), 1);
+        auto max_chunks = num_elems / std::max<size_t>(min_chunk_size, elems_per_item);
+        return std::max<size_t>(std::min({n, max_chunks, pool->num_workers() + 1}), 1);
+    }
+
+    size_t num_chunks(size_t n) const noexcept { return num_chunks(n, n); }
+
+    //! Offset of index'th chunk when n items are split into num_chunks. index may be num_chunks.
+    static size_t chunk_offset(size_t n, size_t num_chunks, size_t index) noexcept
+    {
+        return n * index / num_chunks;
+    }
 };
 
+/**
+ * Split [0, n) into chunks by policy, and invoke fn(begin, end) for each.
+ */
+template <typename Fn_>
+void run_chunked(parallel_policy const& policy, size_t n, size_t num_elems, Fn_&& fn)
+{
+    auto num_chunks = policy.num_chunks(n, num_elems);
+    if (num_chunks <= 1) { return (void)fn(size_t(0), n); }
+
+    parallel_for(*policy.pool, num_chunks, [&](size_t i) {
+        fn(parallel_policy::chunk_offset(n, num_chunks, i), parallel_policy::chunk_offset(n, num_chunks, i + 1));
+    });
+}
+
+template <typename Fn_>
+void run_chunked(parallel_policy const& policy, size_t n, Fn_&& fn)
+{
+    run_chunked(policy, n, n, std::forward<Fn_>(fn));
+}
+
 namespace thread {
 struct lazy_t {};
 constexpr lazy_t lazy;
@@ -28,9 +28,12 @@
 #include <array>
 #include <cassert>
 #include <cstddef>
+#include <cstring>
 #include <functional>
+#include <memory>
 
 #include "generic.hxx"
+#include "relocatable.hxx"
 //
 
 namespace cpph {
@@ -50,69 +53,132 @@ struct default_function_t {
 constexpr default_function_t default_function{nullptr};
 
 /**
- * Non-copyable unique function
- * @tparam Signature_
+ * Non-copyable unique function, with tunable inline storage.
+ *
+ * Callables which fit in InlineBytes_ (and don't require stricter alignment than pointer) are
+ *  stored inline; otherwise they're allocated from Alloc_, which can be a pool or arena
+ *  allocator. Trivially relocatable callables and heap-allocated ones are moved by memcpy,
+ *  thus moving them doesn't involve any indirect call.
+ *
+ * @tparam Signature_ Function signature
+ * @tparam InlineBytes_ Capacity of inline storage, in bytes
+ * @tparam Alloc_ Allocator for callables that don't fit inline storage
  */
-template <typename Signature_>
-class ufunction;
+template <typename Signature_,
+          size_t InlineBytes_ = _function_size - sizeof(void*),
+          class Alloc_ = std::allocator<char>>
+class basic_ufunction;
 
-template <typename Ret_, typename... Args_>
-class ufunction<Ret_(Args_...)>
+template <typename Ret_, typename... Args_, size_t InlineBytes_, class Alloc_>
+class basic_ufunction<Ret_(Args_...), InlineBytes_, Alloc_> : Alloc_
 {
+    static_assert(InlineBytes_ >= sizeof(void*), "Inline storage must be able to hold a pointer");
+
    public:
     using return_type = Ret_;
     using function_type = std::function<Ret_(Args_...)>;
+    using allocator_type = Alloc_;
+
+    enum : size_t { inline_capacity = InlineBytes_ };
 
    private:
-    struct _callable_t {
-        virtual ~_callable_t() = default;
-        virtual Ret_ operator()(Args_... args) = 0;
-        virtual void move(void* to) = 0;
+    struct _vtable_t {
+        Ret_ (*invoke)(void*, Args_&&...);
+        void (*relocate)(void* to, void* from) noexcept;  // null if can be moved by memcpy
+        void (*destroy)(basic_ufunction*) noexcept;
+        bool is_inline;
     };
 
-   private:
-    template <typename Callable>
-    void _assign_function(Callable&& fn)
-    {
-        using callable_type = std::remove_cv_t<std::remove_reference_t<Callable>>;
+    template <typename Fn_>
+    static constexpr bool _is_inline_v = sizeof(Fn_) <= InlineBytes_
+                                         && alignof(Fn_) <= alignof(void*)
+                                         && std::is_nothrow_move_constructible_v<Fn_>;
 
-        struct _callable_impl_t : _callable_t {
-            Ret_ operator()(Args_... args) override
-            {
-                return std::invoke(_body, std::forward<Args_>(args)...);
-            }
+    template <typename Fn_, bool Inline_ = _is_inline_v<Fn_>>
+    struct _ops {
+        using alloc_type = typename std::allocator_traits<Alloc_>::template rebind_alloc<Fn_>;
+        using alloc_traits = std::allocator_traits<alloc_type>;
+
+        static Fn_* get(void* p) noexcept
+        {
+            if constexpr (Inline_)
+                return static_cast<Fn_*>(p);
+            else
+                return *static_cast<Fn_**>(p);
+        }
+
+        static Ret_ invoke(void* p, Args_&&... args)
+        {
+            return std::invoke(*get(p), std::forward<Args_>(args)...);
+        }
 
-            explicit _callable_impl_t(Callable&& fwd)
-                    : _body(std::forward<Callable>(fwd))
-            {
+        static void relocate(void* to, void* from) noexcept
+        {
+            new (to) Fn_(std::move(*get(from)));
+            get(from)->~Fn_();
+        }
+
+        static void destroy(basic_ufunction* self) noexcept
+        {
+            if constexpr (Inline_) {
+                get(self->_buf())->~Fn_();
+            } else {
+                alloc_type alloc{self->_alloc()};
+                auto fn = get(self->_buf());
+
+                alloc_traits::destroy(alloc, fn);
+                alloc_traits::deallocate(alloc, fn, 1);
             }
+        }
 
-            void move(void* raw) override
-            {
-                new (raw) _callable_impl_t(std::move(*this));
+        template <typename Callable>
+        static void construct(basic_ufunction* self, Callable&& fn)
+        {
+            if constexpr (Inline_) {
+                new (self->_buf()) Fn_(std::forward<Callable>(fn));
+            } else {
+                alloc_type alloc{self->_alloc()};
+                auto p = alloc_traits::allocate(alloc, 1);
+
+                try {
+                    alloc_traits::construct(alloc, p, std::forward<Callable>(fn));
+                } catch (...) {
+                    alloc_traits::deallocate(alloc, p, 1);
+                    throw;
+                }
+
+                *static_cast<Fn_**>(self->_buf()) = p;
             }
+        }
 
-           private:
-            callable_type _body;
+        static constexpr _vtable_t table = {
+                &invoke,
+                (not Inline_ || is_trivially_relocatable_v<Fn_>) ? nullptr : &relocate,
+                &destroy,
+                Inline_,
         };
+    };
 
-        if constexpr (sizeof(_callable_impl_t) <= sizeof _sbo_buf) {  // allocate on heap
-            _callable = new (_sbob()) _callable_impl_t{std::forward<Callable>(fn)};
-        } else {  // apply SBO
-            _callable = new _callable_impl_t{std::forward<Callable>(fn)};
-        }
+   private:
+    template <typename Callable>
+    void _assign_function(Callable&& fn)
+    {
+        using ops = _ops<std::decay_t<Callable>>;
+
+        ops::construct(this, std::forward<Callable>(fn));
+        _vt = &ops::table;
     }
 
-    void _move_from(ufunction&& rhs) noexcept
+    void _move_from(basic_ufunction&& rhs) noexcept
     {
-        if (not rhs.is_sbo()) {
-            _callable = rhs._callable;
-            rhs._callable = nullptr;
-        } else {
-            _callable = (_callable_t*)_sbob();
-            rhs._callable->move(_sbob());
-            rhs._destroy();
-        }
+        if (not rhs._vt) { return; }
+
+        if (rhs._vt->relocate)
+            rhs._vt->relocate(_buf(), rhs._buf());
+        else
+            memcpy(_buf(), rhs._buf(), InlineBytes_);
+
+        _vt = std::exchange(rhs._vt, nullptr);
     }
 
    private:
@@ -123,15 +189,15 @@ class ufunction<Ret_(Args_...)>
     }
 
    public:
-    ufunction& operator=(ufunction const& fn) noexcept = delete;
-    ufunction(ufunction const& fn) noexcept = delete;
+    basic_ufunction& operator=(basic_ufunction const& fn) noexcept = delete;
+    basic_ufunction(basic_ufunction const& fn) noexcept = delete;
 
-    ufunction(default_function_t) noexcept
+    basic_ufunction(default_function_t) noexcept
     {
         _assign_function(&_default_fn);
     }
 
-    ufunction& operator=(default_function_t) noexcept
+    basic_ufunction& operator=(default_function_t) noexcept
     {
         _destroy();
         _assign_function(&_default_fn);
@@ -140,28 +206,31 @@ class ufunction<Ret_(Args_...)>
 
     Ret_ operator()(Args_... args) const
     {
-        assert(_callable != nullptr);
-        return std::invoke(*_callable, std::forward<Args_>(args)...);
+        assert(_vt != nullptr);
+        return _vt->invoke(_buf(), std::forward<Args_>(args)...);
     }
 
     template <
             typename Callable,
             typename = std::enable_if_t<
                     not std::is_same_v<
-                            ufunction,
+                            basic_ufunction,
                             std::remove_cv_t<std::remove_reference_t<Callable>>>>,
             typename = std::enable_if_t<
                     std::is_invocable_r_v<Ret_, Callable, Args_...>>>
-    ufunction& operator=(Callable&& fn) noexcept(std::is_nothrow_move_constructible_v<Callable>)
+    basic_ufunction& operator=(Callable&& fn) noexcept(std::is_nothrow_move_constructible_v<Callable>)
     {
         _destroy();
         _assign_function(std::forward<Callable>(fn));
         return *this;
     }
 
-    ufunction& operator=(ufunction&& fn) noexcept
+    basic_ufunction& operator=(basic_ufunction&& fn) noexcept
     {
+        if (&fn == this) { return *this; }
+
         _destroy();
+        _alloc() = fn._alloc();
         _move_from(std::move(fn));
         return *this;
     }
@@ -170,69 +239,88 @@ class ufunction<Ret_(Args_...)>
             typename Callable,
             typename = std::enable_if_t<
                     not std::is_same_v<
-                            ufunction,
+                            basic_ufunction,
                             std::remove_cv_t<std::remove_reference_t<Callable>>>>,
             typename = std::enable_if_t<
                     std::is_invocable_r_v<Ret_, Callable, Args_...>>>
-    ufunction(Callable&& fn) noexcept(std::is_nothrow_move_constructible_v<Callable>)
+    basic_ufunction(Callable&& fn) noexcept(std::is_nothrow_move_constructible_v<Callable>)
+    {
+        _assign_function(std::forward<Callable>(fn));
+    }
+
+    /**
+     * Overflowing callable will be allocated from given allocator.
+     */
+    template <
+            typename Callable,
+            typename = std::enable_if_t<
+                    std::is_invocable_r_v<Ret_, Callable, Args_...>>>
+    basic_ufunction(std::allocator_arg_t, Alloc_ const& alloc, Callable&& fn)
+            : Alloc_(alloc)
     {
         _assign_function(std::forward<Callable>(fn));
     }
 
+    explicit basic_ufunction(Alloc_ const& alloc) noexcept
+            : Alloc_(alloc)
+    {
+    }
+
     operator bool() const noexcept
     {
-        return _callable;
+        return _vt;
     }
 
-    ufunction(ufunction&& fn) noexcept
+    basic_ufunction(basic_ufunction&& fn) noexcept
+            : Alloc_(fn._alloc())
     {
         _move_from(std::move(fn));
     }
 
-    ufunction() noexcept = default;
+    basic_ufunction() noexcept = default;
 
-    ~ufunction() noexcept
+    ~basic_ufunction() noexcept
     {
         _destroy();
     }
 
     bool is_sbo() const noexcept
     {
-        return _is_sbo();
+        return _vt && _vt->is_inline;
     }
 
-   private:
-    void _destroy()
+    allocator_type get_allocator() const noexcept
     {
-        if (_is_sbo())
-            (*_callable).~_callable_t();
-        else
-            delete _callable;
-
-        _callable = nullptr;
+        return _alloc();
     }
 
-    bool _is_sbo() const noexcept
+   private:
+    void _destroy()
     {
-        return (void*)_callable == (void*)_sbob();
+        if (_vt) { std::exchange(_vt, nullptr)->destroy(this); }
     }
 
-    void* _sbob() const noexcept
-    {
-        return const_cast<char*>(_sbo_buf.data());
-    }
+    Alloc_& _alloc() noexcept { return *this; }
+    Alloc_ const& _alloc() const noexcept { return *this; }
 
-    void _static_assert_expr() const noexcept
+    void* _buf() const noexcept
     {
-        static_assert(sizeof _sbo_buf == _function_size - sizeof(void*));
-        static_assert(sizeof(ufunction) == _function_size);
+        return const_cast<char*>(_storage);
     }
 
    private:
-    _callable_t* _callable = nullptr;
-    std::array<char, _function_size - sizeof(void*)> _sbo_buf = {};
+    _vtable_t const* _vt = nullptr;
+    alignas(void*) char _storage[InlineBytes_];
 };
 
+/**
+ * Non-copyable unique function, of which size is same with std::function<> + 16.
+ */
+template <typename Signature_>
+using ufunction = basic_ufunction<Signature_>;
+
+static_assert(sizeof(ufunction<void()>) == _function_size);
+
 // Function utiltiies
 
 #if __cplusplus > 201703L
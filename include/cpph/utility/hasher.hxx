@@ -27,9 +27,25 @@
 #pragma once
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <functional>
+#include <string>
+#include <string_view>
 #include <type_traits>
 
+#if defined(_MSC_VER)
+#    include <cstdlib>  // _byteswap_uint64
+#endif
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#    include <intrin.h>
+#endif
+
+#if !defined(CPPH_NO_SIMD) && (defined(__SSE2__) || defined(__AVX2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#    include <immintrin.h>
+#endif
+
+#include "../helper/macros.hxx"
 #include "type_traits.hxx"
 
 //
@@ -81,6 +97,654 @@ constexpr inline uint64_t fnv1a_64(char const (&s)[N_], uint64_t base = FNV_OFFS
     return fnv1a_64(s, s + N_, base);
 }
 
+namespace _detail {
+// Reads are little-endian on every supported platform.
+template <typename Byte_>
+constexpr uint64_t r8(Byte_ const* p) noexcept
+{
+    uint64_t v = 0;
+    if (not CPPH_IS_CONSTANT_EVALUATED()) {
+        memcpy(&v, p, 8);
+    } else {
+        for (int i = 0; i < 8; ++i) { v |= uint64_t(uint8_t(p[i])) << (i * 8); }
+    }
+    return v;
+}
+
+template <typename Byte_>
+constexpr uint64_t r4(Byte_ const* p) noexcept
+{
+    uint32_t v = 0;
+    if (not CPPH_IS_CONSTANT_EVALUATED()) {
+        memcpy(&v, p, 4);
+    } else {
+        for (int i = 0; i < 4; ++i) { v |= uint32_t(uint8_t(p[i])) << (i * 8); }
+    }
+    return v;
+}
+
+//! 64x64 -> 128 bit multiply, returns (low, high)
+constexpr void mum(uint64_t* a, uint64_t* b) noexcept
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = *a;
+    r *= *b;
+    *a = uint64_t(r), *b = uint64_t(r >> 64);
+#else
+#    if defined(_MSC_VER) && defined(_M_X64)
+    if (not CPPH_IS_CONSTANT_EVALUATED()) {
+        *a = _umul128(*a, *b, b);
+        return;
+    }
+#    endif
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = uint32_t(*a), lb = uint32_t(*b);
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32), c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    *a = lo, *b = hi;
+#endif
+}
+
+//! Folds 128 bit product into 64 bit
+constexpr uint64_t mix(uint64_t a, uint64_t b) noexcept
+{
+    mum(&a, &b);
+    return a ^ b;
+}
+}  // namespace _detail
+
+/*
+ * wyhash: Fast non-cryptographic hash, which consumes 8~48 bytes per step.
+ *
+ * Reference: https://github.com/wangyi-fudan/wyhash (final version 4)
+ */
+namespace _detail::wy {
+constexpr uint64_t secret[] = {0xa0761d6478bd642full, 0xe7037ed1a0b428dbull,
+                               0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull};
+
+template <typename Byte_>
+constexpr uint64_t r3(Byte_ const* p, size_t k) noexcept
+{
+    return (uint64_t(uint8_t(p[0])) << 16) | (uint64_t(uint8_t(p[k >> 1])) << 8) | uint8_t(p[k - 1]);
+}
+
+template <typename Byte_>
+constexpr uint64_t hash(Byte_ const* p, size_t len, uint64_t seed) noexcept
+{
+    uint64_t a = 0, b = 0;
+
+    seed ^= mix(seed ^ secret[0], secret[1]);
+
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (r4(p) << 32) | r4(p + ((len >> 3) << 2));
+            b = (r4(p + len - 4) << 32) | r4(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = r3(p, len), b = 0;
+        }
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = mix(r8(p) ^ secret[1], r8(p + 8) ^ seed);
+                see1 = mix(r8(p + 16) ^ secret[2], r8(p + 24) ^ see1);
+                see2 = mix(r8(p + 32) ^ secret[3], r8(p + 40) ^ see2);
+                p += 48, i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+
+        while (i > 16) {
+            seed = mix(r8(p) ^ secret[1], r8(p + 8) ^ seed);
+            i -= 16, p += 16;
+        }
+
+        a = r8(p + i - 16), b = r8(p + i - 8);
+    }
+
+    a ^= secret[1], b ^= seed;
+    mum(&a, &b);
+    return mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
+}  // namespace _detail::wy
+
+//! Compile-time capable overload. Yields same value with runtime overload.
+constexpr uint64_t wyhash(std::string_view str, uint64_t seed = 0) noexcept
+{
+    return _detail::wy::hash(str.data(), str.size(), seed);
+}
+
+inline uint64_t wyhash(void const* key, size_t len, uint64_t seed = 0) noexcept
+{
+    return _detail::wy::hash(static_cast<unsigned char const*>(key), len, seed);
+}
+
+//! Hash single 64 bit integer
+constexpr uint64_t wyhash64(uint64_t value, uint64_t seed = 0) noexcept
+{
+    return _detail::mix(value ^ _detail::wy::secret[0], seed ^ _detail::wy::secret[1]);
+}
+
+/*
+ * XXH3 (64 bit): Non-cryptographic hash tuned for throughput on long inputs. Inputs longer
+ *  than 240 bytes are consumed as 64 byte stripes on 8 independent lanes, which maps on
+ *  SSE2/AVX2 registers. Scalar and vector paths yield identical values.
+ *
+ * Reference: https://github.com/Cyan4973/xxHash (v0.8)
+ */
+#if !defined(CPPH_NO_SIMD) && defined(__AVX2__)
+#    define INTERNAL_CPPH_XXH3_AVX2 1
+#elif !defined(CPPH_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#    define INTERNAL_CPPH_XXH3_SSE2 1
+#endif
+
+namespace _detail::xxh3 {
+constexpr uint64_t prime32_1 = 0x9E3779B1u;
+constexpr uint64_t prime32_2 = 0x85EBCA77u;
+constexpr uint64_t prime32_3 = 0xC2B2AE3Du;
+constexpr uint64_t prime64_1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t prime64_2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t prime64_3 = 0x165667B19E3779F9ull;
+constexpr uint64_t prime64_4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t prime64_5 = 0x27D4EB2F165667C5ull;
+constexpr uint64_t prime_mx1 = 0x165667919E3779F9ull;
+constexpr uint64_t prime_mx2 = 0x9FB21C651E98DF25ull;
+
+enum : size_t {
+    stripe_len = 64,
+    secret_size = 192,
+    secret_consume_rate = 8,
+    secret_limit = secret_size - stripe_len,
+    stripes_per_block = secret_limit / secret_consume_rate,
+    block_len = stripe_len * stripes_per_block,
+    midsize_max = 240,
+    buffer_size = 256,
+};
+
+constexpr unsigned char default_secret[secret_size] = {
+        0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+        0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+        0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+        0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+        0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+        0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+        0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+        0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+        0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+        0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+        0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+        0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+constexpr uint64_t rotl64(uint64_t v, int r) noexcept { return (v << r) | (v >> (64 - r)); }
+
+constexpr uint64_t swap64(uint64_t v) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap64(v);
+#else
+#    if defined(_MSC_VER)
+    if (not CPPH_IS_CONSTANT_EVALUATED()) { return _byteswap_uint64(v); }
+#    endif
+    uint64_t r = 0;
+    for (int i = 0; i < 8; ++i) { r = (r << 8) | ((v >> (i * 8)) & 0xff); }
+    return r;
+#endif
+}
+
+constexpr uint64_t swap32(uint32_t v) noexcept
+{
+    return ((v << 24) & 0xff000000u) | ((v << 8) & 0x00ff0000u) | ((v >> 8) & 0x0000ff00u) | (v >> 24);
+}
+
+constexpr uint64_t avalanche(uint64_t h) noexcept
+{
+    h ^= h >> 37;
+    h *= prime_mx1;
+    return h ^ (h >> 32);
+}
+
+constexpr uint64_t xxh64_avalanche(uint64_t h) noexcept
+{
+    h ^= h >> 33, h *= prime64_2;
+    h ^= h >> 29, h *= prime64_3;
+    return h ^ (h >> 32);
+}
+
+constexpr uint64_t rrmxmx(uint64_t h, uint64_t len) noexcept
+{
+    h ^= rotl64(h, 49) ^ rotl64(h, 24);
+    h *= prime_mx2;
+    h ^= (h >> 35) + len;
+    h *= prime_mx2;
+    return h ^ (h >> 28);
+}
+
+template <typename Byte_>
+constexpr uint64_t len_0to16(Byte_ const* p, size_t len, unsigned char const* secret, uint64_t seed) noexcept
+{
+    if (len > 8) {
+        uint64_t bitflip1 = (r8(secret + 24) ^ r8(secret + 32)) + seed;
+        uint64_t bitflip2 = (r8(secret + 40) ^ r8(secret + 48)) - seed;
+        uint64_t lo = r8(p) ^ bitflip1;
+        uint64_t hi = r8(p + len - 8) ^ bitflip2;
+        return avalanche(len + swap64(lo) + hi + mix(lo, hi));
+    } else if (len >= 4) {
+        seed ^= swap32(uint32_t(seed)) << 32;
+        uint64_t bitflip = (r8(secret + 8) ^ r8(secret + 16)) - seed;
+        uint64_t input = r4(p + len - 4) + (r4(p) << 32);
+        return rrmxmx(input ^ bitflip, len);
+    } else if (len > 0) {
+        uint32_t combined = (uint32_t(uint8_t(p[0])) << 16) | (uint32_t(uint8_t(p[len >> 1])) << 24)
+                            | uint32_t(uint8_t(p[len - 1])) | (uint32_t(len) << 8);
+        uint64_t bitflip = (r4(secret) ^ r4(secret + 4)) + seed;
+        return xxh64_avalanche(combined ^ bitflip);
+    } else {
+        return xxh64_avalanche(seed ^ (r8(secret + 56) ^ r8(secret + 64)));
+    }
+}
+
+template <typename Byte_>
+constexpr uint64_t mix16(Byte_ const* p, unsigned char const* secret, uint64_t seed) noexcept
+{
+    return mix(r8(p) ^ (r8(secret) + seed), r8(p + 8) ^ (r8(secret + 8) - seed));
+}
+
+template <typename Byte_>
+constexpr uint64_t len_17to128(Byte_ const* p, size_t len, unsigned char const* secret, uint64_t seed) noexcept
+{
+    uint64_t acc = len * prime64_1;
+
+    if (len > 32) {
+        if (len > 64) {
+            if (len > 96) {
+                acc += mix16(p + 48, secret + 96, seed);
+                acc += mix16(p + len - 64, secret + 112, seed);
+            }
+            acc += mix16(p + 32, secret + 64, seed);
+            acc += mix16(p + len - 48, secret + 80, seed);
+        }
+        acc += mix16(p + 16, secret + 32, seed);
+        acc += mix16(p + len - 32, secret + 48, seed);
+    }
+    acc += mix16(p, secret, seed);
+    acc += mix16(p + len - 16, secret + 16, seed);
+
+    return avalanche(acc);
+}
+
+template <typename Byte_>
+constexpr uint64_t len_129to240(Byte_ const* p, size_t len, unsigned char const* secret, uint64_t seed) noexcept
+{
+    uint64_t acc = len * prime64_1;
+    size_t num_rounds = len / 16;
+
+    for (size_t i = 0; i < 8; ++i) { acc += mix16(p + 16 * i, secret + 16 * i, seed); }
+    uint64_t acc_end = mix16(p + len - 16, secret + 136 - 17, seed);
+
+    acc = avalanche(acc);
+    for (size_t i = 8; i < num_rounds; ++i) { acc_end += mix16(p + 16 * i, secret + 16 * (i - 8) + 3, seed); }
+
+    return avalanche(acc + acc_end);
+}
+
+#if defined(INTERNAL_CPPH_XXH3_AVX2)
+inline void accumulate_simd(uint64_t* acc, void const* input, void const* secret, size_t num_stripes) noexcept
+{
+    auto xacc = static_cast<__m256i*>((void*)acc);
+    __m256i a0 = _mm256_loadu_si256(xacc), a1 = _mm256_loadu_si256(xacc + 1);
+
+    for (size_t n = 0; n < num_stripes; ++n) {
+        auto in = (__m256i const*)((char const*)input + n * stripe_len);
+        auto key = (__m256i const*)((char const*)secret + n * secret_consume_rate);
+
+        __m256i d0 = _mm256_loadu_si256(in), d1 = _mm256_loadu_si256(in + 1);
+        __m256i k0 = _mm256_xor_si256(d0, _mm256_loadu_si256(key));
+        __m256i k1 = _mm256_xor_si256(d1, _mm256_loadu_si256(key + 1));
+
+        // acc[i] += swap(data) + lo32(data_key) * hi32(data_key)
+        a0 = _mm256_add_epi64(a0, _mm256_shuffle_epi32(d0, _MM_SHUFFLE(1, 0, 3, 2)));
+        a1 = _mm256_add_epi64(a1, _mm256_shuffle_epi32(d1, _MM_SHUFFLE(1, 0, 3, 2)));
+        a0 = _mm256_add_epi64(a0, _mm256_mul_epu32(k0, _mm256_srli_epi64(k0, 32)));
+        a1 = _mm256_add_epi64(a1, _mm256_mul_epu32(k1, _mm256_srli_epi64(k1, 32)));
+    }
+
+    _mm256_storeu_si256(xacc, a0), _mm256_storeu_si256(xacc + 1, a1);
+}
+
+inline void scramble_simd(uint64_t* acc, void const* secret) noexcept
+{
+    auto xacc = static_cast<__m256i*>((void*)acc);
+    auto key = static_cast<__m256i const*>(secret);
+    __m256i const prime = _mm256_set1_epi32(int(prime32_1));
+
+    for (int i = 0; i < 2; ++i) {
+        __m256i a = _mm256_loadu_si256(xacc + i);
+        a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+        a = _mm256_xor_si256(a, _mm256_loadu_si256(key + i));
+
+        __m256i lo = _mm256_mul_epu32(a, prime);
+        __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+        _mm256_storeu_si256(xacc + i, _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32)));
+    }
+}
+#elif defined(INTERNAL_CPPH_XXH3_SSE2)
+inline void accumulate_simd(uint64_t* acc, void const* input, void const* secret, size_t num_stripes) noexcept
+{
+    auto xacc = static_cast<__m128i*>((void*)acc);
+    __m128i a[4];
+    for (int i = 0; i < 4; ++i) { a[i] = _mm_loadu_si128(xacc + i); }
+
+    for (size_t n = 0; n < num_stripes; ++n) {
+        auto in = (__m128i const*)((char const*)input + n * stripe_len);
+        auto key = (__m128i const*)((char const*)secret + n * secret_consume_rate);
+
+        for (int i = 0; i < 4; ++i) {
+            __m128i d = _mm_loadu_si128(in + i);
+            __m128i k = _mm_xor_si128(d, _mm_loadu_si128(key + i));
+
+            // acc[i] += swap(data) + lo32(data_key) * hi32(data_key)
+            __m128i product = _mm_mul_epu32(k, _mm_shuffle_epi32(k, _MM_SHUFFLE(0, 3, 0, 1)));
+            a[i] = _mm_add_epi64(a[i], _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2)));
+            a[i] = _mm_add_epi64(a[i], product);
+        }
+    }
+
+    for (int i = 0; i < 4; ++i) { _mm_storeu_si128(xacc + i, a[i]); }
+}
+
+inline void scramble_simd(uint64_t* acc, void const* secret) noexcept
+{
+    auto xacc = static_cast<__m128i*>((void*)acc);
+    auto key = static_cast<__m128i const*>(secret);
+    __m128i const prime = _mm_set1_epi32(int(prime32_1));
+
+    for (int i = 0; i < 4; ++i) {
+        __m128i a = _mm_loadu_si128(xacc + i);
+        a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+        a = _mm_xor_si128(a, _mm_loadu_si128(key + i));
+
+        __m128i lo = _mm_mul_epu32(a, prime);
+        __m128i hi = _mm_mul_epu32(_mm_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+        _mm_storeu_si128(xacc + i, _mm_add_epi64(lo, _mm_slli_epi64(hi, 32)));
+    }
+}
+#endif
+
+//! Accumulates num_stripes stripes, consuming secret by 8 bytes per stripe.
+template <typename Byte_>
+constexpr void accumulate(uint64_t* acc, Byte_ const* p, unsigned char const* secret, size_t num_stripes) noexcept
+{
+#if defined(INTERNAL_CPPH_XXH3_AVX2) || defined(INTERNAL_CPPH_XXH3_SSE2)
+    if (not CPPH_IS_CONSTANT_EVALUATED()) { return accumulate_simd(acc, p, secret, num_stripes); }
+#endif
+
+    for (size_t n = 0; n < num_stripes; ++n) {
+        auto in = p + n * stripe_len;
+        auto key = secret + n * secret_consume_rate;
+
+        for (size_t i = 0; i < 8; ++i) {
+            uint64_t data = r8(in + i * 8);
+            uint64_t data_key = data ^ r8(key + i * 8);
+            acc[i ^ 1] += data;
+            acc[i] += uint32_t(data_key) * (data_key >> 32);
+        }
+    }
+}
+
+constexpr void scramble(uint64_t* acc, unsigned char const* secret) noexcept
+{
+#if defined(INTERNAL_CPPH_XXH3_AVX2) || defined(INTERNAL_CPPH_XXH3_SSE2)
+    if (not CPPH_IS_CONSTANT_EVALUATED()) { return scramble_simd(acc, secret); }
+#endif
+
+    for (size_t i = 0; i < 8; ++i) {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= r8(secret + i * 8);
+        acc[i] = a * prime32_1;
+    }
+}
+
+constexpr void init_accumulators(uint64_t* acc) noexcept
+{
+    uint64_t init[] = {prime32_3, prime64_1, prime64_2, prime64_3, prime64_4, prime32_2, prime64_5, prime32_1};
+    for (size_t i = 0; i < 8; ++i) { acc[i] = init[i]; }
+}
+
+//! Writes default secret altered by seed
+constexpr void init_secret(unsigned char* secret, uint64_t seed) noexcept
+{
+    for (size_t i = 0; i < secret_size; i += 8) {
+        uint64_t v = r8(default_secret + i) + ((i & 8) ? 0 - seed : seed);
+
+        if (not CPPH_IS_CONSTANT_EVALUATED()) {
+            memcpy(secret + i, &v, 8);
+        } else {
+            for (size_t k = 0; k < 8; ++k) { secret[i + k] = (unsigned char)(v >> (k * 8)); }
+        }
+    }
+}
+
+constexpr uint64_t merge_accumulators(uint64_t const* acc, unsigned char const* secret, uint64_t start) noexcept
+{
+    for (size_t i = 0; i < 4; ++i) {
+        start += mix(acc[2 * i] ^ r8(secret + 16 * i), acc[2 * i + 1] ^ r8(secret + 16 * i + 8));
+    }
+
+    return avalanche(start);
+}
+
+template <typename Byte_>
+constexpr uint64_t hash_long(Byte_ const* p, size_t len, unsigned char const* secret) noexcept
+{
+    uint64_t acc[8] = {};
+    init_accumulators(acc);
+
+    size_t num_blocks = (len - 1) / block_len;
+    for (size_t n = 0; n < num_blocks; ++n) {
+        accumulate(acc, p + n * block_len, secret, stripes_per_block);
+        scramble(acc, secret + secret_limit);
+    }
+
+    size_t num_stripes = ((len - 1) - block_len * num_blocks) / stripe_len;
+    accumulate(acc, p + num_blocks * block_len, secret, num_stripes);
+    accumulate(acc, p + len - stripe_len, secret + secret_limit - 7, 1);
+
+    return merge_accumulators(acc, secret + 11, len * prime64_1);
+}
+
+template <typename Byte_>
+constexpr uint64_t hash(Byte_ const* p, size_t len, uint64_t seed) noexcept
+{
+    if (len <= 16) { return len_0to16(p, len, default_secret, seed); }
+    if (len <= 128) { return len_17to128(p, len, default_secret, seed); }
+    if (len <= midsize_max) { return len_129to240(p, len, default_secret, seed); }
+    if (seed == 0) { return hash_long(p, len, default_secret); }
+
+    unsigned char secret[secret_size] = {};
+    init_secret(secret, seed);
+    return hash_long(p, len, secret);
+}
+}  // namespace _detail::xxh3
+
+//! Compile-time capable overload. Yields same value with runtime overload.
+constexpr uint64_t xxh3(std::string_view str, uint64_t seed = 0) noexcept
+{
+    return _detail::xxh3::hash(str.data(), str.size(), seed);
+}
+
+inline uint64_t xxh3(void const* data, size_t len, uint64_t seed = 0) noexcept
+{
+    return _detail::xxh3::hash(static_cast<unsigned char const*>(data), len, seed);
+}
+
+/**
+ * Incremental XXH3 hasher. Digest of concatenated updates equals xxh3() of whole input with
+ *  same seed, regardless of how the input is split.
+ */
+class xxh3_stream
+{
+    uint64_t _acc[8] = {};
+    unsigned char _secret[_detail::xxh3::secret_size] = {};
+    unsigned char _buffer[_detail::xxh3::buffer_size] = {};
+    size_t _num_buffered = 0;
+    size_t _num_stripes_so_far = 0;
+    uint64_t _total_len = 0;
+    uint64_t _seed = 0;
+
+   public:
+    explicit xxh3_stream(uint64_t seed = 0) noexcept { reset(seed); }
+
+    void reset(uint64_t seed = 0) noexcept
+    {
+        using namespace _detail::xxh3;
+        init_accumulators(_acc);
+        init_secret(_secret, seed);
+
+        _num_buffered = _num_stripes_so_far = 0;
+        _total_len = 0;
+        _seed = seed;
+    }
+
+    xxh3_stream& update(std::string_view str) noexcept { return update(str.data(), str.size()); }
+
+    xxh3_stream& update(void const* data, size_t len) noexcept
+    {
+        using namespace _detail::xxh3;
+        auto p = static_cast<unsigned char const*>(data);
+        auto end = p + len;
+        _total_len += len;
+
+        if (len <= buffer_size - _num_buffered) {
+            memcpy(_buffer + _num_buffered, p, len);
+            _num_buffered += len;
+            return *this;
+        }
+
+        // Buffer is flushed only when more input follows, as last stripe needs preceding bytes.
+        if (_num_buffered) {
+            auto n_load = buffer_size - _num_buffered;
+            memcpy(_buffer + _num_buffered, p, n_load);
+            p += n_load;
+
+            _consume_stripes(_acc, &_num_stripes_so_far, _buffer, buffer_size / stripe_len);
+            _num_buffered = 0;
+        }
+
+        if (size_t(end - p) > buffer_size) {
+            size_t num_stripes = size_t(end - 1 - p) / stripe_len;
+            p = _consume_stripes(_acc, &_num_stripes_so_far, p, num_stripes);
+
+            // Keep last stripe, which may be referred on digest()
+            memcpy(_buffer + buffer_size - stripe_len, p - stripe_len, stripe_len);
+        }
+
+        memcpy(_buffer, p, size_t(end - p));
+        _num_buffered = size_t(end - p);
+        return *this;
+    }
+
+    uint64_t digest() const noexcept
+    {
+        using namespace _detail::xxh3;
+        if (_total_len <= midsize_max) { return hasher::xxh3(_buffer, size_t(_total_len), _seed); }
+
+        // Digest on copy, so that update can continue afterwards.
+        uint64_t acc[8];
+        memcpy(acc, _acc, sizeof acc);
+
+        unsigned char last_stripe[stripe_len];
+        unsigned char const* last_stripe_ptr = last_stripe;
+
+        if (_num_buffered >= stripe_len) {
+            auto num_stripes_so_far = _num_stripes_so_far;
+            _consume_stripes(acc, &num_stripes_so_far, _buffer, (_num_buffered - 1) / stripe_len);
+            last_stripe_ptr = _buffer + _num_buffered - stripe_len;
+        } else {
+            auto n_catchup = stripe_len - _num_buffered;
+            memcpy(last_stripe, _buffer + buffer_size - n_catchup, n_catchup);
+            memcpy(last_stripe + n_catchup, _buffer, _num_buffered);
+        }
+
+        accumulate(acc, last_stripe_ptr, _secret + secret_limit - 7, 1);
+        return merge_accumulators(acc, _secret + 11, _total_len * prime64_1);
+    }
+
+   private:
+    unsigned char const* _consume_stripes(
+            uint64_t* acc, size_t* num_so_far, unsigned char const* p, size_t num_stripes) const noexcept
+    {
+        using namespace _detail::xxh3;
+        auto secret = _secret + *num_so_far * secret_consume_rate;
+
+        if (num_stripes >= stripes_per_block - *num_so_far) {
+            auto num_this_iter = stripes_per_block - *num_so_far;
+
+            do {
+                accumulate(acc, p, secret, num_this_iter);
+                scramble(acc, _secret + secret_limit);
+                p += num_this_iter * stripe_len;
+                num_stripes -= num_this_iter;
+
+                num_this_iter = stripes_per_block;
+                secret = _secret;
+            } while (num_stripes >= stripes_per_block);
+
+            *num_so_far = 0;
+        }
+
+        if (num_stripes > 0) {
+            accumulate(acc, p, secret, num_stripes);
+            p += num_stripes * stripe_len;
+            *num_so_far += num_stripes;
+        }
+
+        return p;
+    }
+};
+
+/**
+ * General purpose hash functor. Unlike std::hash, every bit of result depends on every bit of
+ *  input. String types can be looked up heterogeneously.
+ */
+template <typename Ty_, typename = void>
+struct fast_hash {
+    using is_avalanching = void;
+
+    size_t operator()(Ty_ const& value) const noexcept
+    {
+        if constexpr (std::is_integral_v<Ty_> || std::is_enum_v<Ty_> || std::is_pointer_v<Ty_>) {
+            uint64_t v = 0;
+            memcpy(&v, &value, sizeof value);
+            return size_t(wyhash64(v));
+        } else {
+            return size_t(wyhash64(std::hash<Ty_>{}(value)));
+        }
+    }
+};
+
+template <typename Char_>
+struct _string_hash {
+    using is_avalanching = void;
+    using is_transparent = void;
+
+    size_t operator()(std::basic_string_view<Char_> str) const noexcept
+    {
+        return size_t(wyhash(str.data(), str.size() * sizeof(Char_)));
+    }
+};
+
+template <typename Char_, typename Tr_, typename Al_>
+struct fast_hash<std::basic_string<Char_, Tr_, Al_>> : _string_hash<Char_> {};
+
+template <typename Char_, typename Tr_>
+struct fast_hash<std::basic_string_view<Char_, Tr_>> : _string_hash<Char_> {};
+
+template <>
+struct fast_hash<char const*> : _string_hash<char> {};
 }  // namespace hasher
 
 template <typename Label_>
@@ -0,0 +1,119 @@
+/*******************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2021-2022. Seungwoo Kang
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * project home: https://github.com/perfkitpp
+ ******************************************************************************/
+
+#pragma once
+#include <array>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+//
+
+namespace cpph {
+/**
+ * Indicates objects of given type can be moved to another address by copying their bytes,
+ *  without invoking move constructor and destructor.
+ *
+ * Every trivially copyable type is trivially relocatable. Other types may opt in by
+ *  specialization, if they don't store any pointer to themselves:
+ *
+ *      template <> struct cpph::is_trivially_relocatable<my_type> : std::true_type {};
+ */
+template <typename Ty_>
+struct is_trivially_relocatable : std::is_trivially_copyable<Ty_> {
+};
+
+template <typename Ty_>
+constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<Ty_>::value;
+
+template <typename Ty_, typename Deleter_>
+struct is_trivially_relocatable<std::unique_ptr<Ty_, Deleter_>> : is_trivially_relocatable<Deleter_> {
+};
+
+template <typename Ty_>
+struct is_trivially_relocatable<std::shared_ptr<Ty_>> : std::true_type {
+};
+
+template <typename Ty_>
+struct is_trivially_relocatable<std::weak_ptr<Ty_>> : std::true_type {
+};
+
+template <typename A_, typename B_>
+struct is_trivially_relocatable<std::pair<A_, B_>>
+        : std::bool_constant<is_trivially_relocatable_v<A_> && is_trivially_relocatable_v<B_>> {
+};
+
+template <typename Ty_, size_t N_>
+struct is_trivially_relocatable<std::array<Ty_, N_>> : is_trivially_relocatable<Ty_> {
+};
+
+#if defined(_LIBCPP_VERSION)
+// libc++ string doesn't point its own short buffer, unlike libstdc++.
+template <typename Char_, typename Traits_>
+struct is_trivially_relocatable<std::basic_string<Char_, Traits_, std::allocator<Char_>>> : std::true_type {
+};
+#endif
+
+/**
+ * Moves n objects from src to uninitialized dst, then destroys source objects.
+ * Source and destination ranges must not overlap.
+ */
+template <typename Ty_>
+void uninitialized_relocate_n(Ty_* src, size_t n, Ty_* dst) noexcept(std::is_nothrow_move_constructible_v<Ty_>)
+{
+    if constexpr (is_trivially_relocatable_v<Ty_>) {
+        if (n) { memcpy((void*)dst, (void const*)src, n * sizeof(Ty_)); }
+    } else {
+        for (; n; --n, ++src, ++dst) {
+            new (dst) Ty_(std::move(*src));
+            src->~Ty_();
+        }
+    }
+}
+
+/**
+ * Same as uninitialized_relocate_n, but ranges may overlap. Destination range, except for
+ *  overlapped region, must be uninitialized.
+ */
+template <typename Ty_>
+void uninitialized_relocate_overlapped_n(Ty_* src, size_t n, Ty_* dst) noexcept(std::is_nothrow_move_constructible_v<Ty_>)
+{
+    if (src == dst || n == 0) { return; }
+
+    if constexpr (is_trivially_relocatable_v<Ty_>) {
+        memmove((void*)dst, (void const*)src, n * sizeof(Ty_));
+    } else if (dst < src) {
+        uninitialized_relocate_n(src, n, dst);
+    } else {
+        for (auto it = n; it; --it) {
+            new (dst + it - 1) Ty_(std::move(src[it - 1]));
+            src[it - 1].~Ty_();
+        }
+    }
+}
+}  // namespace cpph
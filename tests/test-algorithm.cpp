@@ -26,6 +26,12 @@
 #include <container/dynamic_array.hxx>
 #include <helper/nlohmann_json_macros.hxx>
 #include <utility/counter.hxx>
+#include <utility/hasher.hxx>
+
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <vector>
 
 #include "catch.hpp"
 
@@ -72,6 +78,101 @@ TEST_SUITE("misc")
     }
 }
 
+TEST_SUITE("misc")
+{
+    TEST_CASE("hasher values")
+    {
+        using namespace cpph::hasher;
+
+        // Compile-time keys
+        static_assert(xxh3(""sv) == 0x2d06800538d394c2ull);
+        static_assert(xxh3("abc"sv) == 0x78af5f94892f3950ull);
+        static_assert(xxh3(""sv, 42) == 0xb029411ff43d84d2ull);
+        static_assert(wyhash("abc"sv) != wyhash("abd"sv));
+
+        std::string text;
+        for (int i = 0; i < 300; ++i) { text += char('a' + i % 26); }
+
+        // Reference values of XXH3 v0.8, which covers every length class.
+        std::pair<size_t, uint64_t> cases[] = {
+                {16, 0x3d3ccac9af14d8a8ull},
+                {100, 0x7f2b83f8e57a6e24ull},
+                {200, 0xe12dae8ffe57bbc9ull},
+                {300, 0x7f720c1f731c9648ull},
+        };
+
+        for (auto [len, expected] : cases) {
+            CHECK(xxh3(text.data(), len) == expected);
+            CHECK(xxh3(std::string_view{text}.substr(0, len)) == expected);
+        }
+
+        CHECK(xxh3(text.data(), 300, 42) == 0x3486dfd72648ffc6ull);
+        CHECK(xxh3(text.data(), 200, 42) == 0x984a9ab3db697faaull);
+
+        // Runtime overloads yield same value with constexpr ones
+        constexpr auto long_key = "Long compile-time key, which spans over more than 48 bytes"sv;
+        constexpr auto wy_const = wyhash(long_key, 7);
+        constexpr auto xxh_const = xxh3(long_key, 7);
+        CHECK(wyhash(long_key.data(), long_key.size(), 7) == wy_const);
+        CHECK(xxh3(long_key.data(), long_key.size(), 7) == xxh_const);
+
+        // Streaming: any split yields same digest
+        std::mt19937 rg{};
+        std::vector<char> data(5000);
+        for (auto& c : data) { c = char(rg()); }
+
+        for (size_t len : {0, 1, 17, 240, 241, 256, 1024, 1025, 4999}) {
+            for (uint64_t seed : {0, 1234}) {
+                xxh3_stream stream{seed};
+                for (size_t ofst = 0, n; ofst < len; ofst += n) {
+                    n = std::min<size_t>(len - ofst, rg() % 300);
+                    stream.update(data.data() + ofst, n);
+                }
+
+                CHECK(stream.digest() == xxh3(data.data(), len, seed));
+            }
+        }
+    }
+
+    TEST_CASE("hasher benchmark")
+    {
+        using namespace cpph::hasher;
+        using clk = std::chrono::steady_clock;
+
+        std::vector<char> data(64 << 10);
+        std::mt19937 rg{};
+        for (auto& c : data) { c = char(rg()); }
+
+        auto measure = [&](size_t len, auto&& fn) {
+            size_t const total = 4 << 20;
+            uint64_t sum = 0;
+
+            auto t_0 = clk::now();
+            for (size_t done = 0; done < total; done += len) {
+                sum += fn(data.data() + (sum & 7), len);  // Chained, thus can't be hoisted
+            }
+
+            auto sec = std::chrono::duration<double>(clk::now() - t_0).count();
+            return std::make_pair(total / sec / 1e9, sum);
+        };
+
+        std::ostringstream report;
+        uint64_t sink = 0;
+        for (size_t len : {16, 64, 256, 4096, 60000}) {
+            auto fnv = measure(len, [](char const* p, size_t n) { return fnv1a_64(p, p + n); });
+            auto wy = measure(len, [](char const* p, size_t n) { return wyhash(p, n); });
+            auto xx = measure(len, [](char const* p, size_t n) { return xxh3(p, n); });
+
+            sink ^= fnv.second ^ wy.second ^ xx.second;
+            report << "\n  " << len << " bytes (GB/s): fnv1a " << fnv.first
+                   << ", wyhash " << wy.first << ", xxh3 " << xx.first;
+        }
+
+        INFO("hash throughput" << report.str());
+        CHECK(sink != 0);
+    }
+}
+
 #if __has_include("nlohmann/json.hpp")
 
 struct my_serialized {
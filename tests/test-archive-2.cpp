@@ -25,6 +25,7 @@
 // H
 #include <iostream>
 #include <list>
+#include <map>
 #include <optional>
 #include <sstream>
 
@@ -56,16 +57,20 @@ CPPH_REFL_DECLARE(base_object);
 // CPP
 
 #include "catch.hpp"
+#include "refl/archive/compact-reader.hxx"
+#include "refl/archive/compact-writer.hxx"
 #include "refl/archive/debug_string_writer.hxx"
 #include "refl/archive/json.hpp"
 #include "refl/archive/msgpack-reader.hxx"
 #include "refl/archive/msgpack-writer.hxx"
+#include "refl/archive/parallel.hxx"
 #include "refl/object.hxx"
 #include "refl/types/array.hxx"
 #include "refl/types/binary.hxx"
 #include "refl/types/chrono.hxx"
 #include "refl/types/key.hxx"
 #include "refl/types/list.hxx"
+#include "refl/types/tuple.hxx"
 #include "refl/types/variant.hxx"
 
 using namespace cpph;
@@ -73,12 +78,28 @@ using namespace cpph;
 CPPH_REFL_DEFINE_OBJECT(base_object, (), (opt_double), (list_int), (bin_vec_chars));
 CPPH_REFL_DEFINE_OBJECT_c(child_object, (.extend<base_object>()), (placeholder));
 
+struct layout_v1 {
+    int alpha = 1;
+    std::string gamma = "gamma";
+
+    CPPH_REFL_DEFINE_OBJECT_inline((), (alpha), (gamma));
+};
+
+struct layout_v2 {
+    int alpha = 1;
+    double beta = 2.5;
+    std::string gamma = "gamma";
+
+    CPPH_REFL_DEFINE_OBJECT_inline((), (alpha), (beta), (gamma));
+};
+
 using test_templ_type_1 = std::pair<archive::json::writer, archive::json::reader>;
 using test_templ_type_2 = std::pair<archive::msgpack::writer, archive::msgpack::reader>;
+using test_templ_type_3 = std::pair<archive::compact::writer, archive::compact::reader>;
 
 TEST_SUITE("refl.archive")
 {
-    TEST_CASE_TEMPLATE("marshalling, deserialize", TestType, test_templ_type_1, test_templ_type_2)
+    TEST_CASE_TEMPLATE("marshalling, deserialize", TestType, test_templ_type_1, test_templ_type_2, test_templ_type_3)
     {
         using writer = typename TestType::first_type;
         using reader = typename TestType::second_type;
@@ -174,4 +195,173 @@ TEST_SUITE("refl.archive")
             }
         }
     }
+
+    TEST_CASE("Compact archive schema header")
+    {
+        std::stringbuf sbuf;
+        archive::compact::writer writer{&sbuf};
+        archive::compact::reader reader{&sbuf};
+
+        auto base_meta = refl::get_object_metadata<base_object>();
+        auto child_meta = refl::get_object_metadata<child_object>();
+
+        REQUIRE(archive::compact::schema_hash(base_meta) == archive::compact::schema_hash<base_object>());
+        REQUIRE(archive::compact::schema_hash(base_meta) != archive::compact::schema_hash(child_meta));
+
+        SUBCASE("Positional, matching layout")
+        {
+            child_object enc{};
+            enc.fill();
+            writer.write_header(child_meta);
+            writer << enc;
+
+            child_object dec{};
+            REQUIRE(reader.read_header(child_meta));
+            REQUIRE(reader.config.positional_object);
+            reader >> dec;
+
+            REQUIRE(dec.opt_double == enc.opt_double);
+            REQUIRE(dec.list_int == enc.list_int);
+            REQUIRE(dec.bin_vec_chars == enc.bin_vec_chars);
+        }
+
+        SUBCASE("Positional is smaller than keyed")
+        {
+            child_object enc{};
+            enc.fill();
+
+            writer << enc;
+            auto positional_size = sbuf.str().size();
+
+            std::stringbuf msgbuf;
+            archive::msgpack::writer msgwr{&msgbuf};
+            msgwr.config.use_integer_key = true;
+            msgwr << enc;
+
+            REQUIRE(positional_size < msgbuf.str().size());
+        }
+
+        SUBCASE("Positional, layout mismatch")
+        {
+            writer.write_header(child_meta);
+            writer << child_object{}.fill();
+
+            REQUIRE_THROWS_AS(reader.read_header(base_meta), archive::error::reader_check_failed);
+            REQUIRE(not reader.schema_matched());
+        }
+
+        SUBCASE("Property inserted or removed")
+        {
+            layout_v2 v2;
+            v2.alpha = 7, v2.beta = -1., v2.gamma = "v2";
+
+            // Positional archive must not be restored into different layout
+            writer.write_header(refl::get_object_metadata<layout_v2>());
+            writer << v2;
+
+            layout_v1 v1;
+            REQUIRE_THROWS_AS(reader.read_header(refl::get_object_metadata<layout_v1>()),
+                              archive::error::reader_check_failed);
+
+            // ... nor without header; elements are checked by type and count
+            sbuf.str("");
+            writer << v2;
+            reader.clear();
+            REQUIRE_THROWS(reader >> v1);
+
+            sbuf.str("");
+            writer << layout_v1{};
+            reader.clear();
+
+            layout_v2 v2_dec;
+            REQUIRE_THROWS(reader >> v2_dec);
+
+            // Keyed archive matches properties by key across layouts
+            sbuf.str("");
+            writer.config.positional_object = false;
+            writer.write_header(refl::get_object_metadata<layout_v2>());
+            writer << v2;
+
+            reader.clear();
+            REQUIRE(not reader.read_header(refl::get_object_metadata<layout_v1>()));
+            REQUIRE_NOTHROW(reader >> v1);
+            REQUIRE(v1.alpha == 7);
+            REQUIRE(v1.gamma == "v2");
+
+            v1.alpha = 3, v1.gamma = "v1";
+            writer.write_header(refl::get_object_metadata<layout_v1>());
+            writer << v1;
+
+            layout_v2 dec;
+            REQUIRE(not reader.read_header(refl::get_object_metadata<layout_v2>()));
+            REQUIRE_NOTHROW(reader >> dec);
+            REQUIRE(dec.alpha == 3);
+            REQUIRE(dec.beta == 2.5);
+            REQUIRE(dec.gamma == "v1");
+        }
+
+        SUBCASE("Keyed")
+        {
+            writer.config.positional_object = false;
+            writer.write_header(child_meta);
+            writer << child_object{}.fill();
+
+            base_object dec{};
+            REQUIRE(not reader.read_header(base_meta));
+            REQUIRE(not reader.config.positional_object);
+            REQUIRE_NOTHROW(reader >> dec);
+            REQUIRE(dec.opt_double == 31314.);
+        }
+    }
+
+    TEST_CASE_TEMPLATE("Parallel archive of large containers", TestType, test_templ_type_1, test_templ_type_2, test_templ_type_3)
+    {
+        using writer = typename TestType::first_type;
+        using reader = typename TestType::second_type;
+
+        struct large_t {
+            std::vector<child_object> objects;
+            std::map<int, std::string> dict;
+            std::vector<std::vector<int>> nested;
+        } data;
+
+        for (int i = 0; i < 1500; ++i) {
+            data.objects.emplace_back().fill();
+            data.dict[i * 7] = std::to_string(i);
+            data.nested.emplace_back(i % 13, i);
+        }
+
+        auto archive = [&](archive::if_parallel_executor* exec) {
+            std::stringbuf sbuf;
+            writer wr{&sbuf};
+            wr.parallel = exec;
+
+            wr.array_push(3);
+            wr << data.objects << data.dict << data.nested;
+            wr.array_pop();
+            wr.flush();
+            return sbuf.str();
+        };
+
+        thread_pool pool{3};
+        archive::thread_pool_executor exec{&pool, 100};
+
+        auto serial = archive(nullptr);
+        auto parallel = archive(&exec);
+        REQUIRE(serial.size() == parallel.size());
+        REQUIRE(serial == parallel);
+
+        std::stringbuf sbuf{parallel};
+        reader rd{&sbuf};
+        decltype(data) dec;
+
+        auto key = rd.begin_array();
+        rd >> dec.objects >> dec.dict >> dec.nested;
+        rd.end_array(key);
+
+        REQUIRE(dec.objects.size() == data.objects.size());
+        REQUIRE(dec.objects.back().list_int == data.objects.back().list_int);
+        REQUIRE(dec.dict == data.dict);
+        REQUIRE(dec.nested == data.nested);
+    }
 }
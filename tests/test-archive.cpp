@@ -32,6 +32,7 @@
 #include "refl/archive/msgpack-reader.hxx"
 #include "refl/archive/msgpack-writer.hxx"
 #include "refl/object.hxx"
+#include "refl/types/alloc_stats.hxx"
 #include "refl/types/array.hxx"
 #include "refl/types/binary.hxx"
 #include "refl/types/list.hxx"
@@ -410,4 +411,30 @@ TEST_SUITE("refl.archive")
         REQUIRE(refl::get_ptr<int>(p) != nullptr);
         REQUIRE(*refl::get_ptr<int>(p) == 4);
     }
+
+    TEST_CASE("alloc stats serialization")
+    {
+        cpph::alloc_tracker tracker{"test-archive-tracker"};
+        tracker.on_allocate(100);
+        tracker.on_fallback();
+
+        auto stats = alloc_registry::get().snapshot("test-archive-tracker");
+        REQUIRE(stats.size() == 1);
+
+        std::stringbuf strbuf;
+        archive::json::writer writer{&strbuf};
+        writer << stats;
+
+        CHECK(strbuf.str().find("\"peak_bytes_live\"") != std::string::npos);
+
+        std::vector<alloc_stats> restored;
+        archive::json::reader reader{&strbuf};
+        reader >> restored;
+
+        REQUIRE(restored.size() == 1);
+        CHECK(restored[0].name == "test-archive-tracker");
+        CHECK(restored[0].bytes_live == 100);
+        CHECK(restored[0].num_fallbacks == 1);
+        CHECK(restored[0].size_histogram == stats[0].size_histogram);
+    }
 }
@@ -1,7 +1,79 @@
 
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "algorithm/parallel_sort.hxx"
 #include "catch.hpp"
+#include "container/bimap.hxx"
 #include "container/circular_queue.hxx"
 #include "container/deque.hxx"
+#include "container/flat_hash_map.hxx"
+#include "container/flat_map.hxx"
+#include "container/ndarray_ops.hxx"
+#include "container/shared_string.hxx"
+#include "container/static_vector.hxx"
+#include "container/string_cache.hxx"
+
+//! Counts bytes allocated through it, including rebound copies.
+template <typename T>
+struct counting_allocator {
+    using value_type = T;
+    size_t* bytes;
+
+    explicit counting_allocator(size_t* bytes) noexcept : bytes(bytes) {}
+
+    template <typename U>
+    counting_allocator(counting_allocator<U> const& other) noexcept : bytes(other.bytes) {}
+
+    T* allocate(size_t n)
+    {
+        *bytes += n * sizeof(T);
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        *bytes -= n * sizeof(T);
+        std::allocator<T>{}.deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(counting_allocator<U> const& other) const noexcept { return bytes == other.bytes; }
+
+    template <typename U>
+    bool operator!=(counting_allocator<U> const& other) const noexcept { return bytes != other.bytes; }
+};
+
+//! Counts move constructions, to verify relocation fast paths.
+struct move_counted {
+    static inline size_t num_moves = 0;
+    std::unique_ptr<int> value;
+
+    explicit move_counted(int v) : value(std::make_unique<int>(v)) {}
+    move_counted(move_counted&& o) noexcept : value(std::move(o.value)) { ++num_moves; }
+};
+
+struct relocatable_counted : move_counted {
+    using move_counted::move_counted;
+};
+
+template <>
+struct cpph::is_trivially_relocatable<relocatable_counted> : std::true_type {
+};
+
+static_assert(cpph::is_trivially_relocatable_v<int>);
+static_assert(cpph::is_trivially_relocatable_v<std::unique_ptr<int>>);
+static_assert(cpph::is_trivially_relocatable_v<std::pair<std::shared_ptr<int>, double>>);
+static_assert(not cpph::is_trivially_relocatable_v<move_counted>);
 
 TEST_SUITE("misc")
 {
@@ -21,4 +93,843 @@ TEST_SUITE("misc")
             REQUIRE(std::equal(content, content + sizeof content, buf, buf + sizeof buf));
         }
     }
+
+    TEST_CASE("Shared string")
+    {
+        using cpph::shared_string;
+
+        shared_string null;
+        REQUIRE(not null.is_valid());
+        REQUIRE(null.empty());
+
+        shared_string short_str = "hello";
+        REQUIRE(short_str.is_inline());
+        REQUIRE(short_str == "hello");
+        REQUIRE(short_str.c_str()[5] == 0);
+
+        std::string long_value(100, 'x');
+        shared_string long_str = long_value;
+        REQUIRE(not long_str.is_inline());
+        REQUIRE(long_str.view() == long_value);
+
+        auto copy = long_str;
+        REQUIRE(copy.data() == long_str.data());  // Shares single block
+        REQUIRE(copy == long_str);
+
+        auto moved = std::move(copy);
+        REQUIRE(not copy.is_valid());
+        REQUIRE(moved.data() == long_str.data());
+
+        moved = "other";
+        REQUIRE(moved == "other");
+        REQUIRE(long_str.view() == long_value);
+
+        auto interned_a = shared_string::intern("hello");
+        auto interned_b = short_str.interned();
+        REQUIRE(interned_a.is_interned());
+        REQUIRE(interned_a.data() == interned_b.data());
+        REQUIRE(interned_a == short_str);
+        REQUIRE(interned_a != shared_string::intern("hellp"));
+        REQUIRE(interned_a.hash() == short_str.hash());
+        REQUIRE(std::hash<shared_string>{}(interned_a) == std::hash<std::string_view>{}("hello"));
+
+        std::unordered_set<shared_string> set{short_str, long_str, interned_a};
+        REQUIRE(set.size() == 2);
+    }
+
+    TEST_CASE("Shared string benchmark")
+    {
+        using cpph::shared_string;
+        using clk = std::chrono::steady_clock;
+
+        constexpr size_t num_keys = 256, num_iter = 20;
+        std::vector<std::string> std_keys;
+        std::vector<shared_string> keys, interned_keys;
+
+        for (size_t i = 0; i < num_keys; ++i) {
+            auto& key = std_keys.emplace_back("event.label." + std::to_string(i * 7919));
+            if (i & 1) { key.append(32, '_'); }
+
+            keys.emplace_back(key);
+            interned_keys.push_back(shared_string::intern(key));
+        }
+
+        auto measure = [&](auto&& keyset) {
+            size_t hits = 0;
+            auto copy = keyset;
+
+            auto t_0 = clk::now();
+            for (size_t i = 0; i < num_iter; ++i) { copy = keyset; }
+
+            auto t_1 = clk::now();
+            for (size_t i = 0; i < num_iter; ++i)
+                for (size_t k = 0; k < num_keys; ++k) { hits += copy[k] == keyset[(k + i) % num_keys]; }
+
+            auto t_2 = clk::now();
+            for (size_t i = 0; i < num_iter; ++i)
+                for (auto& key : copy) { hits += std::hash<std::decay_t<decltype(key)>>{}(key) & 1; }
+
+            auto t_3 = clk::now();
+            using sec = std::chrono::duration<double, std::micro>;
+
+            INFO("copy: " << sec(t_1 - t_0).count() << "us, "
+                          << "compare: " << sec(t_2 - t_1).count() << "us, "
+                          << "hash: " << sec(t_3 - t_2).count() << "us");
+            CHECK(hits >= num_keys);
+            return hits;
+        };
+
+        measure(std_keys);
+        measure(keys);
+        measure(interned_keys);
+    }
+
+    TEST_CASE("ndarray views and kernels")
+    {
+        cpph::ndarray<int, 3> arr{2, 3, 4};
+        std::iota(arr.begin(), arr.end(), 0);
+
+        SUBCASE("Strided view")
+        {
+            auto view = arr.view();
+            REQUIRE(view.is_contiguous());
+            REQUIRE(view(1, 2, 3) == arr(1, 2, 3));
+
+            auto sliced = arr.slice({0, 1, 0}, {2, 3, 4}, {1, 1, 2});
+            REQUIRE(sliced.dims() == std::array<size_t, 3>{2, 2, 2});
+            REQUIRE(not sliced.is_contiguous());
+            REQUIRE(sliced(1, 1, 1) == arr(1, 2, 2));
+
+            sliced.fill(-1);
+            REQUIRE(arr(0, 1, 0) == -1);
+            REQUIRE(arr(0, 1, 1) == 1 * 4 + 1);
+
+            auto copied = sliced.to_ndarray();
+            REQUIRE(copied.size() == 8);
+            REQUIRE(std::all_of(copied.begin(), copied.end(), [](int v) { return v == -1; }));
+        }
+
+        SUBCASE("Permute")
+        {
+            cpph::ndarray<int, 3> permuted;
+            cpph::nd::permute(permuted, arr, {2, 0, 1});
+            REQUIRE(permuted.dims() == std::array<size_t, 3>{4, 2, 3});
+
+            for (size_t i = 0; i < 2; ++i)
+                for (size_t j = 0; j < 3; ++j)
+                    for (size_t k = 0; k < 4; ++k)
+                        REQUIRE(permuted(k, i, j) == arr(i, j, k));
+
+            cpph::ndarray<int, 3> transposed;
+            cpph::nd::transpose(transposed, arr);
+            REQUIRE(transposed.dims() == std::array<size_t, 3>{2, 4, 3});
+            REQUIRE(transposed(1, 3, 2) == arr(1, 2, 3));
+            REQUIRE(transposed.view().transpose().to_ndarray() == arr);
+        }
+
+        SUBCASE("Element-wise arithmetic")
+        {
+            auto doubled = arr + arr;
+            REQUIRE(doubled(1, 2, 3) == 2 * arr(1, 2, 3));
+
+            doubled -= arr;
+            REQUIRE(doubled == arr);
+
+            doubled *= 3;
+            REQUIRE(doubled.sum() == 3 * arr.sum());
+            REQUIRE(arr.sum() == 23 * 24 / 2);
+            REQUIRE(arr.min() == 0);
+            REQUIRE(arr.max() == 23);
+
+            cpph::ndarray<int, 3> mismatch{2, 2, 2};
+            REQUIRE_THROWS_AS(doubled += mismatch, std::invalid_argument);
+        }
+
+        SUBCASE("Parallel execution")
+        {
+            cpph::thread_pool pool{3};
+            cpph::nd::exec_policy exec;
+            exec.pool = &pool;
+            exec.parallel_threshold = 1000;
+            exec.min_chunk_size = 100;
+
+            cpph::ndarray<double, 2> a{97, 131}, b{97, 131}, serial, parallel;
+            std::iota(a.begin(), a.end(), 0.5);
+            std::iota(b.begin(), b.end(), -300.);
+
+            cpph::nd::multiply(serial, a, b);
+            cpph::nd::multiply(parallel, a, b, exec);
+            REQUIRE(serial == parallel);
+            REQUIRE(cpph::nd::sum(parallel, exec) == cpph::nd::sum(parallel, exec));
+            REQUIRE(std::abs(cpph::nd::sum(a, exec) - a.sum()) < 1e-6 * a.sum());
+
+            cpph::nd::transpose(serial, a);
+            cpph::nd::transpose(parallel, a, exec);
+            REQUIRE(serial == parallel);
+            REQUIRE(parallel(130, 96) == a(96, 130));
+        }
+    }
+
+    TEST_CASE("ndarray transpose benchmark")
+    {
+        using clk = std::chrono::steady_clock;
+        using usec = std::chrono::duration<double, std::micro>;
+
+        cpph::ndarray<float, 2> src{512, 768}, naive{768, 512}, tiled;
+        std::iota(src.begin(), src.end(), 0.f);
+
+        auto t_0 = clk::now();
+        for (size_t i = 0; i < 512; ++i)
+            for (size_t j = 0; j < 768; ++j)
+                naive(j, i) = src(i, j);
+
+        auto t_1 = clk::now();
+        cpph::nd::transpose(tiled, src);
+        auto t_2 = clk::now();
+
+        INFO("naive: " << usec(t_1 - t_0).count() << "us, tiled: " << usec(t_2 - t_1).count() << "us");
+        REQUIRE(naive == tiled);
+    }
+
+    TEST_CASE("flat hash map")
+    {
+        cpph::flat_hash_map<int, int> map;
+        std::unordered_map<int, int> expected;
+        std::mt19937 rg{};
+
+        for (int i = 0; i < 50000; ++i) {
+            int key = rg() % 2000;
+
+            switch (rg() % 3) {
+                case 0:
+                    map[key] = i, expected[key] = i;
+                    break;
+
+                case 1:
+                    REQUIRE(map.erase(key) == expected.erase(key));
+                    break;
+
+                case 2: {
+                    auto it = map.find(key);
+                    auto it_expected = expected.find(key);
+                    REQUIRE((it == map.end()) == (it_expected == expected.end()));
+                    if (it != map.end()) { REQUIRE(it->second == it_expected->second); }
+                    break;
+                }
+            }
+        }
+
+        REQUIRE(map.size() == expected.size());
+        CHECK(map.load_factor() <= 0.875f);
+
+        size_t num_iterated = 0;
+        for (auto& [key, value] : map) { num_iterated += expected.at(key) == value; }
+        CHECK(num_iterated == expected.size());
+
+        auto copied = map;
+        auto moved = std::move(copied);
+        CHECK(moved.size() == map.size());
+        CHECK(copied.empty());
+
+        map.erase_if([](auto& kv) { return kv.first % 2 == 0; });
+        for (auto& [key, value] : map) { REQUIRE(key % 2 == 1); }
+        auto num_odd = moved.erase_if([](auto& kv) { return kv.first % 2 == 1; });
+        CHECK(map.size() == num_odd);
+        CHECK(moved.size() + num_odd == expected.size());
+
+        // Heterogeneous lookup
+        cpph::flat_hash_map<std::string, int> strmap{{"alpha", 1}, {"beta", 2}};
+        strmap.try_emplace(std::string_view{"gamma"}, 3);
+        CHECK(strmap.at("alpha") == 1);
+        CHECK(strmap.find(std::string_view{"beta"})->second == 2);
+        CHECK(strmap.contains("gamma"));
+        CHECK(strmap.erase(std::string_view{"alpha"}) == 1);
+        CHECK(not strmap.contains(std::string_view{"alpha"}));
+
+        cpph::flat_hash_set<std::string> set{"a", "b", "c"};
+        CHECK(not set.insert("a").second);
+        CHECK(set.contains(std::string_view{"b"}));
+        CHECK(set.size() == 3);
+    }
+
+    TEST_CASE("flat hash map benchmark")
+    {
+        using clk = std::chrono::steady_clock;
+        using usec = std::chrono::duration<double, std::micro>;
+
+        auto measure = [](auto map, auto const& keys, auto const& queries) {
+            auto t_0 = clk::now();
+            for (auto& key : keys) { map[key] = 1; }
+
+            auto t_1 = clk::now();
+            size_t hits = 0;
+            for (auto& key : queries) { hits += map.find(key) != map.end(); }
+
+            auto t_2 = clk::now();
+            return std::make_tuple(usec(t_1 - t_0).count(), usec(t_2 - t_1).count(), hits);
+        };
+
+        auto run = [&](auto const& keys, auto const& queries, char const* label) {
+            using key_type = typename std::decay_t<decltype(keys)>::value_type;
+
+            auto [t_ins_0, t_find_0, hits_0] = measure(cpph::flat_map<key_type, int>{}, keys, queries);
+            auto [t_ins_1, t_find_1, hits_1] = measure(std::unordered_map<key_type, int>{}, keys, queries);
+            auto [t_ins_2, t_find_2, hits_2] = measure(cpph::flat_hash_map<key_type, int>{}, keys, queries);
+
+            INFO(label << " x " << keys.size() << " (insert/find) "
+                       << "flat_map: " << t_ins_0 << "/" << t_find_0 << "us, "
+                       << "unordered_map: " << t_ins_1 << "/" << t_find_1 << "us, "
+                       << "flat_hash_map: " << t_ins_2 << "/" << t_find_2 << "us");
+            CHECK((hits_0 == hits_1 && hits_1 == hits_2));
+        };
+
+        std::mt19937 rg{};
+        for (size_t n : {16, 256, 4096}) {
+            std::vector<int> keys(n), queries(n * 4);
+            for (auto& k : keys) { k = int(rg()); }
+            for (size_t i = 0; i < queries.size(); ++i) { queries[i] = i & 1 ? keys[rg() % n] : int(rg()); }
+            run(keys, queries, "int");
+
+            std::vector<std::string> str_keys(n), str_queries(n * 4);
+            for (auto& k : str_keys) { k = "request.table.key." + std::to_string(rg()); }
+            for (size_t i = 0; i < str_queries.size(); ++i) {
+                str_queries[i] = i & 1 ? str_keys[rg() % n] : "request.table.key." + std::to_string(rg());
+            }
+            run(str_keys, str_queries, "string");
+        }
+    }
+
+    TEST_CASE("flat map bulk operations")
+    {
+        std::mt19937 rg{};
+        std::vector<std::pair<int, int>> input(5000);
+        for (size_t i = 0; i < input.size(); ++i) { input[i] = {int(rg() % 2000), int(i)}; }
+
+        // Reference: first occurrence of each key wins, as try_emplace() does.
+        std::map<int, int> ref;
+        for (auto& [k, v] : input) { ref.try_emplace(k, v); }
+
+        auto same_as_ref = [&](auto const& map) {
+            return std::equal(map.begin(), map.end(), ref.begin(), ref.end(),
+                              [](auto& a, auto& b) { return a.first == b.first && a.second == b.second; });
+        };
+
+        cpph::flat_map<int, int> map;
+        map.assign_unsorted(input.begin(), input.end());
+        CHECK(same_as_ref(map));
+
+        cpph::thread_pool pool{3};
+        cpph::flat_map<int, int> pmap;
+        pmap.assign_unsorted(input.begin(), input.end(), cpph::parallel_sorter{&pool, 0, 64});
+        CHECK(same_as_ref(pmap));
+
+        // Existing keys are kept
+        cpph::flat_map<int, int> split;
+        split.try_emplace(input[0].first, -1);
+        split.insert_range(input.begin(), input.begin() + 2500);
+        split.insert_range(input.begin() + 2500, input.end());
+        CHECK(split.at(input[0].first) == -1);
+        split[input[0].first] = input[0].second;
+        CHECK(same_as_ref(split));
+
+        // Merge: left wins
+        cpph::flat_map<int, int> odd, even;
+        for (int i = 0; i < 100; ++i) { (i & 1 ? odd : even).try_emplace(i, i); }
+        odd.try_emplace(0, -1);
+        odd.merge(std::move(even));
+        CHECK(even.empty());
+        CHECK(odd.size() == 100);
+        CHECK(odd.at(0) == -1);
+        CHECK(odd.at(98) == 98);
+        CHECK(std::is_sorted(odd.begin(), odd.end()));
+
+        CHECK(odd.erase_if([](auto& p) { return p.first % 3 == 0; }) == 34);
+        CHECK(odd.size() == 66);
+        CHECK(odd.find(3) == odd.end());
+        CHECK(odd.at(4) == 4);
+
+        cpph::flat_set<int> set;
+        std::vector<int> values{5, 3, 5, 1, 9, 3};
+        set.assign_unsorted(values.begin(), values.end());
+        CHECK(std::vector<int>(set.begin(), set.end()) == std::vector<int>{1, 3, 5, 9});
+        CHECK(set.find(5) != set.end());
+        CHECK(set.find(4) == set.end());
+
+        cpph::flat_set<int> other;
+        other.insert(4), other.insert(5);
+        set.merge(std::move(other));
+        CHECK(std::vector<int>(set.begin(), set.end()) == std::vector<int>{1, 3, 4, 5, 9});
+        CHECK(set.erase_if([](int v) { return v > 4; }) == 2);
+        CHECK(set.size() == 3);
+    }
+
+    TEST_CASE("flat map bulk build benchmark")
+    {
+        using clk = std::chrono::steady_clock;
+        using usec = std::chrono::duration<double, std::micro>;
+
+        std::mt19937 rg{};
+        std::vector<std::pair<int, int>> input(1 << 14);
+        for (auto& [k, v] : input) { k = int(rg()), v = k; }
+
+        auto t_0 = clk::now();
+        cpph::flat_map<int, int> one_by_one;
+        for (auto& [k, v] : input) { one_by_one.try_emplace(k, v); }
+
+        auto t_1 = clk::now();
+        cpph::flat_map<int, int> bulk;
+        bulk.assign_unsorted(input.begin(), input.end());
+
+        auto t_2 = clk::now();
+        cpph::thread_pool pool{3};
+        cpph::flat_map<int, int> parallel;
+        parallel.assign_unsorted(input.begin(), input.end(), cpph::parallel_sorter{&pool, 0, 1 << 12});
+
+        auto t_3 = clk::now();
+        INFO("flat_map build x " << input.size() << ": "
+                                 << "try_emplace " << usec(t_1 - t_0).count() << "us, "
+                                 << "assign_unsorted " << usec(t_2 - t_1).count() << "us, "
+                                 << "parallel " << usec(t_3 - t_2).count() << "us");
+        CHECK((std::equal(one_by_one.begin(), one_by_one.end(), bulk.begin(), bulk.end())
+               && std::equal(bulk.begin(), bulk.end(), parallel.begin(), parallel.end())));
+    }
+
+    TEST_CASE("bimap")
+    {
+        cpph::bimap<int, std::string> map{{1, "one"}, {2, "two"}, {3, "three"}};
+        CHECK(map.size() == 3);
+        CHECK(*map.find_right(2) == "two");
+        CHECK(*map.find_left("three") == 3);
+        CHECK(*map.find_left(std::string_view{"one"}) == 1);
+        CHECK(map.find_left("four") == nullptr);
+
+        CHECK(not map.insert({4, "one"}).second);  // Right value duplicates
+        CHECK(not map.emplace(1, "uno").second);   // Left value duplicates
+        CHECK(map.emplace(4, "four").second);
+        CHECK(map.erase_left(1) == 1);
+        CHECK(map.erase_right("one") == 0);
+        CHECK(map.size() == 3);
+        CHECK(*map.find_left("four") == 4);
+
+        std::vector<std::pair<int, std::string>> dup{{1, "a"}, {2, "a"}};
+        CHECK_THROWS_AS(map.assign(dup.begin(), dup.end()), std::logic_error);
+        CHECK(map.empty());
+
+        // Randomized against reference, which includes swap-remove erasure
+        std::mt19937 rg{};
+        cpph::bimap<int, int> table;
+        std::map<int, int> l2r, r2l;
+
+        for (int i = 0; i < 20000; ++i) {
+            int l = int(rg() % 3000), r = int(rg() % 3000);
+
+            if (rg() % 3 != 0) {
+                bool inserted = table.emplace(l, r).second;
+                bool expected = l2r.count(l) == 0 && r2l.count(r) == 0;
+                REQUIRE(inserted == expected);
+                if (expected) { l2r[l] = r, r2l[r] = l; }
+            } else if (rg() & 1) {
+                REQUIRE(table.erase_left(l) == l2r.count(l));
+                if (l2r.count(l)) { r2l.erase(l2r[l]), l2r.erase(l); }
+            } else {
+                REQUIRE(table.erase_right(r) == r2l.count(r));
+                if (r2l.count(r)) { l2r.erase(r2l[r]), r2l.erase(r); }
+            }
+        }
+
+        REQUIRE(table.size() == l2r.size());
+        for (auto& [l, r] : l2r) {
+            REQUIRE(table.find_right(l) != nullptr);
+            CHECK(*table.find_right(l) == r);
+            CHECK(*table.find_left(r) == l);
+        }
+    }
+
+    TEST_CASE("bimap benchmark")
+    {
+        using clk = std::chrono::steady_clock;
+        using nsec = std::chrono::duration<double, std::nano>;
+
+        std::mt19937 rg{};
+        size_t const n = 1 << 16;
+
+        std::vector<std::pair<uint32_t, std::string>> pairs;
+        for (uint32_t i = 0; i < n; ++i) { pairs.emplace_back(rg(), "label." + std::to_string(i)); }
+
+        std::vector<size_t> queries(n * 4);
+        for (auto& q : queries) { q = rg() % n; }
+
+        // Previous layout: vector of pairs, indexed by node-based tree per direction.
+        size_t map_bytes = 0;
+        using alloc_t = counting_allocator<int>;
+        std::vector<std::pair<uint32_t, std::string>> map_data;
+        std::map<uint32_t, size_t, std::less<>, counting_allocator<std::pair<uint32_t const, size_t>>> by_left{alloc_t{&map_bytes}};
+        std::map<std::string, size_t, std::less<>, counting_allocator<std::pair<std::string const, size_t>>> by_right{alloc_t{&map_bytes}};
+
+        auto t_0 = clk::now();
+        for (auto& [l, r] : pairs) {
+            if (by_left.count(l) || by_right.count(r)) { continue; }
+            by_left.emplace(l, map_data.size());
+            by_right.emplace(r, map_data.size());
+            map_data.emplace_back(l, r);
+        }
+
+        size_t bimap_bytes = 0;
+        cpph::bimap<uint32_t, std::string, cpph::hasher::fast_hash<uint32_t>, cpph::hasher::fast_hash<std::string>,
+                    std::equal_to<>, std::equal_to<>, counting_allocator<std::pair<uint32_t, std::string>>>
+                table{alloc_t{&bimap_bytes}};
+
+        auto t_1 = clk::now();
+        for (auto& [l, r] : pairs) { table.emplace(l, r); }
+
+        auto t_2 = clk::now();
+        size_t sum_0 = 0;
+        for (auto q : queries) {
+            sum_0 += map_data[by_right.find(pairs[q].second)->second].first;
+            sum_0 += map_data[by_left.find(pairs[q].first)->second].second.size();
+        }
+
+        auto t_3 = clk::now();
+        size_t sum_1 = 0;
+        for (auto q : queries) {
+            sum_1 += *table.find_left(pairs[q].second);
+            sum_1 += table.find_right(pairs[q].first)->size();
+        }
+
+        auto t_4 = clk::now();
+        map_bytes += map_data.capacity() * sizeof map_data[0];
+
+        auto per_lookup = [&](auto dt) { return nsec(dt).count() / (queries.size() * 2); };
+        INFO("bimap x " << table.size() << " (insert/lookup/memory) "
+                        << "vector+std::map: " << nsec(t_1 - t_0).count() / 1e3 << "us/"
+                        << per_lookup(t_3 - t_2) << "ns/" << map_bytes / 1024 << "KiB, "
+                        << "bimap: " << nsec(t_2 - t_1).count() / 1e3 << "us/"
+                        << per_lookup(t_4 - t_3) << "ns/" << bimap_bytes / 1024 << "KiB");
+        CHECK((sum_0 == sum_1 && table.size() == map_data.size()));
+    }
+
+    TEST_CASE("string arena")
+    {
+        cpph::string_arena arena{256};
+        std::vector<std::string_view> views;
+        std::vector<std::string> expected;
+
+        for (int i = 0; i < 1000; ++i) {
+            auto str = "entry-" + std::to_string(i % 300);
+            views.push_back(arena.intern(str));
+            expected.push_back(str);
+        }
+
+        // Views stay valid while arena grows, and duplicates share storage
+        CHECK(std::equal(views.begin(), views.end(), expected.begin(), expected.end()));
+        CHECK(arena.num_interned() == 300);
+        CHECK(arena.size() == 300);
+        CHECK(views[0].data() == views[300].data());
+        CHECK(views[0].data()[views[0].size()] == '\0');
+        CHECK(arena.find("entry-42")->data() == views[42].data());
+        CHECK(not arena.find("entry-300"));
+
+        // Interned empty string is distinguishable from missing one
+        CHECK(not arena.find(""));
+        arena.intern("");
+        REQUIRE(arena.find(""));
+        CHECK(arena.find("")->empty());
+
+        // Large strings are allocated separately
+        std::string large(1000, 'x');
+        auto large_view = arena.push_back(large, "-", "tail");
+        CHECK(large_view == large + "-tail");
+        CHECK(arena.intern("entry-1").data() == views[1].data());
+
+        auto usage = arena.memory_usage();
+        arena.clear();
+        CHECK(arena.empty());
+        CHECK(not arena.contains("entry-1"));
+        CHECK(arena.memory_usage() == usage - large.size() - 6);
+
+        // Pages are reused after clear
+        for (int i = 0; i < 300; ++i) { arena.intern("entry-" + std::to_string(i)); }
+        CHECK(arena.memory_usage() == usage - large.size() - 6);
+
+        arena.release();
+        CHECK(arena.memory_usage() == 0);
+    }
+
+    TEST_CASE("string arena benchmark")
+    {
+        using clk = std::chrono::steady_clock;
+        using usec = std::chrono::duration<double, std::micro>;
+
+        std::mt19937 rg{};
+        std::vector<std::string> tokens(200000);
+        for (auto& t : tokens) { t = "log.key." + std::to_string(rg() % 5000); }
+
+        auto t_0 = clk::now();
+        std::unordered_set<std::string> set;
+        size_t sum_0 = 0;
+        for (auto& t : tokens) { sum_0 += set.insert(t).first->size(); }
+
+        auto t_1 = clk::now();
+        cpph::string_arena arena;
+        size_t sum_1 = 0;
+        for (auto& t : tokens) { sum_1 += arena.intern(t).size(); }
+
+        auto t_2 = clk::now();
+        arena.clear();
+
+        auto t_3 = clk::now();
+        INFO("intern x " << tokens.size() << ": unordered_set<string> " << usec(t_1 - t_0).count()
+                         << "us, string_arena " << usec(t_2 - t_1).count() << "us (clear "
+                         << usec(t_3 - t_2).count() << "us)");
+        CHECK(sum_0 == sum_1);
+    }
+
+    template <typename T>
+    void verify_circular_queue_relocation(size_t expected_moves)
+    {
+        cpph::circular_queue<T> queue{16};
+
+        // Make elements wrap around the end of buffer
+        for (int i = 0; i < 10; ++i) { queue.emplace(i); }
+        for (int i = 0; i < 10; ++i) { queue.pop(); }
+        for (int i = 0; i < 12; ++i) { queue.emplace(i); }
+
+        move_counted::num_moves = 0;
+        queue.reserve_shrink(64);
+
+        CHECK(move_counted::num_moves == expected_moves);
+        REQUIRE(queue.size() == 12);
+        REQUIRE(queue.capacity() == 64);
+        for (int i = 0; i < 12; ++i) { CHECK(*queue.dequeue().value == i); }
+
+        for (int i = 0; i < 12; ++i) { queue.emplace(i); }
+        queue.reserve_shrink(4);
+        REQUIRE(queue.size() == 4);
+        for (int i = 0; i < 4; ++i) { CHECK(*queue.dequeue().value == i); }
+    }
+
+    TEST_CASE("trivially relocatable containers")
+    {
+        verify_circular_queue_relocation<move_counted>(12);
+        verify_circular_queue_relocation<relocatable_counted>(0);
+
+        {
+            // Bulk dequeue relocates onto destination, across wrapped boundary
+            cpph::circular_queue<relocatable_counted> queue{16};
+            for (int i = 0; i < 10; ++i) { queue.emplace(i), queue.pop(); }
+            for (int i = 0; i < 12; ++i) { queue.emplace(i); }
+
+            std::vector<relocatable_counted> out;
+            for (int i = 0; i < 8; ++i) { out.emplace_back(-1); }
+
+            move_counted::num_moves = 0;
+            auto end = queue.dequeue_n(8, out.data());
+
+            CHECK(move_counted::num_moves == 0);
+            CHECK(end == out.data() + 8);
+            REQUIRE(queue.size() == 4);
+            for (int i = 0; i < 8; ++i) { CHECK(*out[i].value == i); }
+            for (int i = 8; i < 12; ++i) { CHECK(*queue.dequeue().value == i); }
+        }
+
+        cpph::static_vector<std::string, 16> strs;
+        for (int i = 0; i < 8; ++i) { strs.emplace_back(std::to_string(i)); }
+
+        strs.erase(strs.begin() + 2, strs.begin() + 4);
+        strs.insert(strs.begin(), std::string(64, 'x'));
+        strs.emplace(strs.begin() + 3, "y");
+
+        std::vector<std::string> expected = {std::string(64, 'x'), "0", "1", "y", "4", "5", "6", "7"};
+        CHECK(strs == expected);
+
+        cpph::static_vector<std::unique_ptr<int>, 8> ptrs;
+        for (int i = 0; i < 6; ++i) { ptrs.emplace_back(std::make_unique<int>(i)); }
+
+        ptrs.erase(ptrs.begin());
+        ptrs.emplace(ptrs.begin() + 1, std::make_unique<int>(10));
+
+        REQUIRE(ptrs.size() == 6);
+        int expected_ptrs[] = {1, 10, 2, 3, 4, 5};
+        for (size_t i = 0; i < ptrs.size(); ++i) { CHECK(*ptrs[i] == expected_ptrs[i]); }
+
+        auto copied = strs;
+        CHECK(copied == strs);
+        strs.insert(strs.begin() + 1, expected.begin(), expected.end());
+        REQUIRE(strs.size() == strs.capacity());
+        CHECK(strs[1] == expected[0]);
+        CHECK(strs.back() == "7");
+        CHECK_THROWS(strs.emplace_back("overflow"));
+    }
+
+    TEST_CASE("trivially relocatable containers benchmark")
+    {
+        using clock = std::chrono::steady_clock;
+        constexpr size_t N = 1 << 18;
+
+        auto run = [&](auto tag) {
+            using value_type = decltype(tag);
+            cpph::circular_queue<value_type> queue{N};
+            for (size_t i = 0; i < N; ++i) { queue.emplace(int(i)); }
+
+            auto t0 = clock::now();
+            queue.reserve_shrink(N * 2);
+            auto elapsed = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+
+            return std::make_pair(elapsed, size_t(*queue.back().value));
+        };
+
+        auto [t_move, sink_move] = run(move_counted{0});
+        auto [t_relocate, sink_relocate] = run(relocatable_counted{0});
+
+        std::ostringstream report;
+        report << "reserve_shrink of " << N << " elements\n"
+               << "  move constructor: " << t_move << " ms\n"
+               << "  relocation:       " << t_relocate << " ms";
+
+        INFO(report.str());
+        CHECK(sink_move + sink_relocate == (N - 1) * 2);
+    }
+
+    TEST_CASE("circular queue bulk operations")
+    {
+        std::vector<int> src(100), dst(100);
+        std::iota(src.begin(), src.end(), 0);
+
+        cpph::circular_queue<int> queue{64};
+
+        // Wrap around the end of buffer
+        queue.enqueue_n(src.data(), 40);
+        queue.dequeue_n(40, dst.data());
+        queue.enqueue_n(src.data(), 50);
+
+        auto [r1, r2] = queue.readable_spans();
+        CHECK(r1.size() == 25);
+        CHECK(r2.size() == 25);
+        CHECK(r1[0] == 0);
+        CHECK(r2[0] == 25);
+
+        auto end = queue.dequeue_n(50, dst.begin());
+        CHECK(end == dst.begin() + 50);
+        CHECK(std::equal(src.begin(), src.begin() + 50, dst.begin()));
+        CHECK(queue.empty());
+
+        // Zero-copy production
+        auto [w1, w2] = queue.writable_spans();
+        CHECK(w1.size() + w2.size() == queue.capacity());
+
+        std::iota(w1.begin(), w1.end(), 0);
+        std::iota(w2.begin(), w2.end(), int(w1.size()));
+        queue.commit_write(w1.size() + w2.size());
+        REQUIRE(queue.is_full());
+
+        for (int i = 0; i < 64; ++i) { CHECK(queue.begin()[i] == i); }
+
+        queue.consume(60);
+        CHECK(queue.size() == 4);
+        CHECK(queue.front() == 60);
+
+        // Overflowing range drops oldest elements
+        queue.enqueue_n(src.data(), 62);
+        CHECK(queue.size() == 64);
+        CHECK(queue.front() == 62);
+        CHECK(queue.back() == 61);
+
+        // Non-trivial elements are constructed and destroyed properly
+        cpph::circular_queue<std::string> strs{8};
+        std::vector<std::string> words = {"a", "bb", std::string(40, 'c'), "dddd", "e", "f"};
+
+        strs.enqueue_n(words.begin(), words.size());
+        strs.consume(4);
+        strs.enqueue_n(words.begin(), words.size());
+
+        std::vector<std::string> out;
+        strs.dequeue_n(strs.size(), std::back_inserter(out));
+        CHECK(out == std::vector<std::string>{"e", "f", "a", "bb", std::string(40, 'c'), "dddd", "e", "f"});
+    }
+
+    TEST_CASE("circular queue mirrored mapping")
+    {
+        cpph::circular_queue<char> queue{5000, cpph::mirrored_mapping};
+
+        if (not queue.is_mirrored()) {
+            MESSAGE("mirrored mapping is not supported on this platform");
+            CHECK(queue.capacity() == 5000);
+            return;
+        }
+
+        REQUIRE(queue.capacity() + 1 == cpph::mirrored_mapping_size(5001));
+
+        std::string text(3000, 0);
+        for (size_t i = 0; i < text.size(); ++i) { text[i] = char('a' + i % 26); }
+
+        std::string out(text.size(), 0);
+        for (int iter = 0; iter < 16; ++iter) {
+            queue.enqueue_n(text.data(), text.size());
+
+            // Every readable region is single contiguous span
+            auto [r1, r2] = queue.readable_spans();
+            REQUIRE(r1.size() == text.size());
+            REQUIRE(r2.empty());
+            REQUIRE(std::equal(r1.begin(), r1.end(), text.begin()));
+
+            auto [w1, w2] = queue.writable_spans();
+            REQUIRE(w1.size() == queue.capacity() - text.size());
+            REQUIRE(w2.empty());
+
+            queue.dequeue_n(text.size(), out.data());
+            REQUIRE(out == text);
+        }
+
+        // Growth keeps mirrored storage
+        queue.enqueue_n(text.data(), text.size());
+        queue.reserve_shrink(queue.capacity() * 2);
+        CHECK(queue.is_mirrored());
+        CHECK(queue.size() == text.size());
+        CHECK(std::equal(queue.begin(), queue.end(), text.begin()));
+
+        auto moved = std::move(queue);
+        CHECK(moved.is_mirrored());
+        CHECK(not queue.is_mirrored());
+    }
+
+    TEST_CASE("circular queue bulk operations benchmark")
+    {
+        using clock = std::chrono::steady_clock;
+        constexpr size_t num_iter = 2000, chunk = 3000;
+
+        std::vector<char> src(chunk, 'x'), dst(chunk);
+        size_t sink = 0;
+
+        auto run = [&](auto& queue, auto&& fn) {
+            auto t0 = clock::now();
+            for (size_t i = 0; i < num_iter; ++i) { fn(queue), sink += dst[i % chunk]; }
+            return std::chrono::duration<double, std::micro>(clock::now() - t0).count() / num_iter;
+        };
+
+        auto per_element = [&](auto& queue) {
+            for (auto c : src) { queue.push(c); }
+            for (auto& c : dst) { c = queue.dequeue(); }
+        };
+
+        auto bulk = [&](auto& queue) {
+            queue.enqueue_n(src.data(), chunk);
+            queue.dequeue_n(chunk, dst.data());
+        };
+
+        cpph::circular_queue<char> regular{8191};
+        cpph::circular_queue<char> mirrored{8191, cpph::mirrored_mapping};
+
+        auto t_element = run(regular, per_element);
+        auto t_bulk = run(regular, bulk);
+        auto t_mirrored = run(mirrored, bulk);
+
+        std::ostringstream report;
+        report << chunk << " bytes round trip\n"
+               << "  per element: " << t_element << " us\n"
+               << "  bulk:        " << t_bulk << " us\n"
+               << "  mirrored:    " << t_mirrored << " us (" << (mirrored.is_mirrored() ? "mirrored" : "fallback") << ")";
+
+        INFO(report.str());
+        CHECK(sink == num_iter * 3 * 'x');
+    }
 }
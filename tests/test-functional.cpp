@@ -22,8 +22,10 @@
 //
 // project home: https://github.com/perfkitpp
 
+#include <array>
 #include <chrono>
 #include <memory>
+#include <string>
 
 #include <utility/functional.hxx>
 
@@ -137,4 +139,96 @@ TEST_SUITE("misc")
 
     template <size_t N>
     class la;
+
+    struct counting_alloc_state {
+        int num_allocs = 0;
+        int num_live = 0;
+    };
+
+    template <typename T>
+    struct counting_alloc {
+        using value_type = T;
+        counting_alloc_state* state = nullptr;
+
+        counting_alloc() noexcept = default;
+        explicit counting_alloc(counting_alloc_state* s) noexcept : state(s) {}
+
+        template <typename U>
+        counting_alloc(counting_alloc<U> const& o) noexcept : state(o.state) {}
+
+        T* allocate(size_t n)
+        {
+            ++state->num_allocs, ++state->num_live;
+            return std::allocator<T>{}.allocate(n);
+        }
+
+        void deallocate(T* p, size_t n)
+        {
+            --state->num_live;
+            std::allocator<T>{}.deallocate(p, n);
+        }
+    };
+
+    TEST_CASE("basic ufunction")
+    {
+        using small_fn = cpph::basic_ufunction<int(), 16, counting_alloc<char>>;
+        using large_fn = cpph::basic_ufunction<int(), 128, counting_alloc<char>>;
+
+        counting_alloc_state state;
+        counting_alloc<char> alloc{&state};
+
+        std::array<int, 16> payload = {};
+        payload[15] = 15;
+
+        auto ptr = std::make_shared<int>(3);
+        auto capturing = [ptr, payload, str = std::string(64, 'x')] {
+            return *ptr + payload[15] + int(str.size());
+        };
+
+        {
+            // Trivially copyable callable which doesn't fit inline storage
+            small_fn f{std::allocator_arg, alloc, [payload] { return payload[15]; }};
+            CHECK(not f.is_sbo());
+            CHECK(state.num_live == 1);
+
+            auto g = std::move(f);
+            CHECK(not f);
+            CHECK(g() == 15);
+            CHECK(state.num_allocs == 1);
+        }
+        CHECK(state.num_live == 0);
+
+        {
+            small_fn f{std::allocator_arg, alloc, capturing};
+            CHECK(not f.is_sbo());
+            CHECK(f() == 3 + 15 + 64);
+        }
+        CHECK(state.num_live == 0);
+
+        {
+            large_fn f{std::allocator_arg, alloc, capturing};
+            CHECK(f.is_sbo());
+            CHECK(ptr.use_count() == 3);
+
+            // Non-trivially copyable callable is relocated by its move constructor
+            large_fn g{std::move(f)};
+            CHECK(not f);
+            CHECK(ptr.use_count() == 3);
+            CHECK(g() == 3 + 15 + 64);
+
+            large_fn h{alloc};
+            h = std::move(g);
+            CHECK(h() == 3 + 15 + 64);
+
+            h = [] { return 1; };
+            CHECK(h.is_sbo());
+            CHECK(h() == 1);
+            CHECK(ptr.use_count() == 2);
+        }
+        CHECK(state.num_allocs == 2);
+        CHECK(state.num_live == 0);
+
+        CHECK(sizeof(cpph::ufunction<void()>) == sizeof(std::function<void()>) + 16);
+        CHECK(sizeof(large_fn) == 128 + sizeof(void*) * 2);
+    }
 }
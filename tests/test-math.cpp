@@ -22,10 +22,19 @@
 //
 // project home: https://github.com/perfkitpp
 
+#include <chrono>
+#include <random>
+#include <vector>
+
 #include "catch.hpp"
+#include "math/batch.hxx"
+#include "math/bvh.hxx"
+#include "math/camera.hxx"
+#include "math/frustum.hxx"
 #include "math/geometry.hxx"
 #include "math/matrix.hxx"
 #include "math/rectangle.hxx"
+#include "math/remap.hxx"
 
 using namespace cpph::math;
 
@@ -115,4 +124,540 @@ TEST_SUITE("math")
         static_assert(not(s1 & s2).contains({25, 75}));
         static_assert(not(s1 & s2).contains({55, 25}));
     }
+
+    TEST_CASE_TEMPLATE("matrix small size kernels", TestType, float, double)
+    {
+        using Ty = TestType;
+        using m44 = matrix<Ty, 4, 4>;
+        using m33 = matrix<Ty, 3, 3>;
+        using m22 = matrix<Ty, 2, 2>;
+        using v4 = matrix<Ty, 4, 1>;
+
+        // Kernels must stay available in constant evaluation
+        constexpr auto ce = m44::create(2, 0, 0, 1, 0, 3, 0, 2, 0, 0, 4, 3, 0, 0, 0, 1);
+        static_assert(ce * m44::eye() == ce);
+        static_assert(ce.t().t() == ce);
+        static_assert(ce.inv().has_value());
+
+        std::mt19937 rg{1234};
+        std::uniform_real_distribution<Ty> dist{-10, 10};
+        auto random = [&](auto matx) {
+            for (auto& v : matx.value) { v = dist(rg); }
+            return matx;
+        };
+
+        for (int iter = 0; iter < 32; ++iter) {
+            auto a = random(m44{}), b = random(m44{});
+            auto v = random(v4{});
+
+            m44 expected = {};
+            v4 expected_v = {};
+            for (int i = 0; i < 4; ++i) {
+                for (int j = 0; j < 4; ++j) {
+                    expected(i, j) = a.row(i).dot(b.col(j));
+                    REQUIRE(a.t()(i, j) == a(j, i));
+                }
+                expected_v(i) = a.row(i).dot(v);
+            }
+
+            REQUIRE((a * b).equals(expected, Ty(1e-3)));
+            REQUIRE((a * v).equals(expected_v, Ty(1e-3)));
+
+            REQUIRE((*a.inv() * a).equals(m44::eye(), Ty(1e-3)));
+
+            auto a3 = random(m33{});
+            REQUIRE((*a3.inv() * a3).equals(m33::eye(), Ty(1e-3)));
+
+            auto a2 = random(m22{});
+            REQUIRE((*a2.inv() * a2).equals(m22::eye(), Ty(1e-3)));
+        }
+
+        REQUIRE(not m44::zeros().inv());
+        REQUIRE(not m33::all(1).inv());
+    }
+
+    TEST_CASE("matrix multiply benchmark")
+    {
+        using clk = std::chrono::steady_clock;
+        using usec = std::chrono::duration<double, std::micro>;
+        constexpr int num_matx = 256, num_iter = 64;
+
+        auto previous_impl = [](auto const& a, auto const& b) {
+            std::decay_t<decltype(a)> result = {};
+            for (int i = 0; i < a.rows(); ++i)
+                for (int j = 0; j < b.cols(); ++j)
+                    result(i, j) = a.row(i).dot(b.col(j));
+
+            return result;
+        };
+
+        auto measure = [&](auto type_tag) {
+            using matx_type = decltype(type_tag);
+            std::vector<matx_type> lhs(num_matx), rhs(num_matx), out_0(num_matx), out_1(num_matx);
+
+            std::mt19937 rg{};
+            std::uniform_real_distribution<double> dist{-1, 1};
+            for (auto* arr : {&lhs, &rhs})
+                for (auto& matx : *arr)
+                    for (auto& v : matx.value) { v = dist(rg); }
+
+            auto run = [&](auto&& impl, auto* out) {
+                auto t_0 = clk::now();
+                for (int i = 0; i < num_iter; ++i)
+                    for (int k = 0; k < num_matx; ++k) { (*out)[k] = impl(lhs[k], rhs[(k + i) % num_matx]); }
+
+                return usec(clk::now() - t_0).count();
+            };
+
+            run(previous_impl, &out_0);  // warm up
+            auto t_prev = run(previous_impl, &out_0);
+            auto t_curr = run([](auto& a, auto& b) { return a * b; }, &out_1);
+
+            INFO(typeid(matx_type).name() << " previous: " << t_prev << "us, current: " << t_curr << "us");
+            bool all_equal = true;
+            for (int k = 0; k < num_matx; ++k) { all_equal = all_equal && out_0[k].equals(out_1[k], 1e-4); }
+            CHECK(all_equal);
+        };
+
+        measure(matx44f{});
+        measure(matx44d{});
+        measure(matx33f{});
+        measure(matx33d{});
+        measure(matx22f{});
+    }
+
+    TEST_CASE("point batch kernels")
+    {
+        constexpr size_t num_points = 3000;
+        std::mt19937 rg{};
+        std::uniform_real_distribution<double> dist{-1, 1};
+
+        std::vector<vec3d> points(num_points);
+        for (auto& pt : points) { pt = {dist(rg), dist(rg), 2 + dist(rg)}; }
+
+        cpph::thread_pool pool{3};
+        batch_policy exec{&pool, 1000, 256};
+
+        point_batch<double, 3> src{points}, dst;
+        REQUIRE(src.size() == num_points);
+        REQUIRE(src[17] == points[17]);
+
+        auto const rvec = vec3d{0.1, -0.2, 0.3};
+        auto const R = rodrigues(rvec);
+        auto const t = vec3d{1, 2, 3};
+
+        SUBCASE("affine")
+        {
+            rotate(dst, src, rvec, t, exec);
+
+            bool all_equal = true;
+            for (size_t i = 0; i < num_points; ++i) { all_equal = all_equal && dst[i].equals(R * points[i] + t, 1e-12); }
+            CHECK(all_equal);
+
+            // In-place, by [R|t]
+            matx34d Rt;
+            Rt.update(0, 0, R).update(0, 3, t);
+            transform(src, src, Rt);
+
+            for (size_t i = 0; i < num_points; ++i) { all_equal = all_equal && src[i].equals(dst[i], 1e-12); }
+            CHECK(all_equal);
+        }
+
+        SUBCASE("normalize and distance")
+        {
+            normalize(dst, src, exec);
+
+            plane<double> pl{{1, 1, 0}, 0.5};
+            std::vector<double> dists(num_points);
+            distance(cpph::array_view<double>{dists}, src, pl, exec);
+
+            bool all_equal = true;
+            for (size_t i = 0; i < num_points; ++i) {
+                all_equal = all_equal && dst[i].equals(normalize(points[i]), 1e-12);
+                all_equal = all_equal && std::abs(dists[i] - pl.calc_distance(points[i])) < 1e-12;
+            }
+            CHECK(all_equal);
+        }
+
+        SUBCASE("projection and distortion")
+        {
+            double const k[] = {0.1, -0.05, 0.01};
+            double const p[] = {1e-3, -2e-3};
+
+            point_batch<double, 2> normal, distorted, restored;
+            transform(src, src, R, t);
+            project(normal, src, exec);
+            distort_pixel(distorted, normal, k, p, exec);
+            auto num_failed = undistort_pixel(restored, distorted, k, p, {1e-9, 1e-9}, 20, exec);
+
+            size_t num_failed_expected = 0;
+            bool all_equal = true;
+            for (size_t i = 0; i < num_points; ++i) {
+                auto pt = R * points[i] + t;
+                auto uv = vec2d{pt.x() / pt.z(), pt.y() / pt.z()};
+                auto d = distort_pixel(uv, k, p);
+                auto u = undistort_pixel(d, k, p, {1e-9, 1e-9}, 20);
+
+                all_equal = all_equal && normal[i].equals(uv, 1e-12);
+                all_equal = all_equal && distorted[i].equals(d, 1e-12);
+
+                if (u) {
+                    all_equal = all_equal && restored[i].equals(*u, 1e-12);
+                } else {
+                    ++num_failed_expected;
+                    all_equal = all_equal && std::isnan(restored[i].x());
+                }
+            }
+
+            CHECK(all_equal);
+            CHECK(num_failed == num_failed_expected);
+        }
+    }
+
+    TEST_CASE("point batch benchmark")
+    {
+        using clk = std::chrono::steady_clock;
+        using usec = std::chrono::duration<double, std::micro>;
+        constexpr size_t num_points = 1 << 16;
+
+        std::mt19937 rg{};
+        std::uniform_real_distribution<float> dist{-1, 1};
+
+        std::vector<vec3f> points(num_points), out_aos(num_points);
+        for (auto& pt : points) { pt = {dist(rg), dist(rg), dist(rg)}; }
+
+        point_batch<float, 3> src{points}, dst(num_points);
+        auto const R = rodrigues(vec3f{0.1f, -0.2f, 0.3f});
+        auto const t = vec3f{1, 2, 3};
+
+        auto measure = [](auto&& fn) {
+            fn();  // warm up
+            auto t_0 = clk::now();
+            fn();
+            return usec(clk::now() - t_0).count();
+        };
+
+        auto t_aos = measure([&] { for (size_t i = 0; i < num_points; ++i) { out_aos[i] = R * points[i] + t; } });
+        auto t_soa = measure([&] { transform(dst, src, R, t); });
+
+        INFO("array of structs: " << t_aos << "us, point batch: " << t_soa << "us");
+        bool all_equal = true;
+        for (size_t i = 0; i < num_points; ++i) { all_equal = all_equal && dst[i].equals(out_aos[i], 1e-5f); }
+        CHECK(all_equal);
+    }
+
+    TEST_CASE("undistort remap table")
+    {
+        constexpr size_t width = 160, height = 120;
+
+        pinhole_lens<double, 3> lens;
+        lens.fx = lens.fy = 100, lens.cx = 80, lens.cy = 60;
+        lens.k[0] = 0.1, lens.k[1] = -0.05, lens.k[2] = 0.01;
+        lens.p[0] = 1e-3, lens.p[1] = -2e-3;
+
+        cpph::thread_pool pool{3};
+        batch_policy exec{&pool, 1000, 256};
+
+        remap_cache cache{2};
+        auto table = cache.get(lens, width, height, exec);
+        REQUIRE(table->size() == width * height);
+
+        auto source_of = [&](size_t u, size_t v) {
+            auto d = distort_pixel(vec2d{(u - lens.cx) / lens.fx, (v - lens.cy) / lens.fy}, lens.k, lens.p);
+            return vec2f(vec2d{d.x() * lens.fx + lens.cx, d.y() * lens.fy + lens.cy});
+        };
+
+        auto in_source = [&](vec2f pt) {
+            return pt.x() >= 0 && pt.y() >= 0 && pt.x() <= width - 1 && pt.y() <= height - 1;
+        };
+
+        SUBCASE("table")
+        {
+            bool all_equal = true;
+            for (size_t v = 0; v < height; ++v) {
+                for (size_t u = 0; u < width; ++u) {
+                    auto i = v * width + u;
+                    auto expected = source_of(u, v);
+
+                    // Skip pixels on the edge of source, which may fall on either side by rounding.
+                    if (std::abs(expected.x()) < 1e-3f || std::abs(expected.y()) < 1e-3f
+                        || std::abs(expected.x() - (width - 1)) < 1e-3f
+                        || std::abs(expected.y() - (height - 1)) < 1e-3f) {
+                        continue;
+                    }
+
+                    if (not in_source(expected)) {
+                        all_equal = all_equal && table->x0[i] == remap_table::invalid_tap;
+                        continue;
+                    }
+
+                    auto tap = vec2f{table->x0[i] + table->wx[i], table->y0[i] + table->wy[i]};
+                    all_equal = all_equal && tap.equals(expected, 1e-3f);
+                }
+            }
+            CHECK(all_equal);
+        }
+
+        SUBCASE("cache")
+        {
+            CHECK(cache.get(lens, width, height) == table);
+
+            auto other = lens;
+            other.k[0] = 0.2;
+            auto table_2 = cache.get(other, width, height);
+            CHECK(table_2 != table);
+            CHECK(cache.get(lens, width / 2, height / 2) != table);
+
+            // Least recently used one is evicted
+            CHECK(cache.size() == 2);
+            CHECK(cache.get(other, width, height) == table_2);
+            CHECK(cache.get(lens, width, height) != table);
+        }
+
+        SUBCASE("remap")
+        {
+            cpph::ndarray<uint8_t, 3> src(height, width, 3), dst;
+            for (size_t v = 0; v < height; ++v)
+                for (size_t u = 0; u < width; ++u)
+                    for (size_t c = 0; c < 3; ++c) { src(v, u, c) = uint8_t(u + v * 2 + c * 40); }
+
+            dst.reshape(src.dims());
+            remap(dst.view(), src.view(), *table, 7, exec);
+
+            bool all_equal = true;
+            size_t num_border = 0;
+            for (size_t v = 0; v < height; ++v) {
+                for (size_t u = 0; u < width; ++u) {
+                    auto i = v * width + u;
+                    if (table->x0[i] == remap_table::invalid_tap) {
+                        ++num_border;
+                        all_equal = all_equal && dst(v, u, 0) == 7 && dst(v, u, 2) == 7;
+                        continue;
+                    }
+
+                    auto pt = source_of(u, v);
+                    auto x0 = int(pt.x()), y0 = int(pt.y());
+                    auto x1 = std::min<int>(x0 + 1, width - 1), y1 = std::min<int>(y0 + 1, height - 1);
+                    float fx = pt.x() - x0, fy = pt.y() - y0;
+
+                    for (size_t c = 0; c < 3; ++c) {
+                        auto top = src(y0, x0, c) * (1 - fx) + src(y0, x1, c) * fx;
+                        auto bottom = src(y1, x0, c) * (1 - fx) + src(y1, x1, c) * fx;
+                        auto expected = top * (1 - fy) + bottom * fy;
+                        all_equal = all_equal && std::abs(dst(v, u, c) - expected) <= 1;
+                    }
+                }
+            }
+
+            CHECK(all_equal);
+            CHECK(num_border > 0);
+            CHECK(num_border < width * height / 2);
+
+            // Lens without distortion maps image onto itself
+            pinhole_lens<double, 3> ideal = lens;
+            std::fill(std::begin(ideal.k), std::end(ideal.k), 0), ideal.p[0] = ideal.p[1] = 0;
+
+            remap(dst.view(), src.view(), *cache.get(ideal, width, height), 0);
+            CHECK(std::equal(dst.begin(), dst.end(), src.begin()));
+        }
+    }
+
+    TEST_CASE("frustum culler")
+    {
+        std::mt19937 rg{};
+        std::uniform_real_distribution<double> dist{-2, 2};
+
+        plane<double> const frustum[] = {
+                {{1, 0, 0.2}, -1},
+                {{-1, 0, 0.2}, -1},
+                {{0, 1, 0.2}, -1},
+                {{0, -1, 0.2}, -1},
+        };
+
+        using seq_t = cpph::array<size_t, 2>;
+        std::vector<vec3d> dots;
+        std::vector<seq_t> seqs;
+
+        for (int i = 0; i < 200; ++i) {
+            auto begin = dots.size();
+            auto n = 2 + rg() % 12;
+            for (size_t k = 0; k < n; ++k) { dots.push_back({dist(rg), dist(rg), dist(rg)}); }
+            seqs.push_back({begin, dots.size()});
+        }
+
+        auto sorted = [](std::vector<vec3d> v) {
+            std::sort(v.begin(), v.end(), [](auto& a, auto& b) {
+                return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+            });
+            return v;
+        };
+
+        frustum_culler<double> culler;
+        std::vector<vec3d> out_dots;
+        std::vector<seq_t> out_seqs;
+
+        for (bool is_closed : {false, true}) {
+            // Run twice, to check reused buffers yield same result
+            for (int rep = 0; rep < 2; ++rep) {
+                culler.cull(frustum, dots, seqs, out_dots, out_seqs, is_closed);
+
+                std::vector<vec3d> expected_dots, actual_dots;
+                size_t num_expected_seqs = 0;
+
+                for (auto [begin, end] : seqs) {
+                    std::vector<vec3d> io_dots(dots.begin() + begin, dots.begin() + end);
+                    std::vector<seq_t> io_seqs;
+                    cull_frustum<double, 3>(frustum, io_dots, io_seqs, is_closed);
+
+                    num_expected_seqs += io_seqs.size();
+                    for (auto [b, e] : io_seqs) { expected_dots.insert(expected_dots.end(), io_dots.begin() + b, io_dots.begin() + e); }
+                }
+
+                for (auto [begin, end] : out_seqs) {
+                    actual_dots.insert(actual_dots.end(), out_dots.begin() + begin, out_dots.begin() + end);
+                }
+
+                CHECK(not out_seqs.empty());
+                CHECK(out_seqs.size() == num_expected_seqs);
+                REQUIRE(actual_dots.size() == expected_dots.size());
+
+                expected_dots = sorted(expected_dots), actual_dots = sorted(actual_dots);
+                bool all_equal = true, all_inside = true;
+                for (size_t i = 0; i < actual_dots.size(); ++i) {
+                    all_equal = all_equal && actual_dots[i].equals(expected_dots[i], 1e-9);
+                    for (auto& pl : frustum) { all_inside = all_inside && pl.calc_distance(actual_dots[i]) > -1e-9; }
+                }
+
+                CHECK(all_equal);
+                CHECK(all_inside);
+            }
+        }
+    }
+
+    TEST_CASE("bvh spatial index")
+    {
+        std::mt19937 rg{};
+        std::uniform_real_distribution<float> pos{0, 1000}, size{1, 30};
+
+        std::vector<aabb<float, 2>> boxes;
+        for (int i = 0; i < 5000; ++i) { boxes.push_back(rectanglef{pos(rg), pos(rg), size(rg), size(rg)}); }
+
+        cpph::thread_pool pool{3};
+        batch_policy exec{&pool, 1000, 256};
+
+        rect_bvh<float> tree{boxes, exec};
+        REQUIRE(tree.size() == boxes.size());
+        CHECK(rect_bvh<float>{boxes}.num_nodes() == tree.num_nodes());
+
+        auto brute_force = [&](auto&& pred) {
+            std::vector<uint32_t> r;
+            for (uint32_t i = 0; i < boxes.size(); ++i)
+                if (pred(boxes[i])) { r.push_back(i); }
+            return r;
+        };
+
+        auto collect = [&](auto const& query) {
+            std::vector<uint32_t> r;
+            tree.query(query, [&](uint32_t i) { r.push_back(i); });
+            std::sort(r.begin(), r.end());
+            return r;
+        };
+
+        SUBCASE("rectangle and point query")
+        {
+            for (int i = 0; i < 50; ++i) {
+                aabb<float, 2> q = rectanglef{pos(rg), pos(rg), size(rg) * 3, size(rg) * 3};
+                CHECK(collect(q) == brute_force([&](auto& b) { return b.intersects(q); }));
+
+                vec2f pt{pos(rg), pos(rg)};
+                CHECK(collect(pt) == brute_force([&](auto& b) { return b.contains(pt); }));
+            }
+        }
+
+        SUBCASE("batch query")
+        {
+            std::vector<vec2f> points(1000);
+            for (auto& pt : points) { pt = {pos(rg), pos(rg)}; }
+
+            std::vector<uint32_t> hits(points.size());
+            tree.hit_test(points, hits, exec);
+
+            bool all_equal = true;
+            for (size_t i = 0; i < points.size(); ++i) {
+                auto expected = brute_force([&](auto& b) { return b.contains(points[i]); });
+                all_equal = all_equal && hits[i] == (expected.empty() ? tree.npos : expected[0]);
+            }
+            CHECK(all_equal);
+
+            std::vector<aabb<float, 2>> queries(points.size());
+            for (size_t i = 0; i < points.size(); ++i) { queries[i] = {points[i], points[i] + vec2f{20, 20}}; }
+
+            std::vector<cpph::array<uint32_t, 2>> pairs;
+            tree.query(queries, pairs, exec);
+
+            std::vector<cpph::array<uint32_t, 2>> expected_pairs;
+            for (uint32_t i = 0; i < queries.size(); ++i)
+                for (auto idx : collect(queries[i])) { expected_pairs.push_back({i, idx}); }
+
+            std::sort(pairs.begin(), pairs.end());
+            CHECK(pairs == expected_pairs);
+        }
+
+        SUBCASE("raycast and nearest")
+        {
+            for (int i = 0; i < 50; ++i) {
+                vec2f P{pos(rg), pos(rg)}, D{size(rg) - 15, size(rg) - 15};
+
+                std::vector<uint32_t> hits;
+                tree.raycast(P, D, [&](uint32_t idx, float) { hits.push_back(idx); }, 10);
+                std::sort(hits.begin(), hits.end());
+
+                // Sample ray densely, which must hit subset of found items
+                bool covered = true;
+                for (float t = 0; t <= 10; t += 0.01f) {
+                    tree.query(P + t * D, [&](uint32_t idx) {
+                        covered = covered && std::binary_search(hits.begin(), hits.end(), idx);
+                    });
+                }
+                CHECK(covered);
+
+                vec2f pt{pos(rg), pos(rg)};
+                auto nearest = tree.nearest(pt);
+                auto min_dist = boxes[0].distance_sqr(pt);
+                for (auto& b : boxes) { min_dist = std::min(min_dist, b.distance_sqr(pt)); }
+                REQUIRE(nearest != tree.npos);
+                CHECK(boxes[nearest].distance_sqr(pt) == min_dist);
+
+                // Distance limit of other floating point type
+                CHECK(tree.nearest(pt, double(min_dist) * 0.5) == (min_dist == 0 ? nearest : tree.npos));
+            }
+        }
+
+        SUBCASE("refit")
+        {
+            for (auto& b : boxes) { b.min += vec2f{50, 0}, b.max += vec2f{50, 0}; }
+            tree.refit(boxes);
+
+            aabb<float, 2> q = rectanglef{100, 100, 300, 300};
+            CHECK(collect(q) == brute_force([&](auto& b) { return b.intersects(q); }));
+
+            boxes[17] = rectanglef{2000, 2000, 10, 10};
+            tree.refit(17, boxes[17]);
+            CHECK(collect(vec2f{2005, 2005}) == std::vector<uint32_t>{17});
+
+            // Incremental refit of moving items
+            for (int step = 0; step < 20; ++step) {
+                for (uint32_t i = step; i < boxes.size(); i += 7) {
+                    auto delta = vec2f{size(rg) - 15, size(rg) - 15};
+                    boxes[i].min += delta, boxes[i].max += delta;
+                    tree.refit(i, boxes[i]);
+                }
+            }
+
+            for (int i = 0; i < 20; ++i) {
+                aabb<float, 2> q2 = rectanglef{pos(rg), pos(rg), 100, 100};
+                CHECK(collect(q2) == brute_force([&](auto& b) { return b.intersects(q2); }));
+            }
+        }
+    }
 }
@@ -22,9 +22,26 @@
 //
 // project home: https://github.com/perfkitpp
 
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <future>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
 #include <vector>
 
+#include <container/circular_queue.hxx>
+#include <container/flat_map.hxx>
+#include <memory/alloc_tracker.hxx>
+#include <memory/concurrent_pool.hxx>
+#include <memory/page_allocator.hxx>
+#include <memory/pool.hxx>
+#include <memory/queue_allocator.hxx>
 #include <memory/ring_allocator.hxx>
+#include <memory/stack_allocator.hxx>
 
 #include "catch.hpp"
 
@@ -64,4 +81,624 @@ TEST_SUITE("memory")
 
         REQUIRE(buffer.empty());
     }
+
+    TEST_CASE("growable ring allocator")
+    {
+        cpph::growable_ring_allocator alloc{256, 64 << 10};
+        REQUIRE(alloc.capacity() == 256);
+        REQUIRE(alloc.empty());
+
+        std::deque<std::pair<int*, int>> live;
+        auto push = [&](int i) {
+            auto p = (int*)alloc.allocate(sizeof(int) * (i % 5 + 1));
+            *p = i;
+            live.emplace_back(p, i);
+        };
+        auto pop = [&] {
+            auto [p, v] = live.front();
+            REQUIRE(*p == v);
+            alloc.deallocate(p);
+            live.pop_front();
+        };
+
+        // Burst; must grow instead of failing
+        for (int i = 0; i < 1000; ++i) { push(i); }
+        REQUIRE(alloc.num_segments() > 1);
+        REQUIRE(alloc.stats().num_grows == alloc.num_segments() - 1);
+
+        auto peak = alloc.stats().peak_capacity;
+        REQUIRE(peak == alloc.capacity());
+
+        // Burst is over; steady FIFO traffic drains and retires older segments
+        while (live.size() > 10) { pop(); }
+        for (int i = 1000; i < 5000; ++i) { pop(), push(i); }
+        REQUIRE(alloc.num_segments() == 1);
+        REQUIRE(alloc.capacity() < peak);
+        REQUIRE(alloc.stats().peak_capacity == peak);
+        REQUIRE(alloc.stats().peak_num_segments > 1);
+
+        while (not live.empty()) { pop(); }
+        REQUIRE(alloc.empty());
+        REQUIRE(alloc.stats().bytes_in_use == 0);
+        REQUIRE(alloc.stats().peak_bytes_in_use > 1000 * sizeof(int));
+
+        alloc.shrink_to_fit();
+        REQUIRE(alloc.capacity() == 256);
+
+        alloc.reset_peak();
+        REQUIRE(alloc.stats().peak_capacity == 256);
+
+        // Never exceeds maximum capacity
+        while (auto p = alloc.allocate_nt(1000)) { live.emplace_back((int*)p, 0); }
+        REQUIRE(alloc.capacity() <= alloc.max_capacity());
+        REQUIRE_THROWS(alloc.allocate(1000));
+
+        for (auto [p, v] : live) { alloc.deallocate(p); }
+        REQUIRE(alloc.empty());
+    }
+
+    TEST_CASE("growable ring allocator benchmark")
+    {
+        using clock = std::chrono::steady_clock;
+        enum { N = 1 << 16, NUM_QUEUES = 100, MAX_CAPACITY = 1 << 20 };
+
+        // Typical depth is small, with occasional burst in one queue
+        size_t sink = 0;
+        auto run = [&](auto& alloc) {
+            std::deque<char*> q;
+            auto t0 = clock::now();
+
+            for (size_t i = 0; i < N; ++i) {
+                size_t depth = (i / 4096) % 4 == 3 ? 2048 : 16;
+                auto n = 32 + (i * 37) % 96;
+                auto p = (char*)alloc.allocate(n);
+                p[0] = char(i);
+                q.push_back(p);
+
+                while (q.size() > depth) {
+                    sink += uint8_t(q.front()[0]);
+                    alloc.deallocate(q.front());
+                    q.pop_front();
+                }
+            }
+
+            for (auto p : q) { sink += uint8_t(p[0]), alloc.deallocate(p); }
+            return std::chrono::duration<double, std::nano>(clock::now() - t0).count() / N;
+        };
+
+        cpph::ring_allocator fixed{MAX_CAPACITY};
+        auto t_fixed = run(fixed);
+
+        cpph::growable_ring_allocator growable{4 << 10, MAX_CAPACITY};
+        auto t_growable = run(growable);
+        growable.shrink_to_fit();
+
+        INFO("fixed ring: " << t_fixed << " ns/op, " << NUM_QUEUES * fixed.capacity() / 1024 << " KiB for " << int(NUM_QUEUES) << " queues");
+        INFO("growable ring: " << t_growable << " ns/op, " << NUM_QUEUES * growable.capacity() / 1024 << " KiB idle, "
+                               << growable.stats().peak_capacity / 1024 << " KiB peak per queue");
+        CHECK(sink != 0);
+    }
+
+
+    TEST_CASE("concurrent pool")
+    {
+        static std::atomic_int num_alive = 0;
+        struct counted {
+            int value;
+            explicit counted(int v) : value(v) { ++num_alive; }
+            ~counted() { --num_alive; }
+        };
+
+        std::promise<void> pool_destroyed;
+        std::thread holder;
+
+        {
+            cpph::concurrent_pool<counted, int> pool{42};
+
+            auto a = pool.checkout();
+            REQUIRE(a->value == 42);
+            a->value = 1;
+
+            auto addr = a.get();
+            a.checkin();
+            REQUIRE(not a);
+
+            // Objects are reused in LIFO order
+            auto b = pool.checkout();
+            REQUIRE(b.get() == addr);
+            REQUIRE(b->value == 1);
+
+            // Check out in one thread, return in another
+            std::vector<cpph::concurrent_pool_ptr<counted>> handles;
+            for (int i = 0; i < 1000; ++i) { handles.push_back(pool.checkout()); }
+            REQUIRE(num_alive == 1001);
+
+            std::thread{[&] { handles.clear(); }}.join();
+
+            auto shared = pool.checkout().share();
+            REQUIRE(shared->value == 42);
+            shared.reset();
+
+            // Objects held by other threads keep pool memory alive
+            holder = std::thread{[h = pool.checkout(), f = pool_destroyed.get_future()]() mutable {
+                auto p = std::move(h);
+                f.wait();
+            }};
+
+            pool.shrink();
+            REQUIRE(num_alive < 1001);
+        }
+
+        // Idle objects are destroyed with pool; held object, and its slab, outlive it until returned.
+        REQUIRE(num_alive == 1);
+        pool_destroyed.set_value();
+        holder.join();
+        REQUIRE(num_alive == 0);
+    }
+
+    TEST_CASE("concurrent pool destroyed while other thread caches its objects")
+    {
+        using array_type = std::vector<std::shared_ptr<int>>;
+
+        auto value = std::make_shared<int>(3);
+        std::weak_ptr<int> weak = value;
+
+        std::promise<void> cached, pool_destroyed, accessed;
+        std::thread worker;
+
+        {
+            cpph::concurrent_pool<array_type> pool;
+
+            worker = std::thread{[&] {
+                // Returned object stays in this thread's cache
+                pool.checkout()->push_back(std::move(value));
+                cached.set_value();
+
+                // Any access to other pool returns cached objects of destroyed one
+                pool_destroyed.get_future().wait();
+                cpph::concurrent_pool<array_type>{}.checkout();
+                accessed.set_value();
+            }};
+
+            cached.get_future().wait();
+            REQUIRE(not weak.expired());
+        }
+
+        pool_destroyed.set_value();
+        accessed.get_future().wait();
+        REQUIRE(weak.expired());
+
+        worker.join();
+    }
+
+    TEST_CASE("concurrent pool benchmark")
+    {
+        using clock = std::chrono::steady_clock;
+        enum { NUM_OPS = 1 << 14, NUM_HOLD = 4 };
+
+        std::atomic_size_t sink = 0;
+        auto run = [&](auto& pool, int num_threads) {
+            std::vector<std::thread> threads;
+            auto t0 = clock::now();
+
+            for (int t = 0; t < num_threads; ++t) {
+                threads.emplace_back([&] {
+                    size_t local = 0;
+                    std::decay_t<decltype(pool.checkout())> held[NUM_HOLD];
+
+                    for (size_t i = 0; i < size_t(NUM_OPS / num_threads); ++i) {
+                        auto& h = held[i % NUM_HOLD];
+                        h = pool.checkout();
+                        local += h->size();
+                    }
+
+                    sink += local + 1;
+                });
+            }
+
+            for (auto& th : threads) { th.join(); }
+            return std::chrono::duration<double, std::nano>(clock::now() - t0).count() / NUM_OPS;
+        };
+
+        std::ostringstream report;
+        for (int num_threads : {1, 2, 4, 8, 16, 32}) {
+            cpph::pool<std::vector<int>> locked;
+            cpph::concurrent_pool<std::vector<int>> cached;
+
+            auto t_locked = run(locked, num_threads);
+            auto t_cached = run(cached, num_threads);
+
+            report << "\n  " << num_threads << " threads: pool " << t_locked << " ns/op, concurrent_pool " << t_cached << " ns/op";
+        }
+
+        INFO(report.str());
+        CHECK(sink != 0);
+    }
+
+    TEST_CASE("page allocator")
+    {
+        using cpph::huge_page_mode;
+
+        for (auto mode : {huge_page_mode::none, huge_page_mode::transparent, huge_page_mode::hugetlb}) {
+            cpph::page_policy policy;
+            policy.huge_pages = mode;
+            policy.numa_node = cpph::current_numa_node();
+            policy.first_touch_threads = 4;
+
+            size_t const n = (8 << 20) + 123;
+            auto mem = (char*)cpph::allocate_pages(n, policy);
+            REQUIRE(uintptr_t(mem) % 4096 == 0);
+            REQUIRE(cpph::page_mapping_size(n, policy) >= n);
+            REQUIRE(mem[0] == 0);
+            REQUIRE(mem[n - 1] == 0);
+
+            memset(mem, 0xcd, n);
+            cpph::deallocate_pages(mem, n, policy);
+        }
+
+        // Ring buffer, and growable ring with page backed segments
+        cpph::ring_allocator ring{100 << 10, cpph::page_policy::this_node()};
+        REQUIRE(ring.capacity() >= 100 << 10);
+        ring.deallocate(memset(ring.allocate(50 << 10), 1, 50 << 10));
+        REQUIRE(ring.empty());
+
+        cpph::growable_ring_allocator growable{4 << 10, 1 << 20, cpph::page_policy{}};
+        std::vector<void*> ptrs;
+        for (int i = 0; i < 100; ++i) { ptrs.push_back(memset(growable.allocate(1000), i, 1000)); }
+        REQUIRE(growable.num_segments() > 1);
+        for (auto p : ptrs) { growable.deallocate(p); }
+        REQUIRE(growable.empty());
+
+        // STL containers
+        cpph::page_allocator<int> alloc{cpph::page_policy::this_node()};
+        std::vector<int, cpph::page_allocator<int>> vec{alloc};
+        for (int i = 0; i < 1 << 18; ++i) { vec.push_back(i); }
+        REQUIRE(vec[12345] == 12345);
+        REQUIRE(vec.get_allocator() == alloc);
+
+        cpph::circular_queue<double, cpph::page_allocator<double>> queue{1 << 16, cpph::page_allocator<double>{}};
+        for (int i = 0; i < 100000; ++i) {
+            if (queue.size() == queue.capacity()) { queue.pop(); }
+            queue.push(i);
+        }
+        REQUIRE(queue.back() == 99999);
+
+        queue.reserve_shrink(10);
+        REQUIRE(queue.size() == 10);
+        REQUIRE(queue.front() == 100000 - (1 << 16));
+    }
+
+    TEST_CASE("page allocator benchmark")
+    {
+        using clock = std::chrono::steady_clock;
+        enum : size_t { NBYTES = 64 << 20, NREAD = 1 << 20 };
+
+        size_t sink = 0;
+        std::ostringstream report;
+
+        for (auto mode : {cpph::huge_page_mode::none, cpph::huge_page_mode::transparent}) {
+            cpph::page_policy policy;
+            policy.huge_pages = mode;
+            policy.first_touch_threads = 1;
+
+            auto mem = (uint64_t*)cpph::allocate_pages(NBYTES, policy);
+            auto n = NBYTES / sizeof(uint64_t);
+
+            // Random walk, which is dominated by TLB misses on regular pages
+            std::mt19937_64 rng{1};
+            for (size_t i = 0; i < n; ++i) { mem[i] = rng() % n; }
+
+            auto t0 = clock::now();
+            uint64_t index = 0;
+            for (size_t i = 0; i < NREAD; ++i) { index = mem[index]; }
+            auto elapsed = std::chrono::duration<double, std::nano>(clock::now() - t0).count() / NREAD;
+
+            sink += index + 1;
+            report << "\n  " << (mode == cpph::huge_page_mode::none ? "4KiB pages: " : "transparent huge pages: ") << elapsed << " ns/read";
+            cpph::deallocate_pages(mem, NBYTES, policy);
+        }
+
+        INFO(report.str());
+        CHECK(sink != 0);
+    }
+
+    TEST_CASE("queue allocator")
+    {
+        cpph::queue_allocator<> alloc{256};
+        REQUIRE(alloc.section_size() == 256);
+
+        std::deque<std::pair<int*, int>> live;
+        for (int i = 0; i < 100; ++i) {
+            auto p = (int*)alloc.allocate(sizeof(int) * (i % 7 + 1));
+            REQUIRE(uintptr_t(p) % 16 == 0);
+            *p = i;
+            live.emplace_back(p, i);
+        }
+
+        REQUIRE(alloc.num_allocations() == 100);
+        auto num_sections = alloc.num_sections();
+        REQUIRE(num_sections > 1);
+
+        // Free in FIFO order; sections must be recycled instead of growing.
+        for (int i = 100; i < 1000; ++i) {
+            auto [p, v] = live.front();
+            REQUIRE(*p == v);
+            alloc.deallocate(p);
+            live.pop_front();
+
+            auto np = (int*)alloc.allocate(sizeof(int) * (i % 7 + 1));
+            *np = i;
+            live.emplace_back(np, i);
+        }
+
+        REQUIRE(alloc.num_sections() <= num_sections + 1);
+
+        // Large allocation takes dedicated section.
+        auto large = alloc.allocate(4096);
+        memset(large, 0xcd, 4096);
+
+        for (auto [p, v] : live) {
+            REQUIRE(*p == v);
+            alloc.deallocate(p);
+        }
+
+        live.clear();
+        alloc.deallocate(large);
+        REQUIRE(alloc.num_allocations() == 0);
+
+        // Only the section being filled survives.
+        alloc.shrink_to_fit();
+        REQUIRE(alloc.num_sections() == 1);
+
+        // Freed slots are reused after shrink, across repeated grow/shrink cycles.
+        for (int cycle = 0; cycle < 3; ++cycle) {
+            std::vector<void*> ptrs;
+            for (int i = 0; i < 20; ++i) { ptrs.push_back(alloc.allocate(5000)); }
+            REQUIRE(alloc.num_sections() >= 20);
+
+            for (auto p : ptrs) { alloc.deallocate(p); }
+            alloc.shrink_to_fit();
+            REQUIRE(alloc.num_sections() == 1);
+        }
+
+        static int num_alive = 0;
+        struct counted {
+            int value;
+            explicit counted(int v) : value(v) { ++num_alive; }
+            ~counted() { --num_alive; }
+        };
+
+        {
+            auto a = alloc.construct<counted>(1);
+            auto b = alloc.construct<counted>(2);
+            REQUIRE(a->value + b->value == 3);
+            REQUIRE(num_alive == 2);
+        }
+
+        REQUIRE(num_alive == 0);
+        REQUIRE(alloc.num_allocations() == 0);
+    }
+
+    TEST_CASE("queue allocator benchmark")
+    {
+        using clock = std::chrono::steady_clock;
+        enum { N = 1 << 16, DEPTH = 64 };
+
+        size_t sink = 0;
+        auto run = [&](auto&& alloc_fn, auto&& free_fn) {
+            std::deque<char*> q;
+            auto t0 = clock::now();
+
+            for (size_t i = 0; i < N; ++i) {
+                auto n = 16 + (i * 37) % 240;
+                auto p = (char*)alloc_fn(n);
+                p[0] = char(i), p[n - 1] = char(i);
+                q.push_back(p);
+
+                if (q.size() > DEPTH) {
+                    sink += uint8_t(q.front()[0]);
+                    free_fn(q.front());
+                    q.pop_front();
+                }
+            }
+
+            for (auto p : q) { sink += uint8_t(p[0]), free_fn(p); }
+            return std::chrono::duration<double, std::nano>(clock::now() - t0).count() / N;
+        };
+
+        auto t_malloc = run([](size_t n) { return malloc(n); }, [](void* p) { free(p); });
+
+        cpph::ring_allocator_with_fb ring{8 << 10};
+        auto t_ring = run([&](size_t n) { return ring.allocate(n); },
+                          [&](void* p) { ring.deallocate(p); });
+
+        cpph::queue_allocator<> queue{8 << 10};
+        auto t_queue = run([&](size_t n) { return queue.allocate(n); },
+                           [&](void* p) { queue.deallocate(p); });
+
+        INFO("malloc: " << t_malloc << " ns/op");
+        INFO("ring_allocator: " << t_ring << " ns/op");
+        INFO("queue_allocator: " << t_queue << " ns/op, " << queue.num_sections() << " sections");
+        CHECK(sink != 0);
+    }
+
+    TEST_CASE("stack allocator")
+    {
+        cpph::stack_allocator<256> alloc{1024};
+        REQUIRE(alloc.capacity() > 0);
+        REQUIRE(alloc.capacity() <= 256);
+
+        auto a = (char*)alloc.allocate(16);
+        auto b = (char*)alloc.allocate(1, 1);
+        auto c = (char*)alloc.allocate(8, 8);
+        REQUIRE(b == a + 16);
+        REQUIRE(uintptr_t(c) % 8 == 0);
+
+        // Most recent allocation is returned to stack
+        alloc.deallocate(c, 8, 8);
+        REQUIRE(alloc.allocate(8, 8) == c);
+
+        auto over_aligned = alloc.allocate(32, 64);
+        REQUIRE(uintptr_t(over_aligned) % 64 == 0);
+
+        auto mark = alloc.mark();
+        {
+            auto _ = alloc.scope();
+            for (int i = 0; i < 100; ++i) { memset(alloc.allocate(100), i, 100); }
+            REQUIRE(alloc.capacity() > 256);
+        }
+
+        // Rewound; blocks are retained and reused.
+        auto capacity = alloc.capacity();
+        REQUIRE(alloc.mark().head == mark.head);
+        {
+            auto _ = alloc.scope();
+            for (int i = 0; i < 100; ++i) { memset(alloc.allocate(100), i, 100); }
+            REQUIRE(alloc.capacity() == capacity);
+        }
+
+        // Allocation larger than block size gets its own block
+        memset(alloc.allocate(4096), 0, 4096);
+        REQUIRE(alloc.capacity() >= capacity + 4096);
+
+        alloc.release();
+        REQUIRE(alloc.capacity() <= 256);
+        REQUIRE(alloc.allocate(16) == a);
+
+        // Container adaptors
+        alloc.reset();
+        {
+            auto _ = alloc.scope();
+
+            std::vector<int, cpph::stack_stl_allocator<int>> vec{alloc.stl<int>()};
+            for (int i = 0; i < 1000; ++i) { vec.push_back(i); }
+            REQUIRE(vec[999] == 999);
+
+            using string_t = std::basic_string<char, std::char_traits<char>, cpph::stack_stl_allocator<char>>;
+            string_t str{alloc.stl<char>()};
+            str.assign(300, 'x');
+            REQUIRE(str.size() == 300);
+
+            using pair_t = std::pair<int, int>;
+            cpph::flat_map<int, int, std::less<int>, cpph::stack_stl_allocator<pair_t>> map{alloc.stl<pair_t>()};
+            for (int i = 0; i < 100; ++i) { map[(i * 37) % 100] = i; }
+            REQUIRE(map.size() == 100);
+            REQUIRE(map.get_allocator() == alloc.stl<char>());
+        }
+
+#if INTERNAL_CPPH_STACK_ALLOC_PMR
+        {
+            auto _ = alloc.scope();
+            std::pmr::vector<std::pmr::string> strs{&alloc};
+            for (int i = 0; i < 100; ++i) { strs.emplace_back(100, char('a' + i % 26)); }
+            REQUIRE(strs[27][0] == 'b');
+            REQUIRE(strs.get_allocator().resource() == &alloc);
+        }
+#endif
+    }
+
+    TEST_CASE("stack allocator benchmark")
+    {
+        using clock = std::chrono::steady_clock;
+        enum { N = 2000, M = 64 };
+
+        size_t sink = 0;
+        auto run = [&](auto&& make_alloc, auto&& scope) {
+            auto t0 = clock::now();
+            for (size_t i = 0; i < N; ++i) {
+                [[maybe_unused]] auto rewind = scope();
+                auto alloc = make_alloc();
+
+                using alloc_t = decltype(alloc);
+                using string_t = std::basic_string<char, std::char_traits<char>,
+                                                   typename std::allocator_traits<alloc_t>::template rebind_alloc<char>>;
+                using vec_t = std::vector<string_t, typename std::allocator_traits<alloc_t>::template rebind_alloc<string_t>>;
+
+                vec_t strs{alloc};
+                for (size_t k = 0; k < M; ++k) { strs.emplace_back(32 + (i + k) % 64, char(k), alloc); }
+                sink += strs[i % M].size();
+            }
+
+            return std::chrono::duration<double, std::micro>(clock::now() - t0).count() / N;
+        };
+
+        auto t_heap = run([] { return std::allocator<char>{}; }, [] { return 0; });
+
+        cpph::stack_allocator<16 << 10> scratch;
+        auto t_stack = run([&] { return scratch.stl<char>(); }, [&] { return scratch.scope(); });
+
+        INFO("std::allocator: " << t_heap << " us/request");
+        INFO("stack_allocator: " << t_stack << " us/request");
+        CHECK(sink != 0);
+    }
+
+    TEST_CASE("alloc tracker")
+    {
+        auto& registry = cpph::alloc_registry::get();
+        CHECK(registry.snapshot("test-tracker").empty());
+
+        {
+            cpph::alloc_tracker a{"test-tracker"};
+            cpph::alloc_tracker b{"test-tracker"};
+
+            a.on_allocate(8);
+            a.on_allocate(100);
+            a.on_allocate(1 << 20);
+            a.on_fallback();
+            a.on_deallocate(1 << 20);
+            b.on_allocate(64);
+
+            auto s = a.snapshot();
+            CHECK(s.name == "test-tracker");
+            CHECK(s.bytes_live == 108);
+            CHECK(s.peak_bytes_live == 108 + (1 << 20));
+            CHECK(s.num_live == 2);
+            CHECK(s.num_allocs == 3);
+            CHECK(s.num_fallbacks == 1);
+            CHECK(s.size_histogram[cpph::alloc_stats::histogram_bucket(8)] == 1);
+            CHECK(s.size_histogram[cpph::alloc_stats::histogram_bucket(100)] == 1);
+            CHECK(s.size_histogram.back() == 1);
+
+            CHECK(cpph::alloc_stats::histogram_bucket(0) == 0);
+            CHECK(cpph::alloc_stats::histogram_bucket(16) == 0);
+            CHECK(cpph::alloc_stats::histogram_bucket(17) == 1);
+            CHECK(cpph::alloc_stats::histogram_bucket(32) == 1);
+            CHECK(cpph::alloc_stats::histogram_bucket(~size_t{}) == cpph::alloc_stats::num_histogram_buckets - 1);
+
+            CHECK(registry.snapshot("test-tracker").size() == 2);
+
+            auto total = registry.total("test-tracker");
+            CHECK(total.bytes_live == 108 + 64);
+            CHECK(total.num_live == 3);
+            CHECK(total.num_allocs == 4);
+
+            // Relocated tracker keeps its counters registered
+            auto moved = std::move(b);
+            moved.on_deallocate(64);
+            CHECK(registry.total("test-tracker").bytes_live == 108);
+
+            a.rename("test-tracker-renamed");
+            CHECK(registry.snapshot("test-tracker").size() == 1);
+            CHECK(registry.snapshot("test-tracker-renamed").size() == 1);
+        }
+
+        CHECK(registry.snapshot("test-tracker").empty());
+        CHECK(registry.snapshot("test-tracker-renamed").empty());
+
+#if CPPH_ALLOC_TRACKING
+        {
+            cpph::ring_allocator alloc{1024};
+            alloc.tracker().rename("test-ring");
+
+            auto p = alloc.allocate(100);
+            auto s = registry.total("test-ring");
+            CHECK(s.num_live == 1);
+            CHECK(s.bytes_live >= 100);
+
+            alloc.deallocate(p);
+            CHECK(registry.total("test-ring").bytes_live == 0);
+            CHECK(registry.total("test-ring").num_allocs == 1);
+        }
+#endif
+    }
 }
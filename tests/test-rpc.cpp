@@ -184,6 +184,24 @@ TEST_SUITE("refl.rpc")
 #endif
     }
 
+    TEST_CASE("Rpc callbacks are stored inline")
+    {
+        auto owner = std::make_shared<int>(3);
+        std::string method = "method-name", payload = "payload";
+
+        rpc::request_complete_handler on_complete{
+                [owner, method, payload](rpc::error_code const&, std::string_view) {}};
+        rpc::event_message event{[owner, method, payload] {}};
+
+        auto sg = rpc::create_signature<int(int)>("sg");
+        decltype(sg)::serve_signature_full serve{
+                [owner, method](rpc::session_profile_view, int*, int&) {}};
+
+        CHECK(on_complete.is_sbo());
+        CHECK(event.is_sbo());
+        CHECK(serve.is_sbo());
+    }
+
     TEST_CASE("Inmemory Pipe Test")
     {
         auto [conn_a, conn_b] = rpc::conn::inmemory_pipe::create();
@@ -199,4 +217,49 @@ TEST_SUITE("refl.rpc")
             REQUIRE(strcmp(content, buf) == 0);
         }
     }
+
+    TEST_CASE("Inmemory Pipe Backlog")
+    {
+        // Both peers write far more than ring capacity before reading anything
+        auto [conn_a, conn_b] = rpc::conn::inmemory_pipe::create(64);
+        constexpr size_t total = 256 << 10;
+
+        auto pattern = [](size_t i, size_t seed) { return char(i * 13 + seed); };
+        std::string chunk;
+
+        for (size_t pos = 0, seed = 0; seed < 2; pos = 0, ++seed) {
+            auto conn = seed ? conn_b.get() : conn_a.get();
+
+            while (pos < total) {
+                chunk.clear();
+                for (size_t i = 0; i < 1000 && pos < total; ++i) { chunk.push_back(pattern(pos++, seed)); }
+
+                REQUIRE(conn->sputn(chunk.data(), chunk.size()) == std::streamsize(chunk.size()));
+                REQUIRE(conn->pubsync() == 0);
+            }
+        }
+
+        for (size_t seed = 0; seed < 2; ++seed) {
+            auto conn = seed ? conn_a.get() : conn_b.get();
+            size_t num_mismatch = 0;
+            char buf[333];
+
+            for (size_t pos = 0; pos < total;) {
+                auto n = std::min(sizeof buf, total - pos);
+                REQUIRE(conn->sgetn(buf, n) == std::streamsize(n));
+
+                for (size_t i = 0; i < n; ++i, ++pos) { num_mismatch += buf[i] != pattern(pos, seed); }
+            }
+
+            CHECK(num_mismatch == 0);
+            CHECK(conn->in_avail() == 0);
+        }
+
+        // Writer comes back to ring once backlog drained
+        conn_a->sputn("tail", 4), conn_a->pubsync();
+
+        char buf[4];
+        REQUIRE(conn_b->sgetn(buf, 4) == 4);
+        REQUIRE(std::string_view{buf, 4} == "tail");
+    }
 }
@@ -22,11 +22,22 @@
 //
 // project home: https://github.com/perfkitpp
 
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
+#include <random>
 #include <sstream>
+#include <thread>
 
 #include "catch.hpp"
+#include "refl/archive/msgpack-writer.hxx"
+#include "refl/core.hxx"
+#include "refl/types/list.hxx"
 #include "streambuf/base64.hxx"
+#include "container/circular_queue.hxx"
+#include "streambuf/chunked.hxx"
+#include "streambuf/circular.hxx"
 #include "streambuf/view.hxx"
 
 using namespace cpph;
@@ -50,4 +61,252 @@ TEST_SUITE("streambuf")
 
         REQUIRE(binbuf.str() == str);
     }
+
+    TEST_CASE("chunked output buffer")
+    {
+        streambuf::chunkbuf buf{16};
+
+        std::string expected = "0123456789" + std::string(40, 'x');
+
+        buf.sputn(expected.data(), 10);
+        buf.sputn(expected.data() + 10, 40);
+        REQUIRE(buf.size() == 50);
+        REQUIRE(buf.num_pages() == 4);
+
+        std::string joined;
+        for (auto chunk : buf.chunks()) {
+            REQUIRE(chunk.size() <= 16);
+            joined.append(chunk.data(), chunk.size());
+        }
+
+        REQUIRE(joined == expected);
+
+        std::string copied;
+        buf.copy_to(&copied);
+        REQUIRE(copied == expected);
+
+        SUBCASE("Pages are reused after clear")
+        {
+            std::vector<int> values(100);
+            for (int i = 0; i < 100; ++i) { values[i] = i * 1000; }
+
+            archive::msgpack::writer writer{&buf};
+            buf.clear(), writer << values;
+
+            auto size = buf.size();
+            auto num_pages = buf.num_pages();
+            REQUIRE(buf.empty() == false);
+
+            for (int i = 0; i < 10; ++i) {
+                buf.clear(), writer << values;
+                REQUIRE(buf.size() == size);
+            }
+
+            REQUIRE(buf.num_pages() == num_pages);
+
+            buf.clear(), buf.shrink_to_fit();
+            REQUIRE(buf.num_pages() == 0);
+            REQUIRE(buf.empty());
+        }
+    }
+
+    TEST_CASE("circular ring stream")
+    {
+        auto ring = std::make_shared<streambuf::circular_ring>(100);
+        REQUIRE(ring->capacity() == 128);
+
+        streambuf::circular writer{nullptr, ring, false};
+        streambuf::circular reader{ring, nullptr, false};
+
+        // Nothing is visible before publish
+        REQUIRE(writer.sputn("hello", 5) == 5);
+        REQUIRE(reader.in_avail() == 0);
+        REQUIRE(reader.sgetc() == EOF);
+
+        writer.pubsync();
+        REQUIRE(reader.in_avail() == 5);
+
+        char buf[256] = {};
+        REQUIRE(reader.sgetn(buf, 5) == 5);
+        REQUIRE(std::string_view{buf, 5} == "hello");
+
+        // Consumed bytes are returned to ring on next underflow
+        REQUIRE(reader.sgetc() == EOF);
+        REQUIRE(ring->size() == 0);
+
+        // Non-blocking writer stops at full ring, until reader releases space
+        std::string pattern(256, 0);
+        for (size_t i = 0; i < pattern.size(); ++i) { pattern[i] = char(i * 7); }
+
+        REQUIRE(writer.sputn(pattern.data(), 256) == 128);
+        writer.pubsync();
+        REQUIRE(ring->size() == 128);
+
+        REQUIRE(reader.sgetn(buf, 100) == 100);
+        REQUIRE(writer.sputn(pattern.data() + 128, 128) == 0);
+
+        REQUIRE(reader.sgetn(buf + 100, 28) == 28);
+        REQUIRE(std::string_view{buf, 128} == std::string_view{pattern}.substr(0, 128));
+        REQUIRE(reader.sgetc() == EOF);
+        REQUIRE(writer.sputn(pattern.data() + 128, 128) == 128);
+
+        // Closed ring is drained before eof
+        writer.close();
+        std::string rest;
+        for (int ch; (ch = reader.sbumpc()) != EOF;) { rest.push_back(char(ch)); }
+
+        REQUIRE(rest == pattern.substr(128));
+        REQUIRE(ring->total_read() == 5 + 256);
+        REQUIRE(writer.sputc('x') == EOF);
+        REQUIRE(reader.in_avail() == -1);
+    }
+
+    TEST_CASE("circular ring stream message boundary")
+    {
+        auto ring = std::make_shared<streambuf::circular_ring>(64);
+        streambuf::circular writer{nullptr, ring, false};
+        streambuf::circular reader{ring, nullptr, false};
+
+        std::string message(64, 'm');
+        char buf[64];
+
+        // Message fills ring exactly, and reader stops right at its end
+        REQUIRE(writer.sputn(message.data(), 64) == 64);
+        writer.pubsync();
+        REQUIRE(reader.sgetn(buf, 64) == 64);
+
+        REQUIRE(ring->size() == 0);
+        REQUIRE(reader.in_avail() == 0);
+        REQUIRE(writer.sputc('a') == 'a');
+
+        // Same, but consumed byte by byte; in_avail() returns the space
+        REQUIRE(writer.sputn(message.data(), 63) == 63);
+        writer.pubsync();
+        for (int i = 0; i < 64; ++i) { reader.sbumpc(); }
+
+        REQUIRE(reader.in_avail() == 0);
+        REQUIRE(ring->size() == 0);
+        REQUIRE(writer.sputn(message.data(), 64) == 64);
+    }
+
+    TEST_CASE("circular ring stream between threads")
+    {
+        for (size_t capacity : {64, 4096, 1 << 16}) {
+            auto ring = std::make_shared<streambuf::circular_ring>(capacity);
+            constexpr size_t total = 1 << 20;
+
+            std::thread producer{[ring, capacity] {
+                streambuf::circular writer{nullptr, ring};
+                std::mt19937 rand{uint32_t(capacity)};
+                char chunk[1000];
+
+                for (size_t pos = 0; pos < total;) {
+                    auto n = std::min<size_t>(total - pos, rand() % sizeof chunk + 1);
+                    for (size_t i = 0; i < n; ++i) { chunk[i] = char((pos + i) * 31 >> 3); }
+
+                    writer.sputn(chunk, n), pos += n;
+                    if (rand() % 4 == 0) { writer.pubsync(); }
+                }
+
+                writer.close();
+            }};
+
+            streambuf::circular reader{ring};
+            size_t pos = 0, num_mismatch = 0;
+            char buf[777];
+
+            for (std::streamsize n; (n = reader.sgetn(buf, sizeof buf)) > 0;) {
+                for (std::streamsize i = 0; i < n; ++i, ++pos) { num_mismatch += buf[i] != char(pos * 31 >> 3); }
+                if (n < std::streamsize(sizeof buf)) { break; }
+            }
+
+            producer.join();
+
+            CAPTURE(capacity);
+            CHECK(pos == total);
+            CHECK(num_mismatch == 0);
+            CHECK(ring->total_read() == total);
+        }
+    }
+
+    TEST_CASE("circular ring stream benchmark")
+    {
+        using clock = std::chrono::steady_clock;
+        constexpr int num_round_trips = 2000;
+        char const message[] = "0123456789abcdef0123456789abcdef";
+
+        // Ping-pong through pair of rings
+        auto ring_a = std::make_shared<streambuf::circular_ring>(1 << 16);
+        auto ring_b = std::make_shared<streambuf::circular_ring>(1 << 16);
+
+        auto t0 = clock::now();
+        {
+            std::thread peer{[&] {
+                streambuf::circular io{ring_a, ring_b};
+                char buf[sizeof message];
+
+                while (io.sgetn(buf, sizeof buf) == sizeof buf) { io.sputn(buf, sizeof buf), io.pubsync(); }
+                io.close();
+            }};
+
+            streambuf::circular io{ring_b, ring_a};
+            char buf[sizeof message];
+
+            for (int i = 0; i < num_round_trips; ++i) {
+                io.sputn(message, sizeof message), io.pubsync();
+                io.sgetn(buf, sizeof buf);
+            }
+
+            io.close();
+            peer.join();
+        }
+        auto t_ring = std::chrono::duration<double, std::micro>(clock::now() - t0).count() / num_round_trips;
+
+        // Same with mutex-protected queues, as inmemory_pipe did
+        struct locked_pipe {
+            std::mutex mtx;
+            std::condition_variable cv;
+            cpph::circular_queue<char> strm{1024};
+        } pipe_a, pipe_b;
+
+        auto send = [](locked_pipe& p, char const* data, size_t n) {
+            std::lock_guard _{p.mtx};
+            p.strm.enqueue_n(data, n);
+            p.cv.notify_one();
+        };
+
+        auto recv = [](locked_pipe& p, char* data, size_t n) {
+            std::unique_lock lock{p.mtx};
+            p.cv.wait(lock, [&] { return p.strm.size() >= n; });
+            p.strm.dequeue_n(n, data);
+        };
+
+        t0 = clock::now();
+        {
+            std::thread peer{[&] {
+                char buf[sizeof message];
+                for (int i = 0; i < num_round_trips; ++i) {
+                    recv(pipe_a, buf, sizeof buf);
+                    send(pipe_b, buf, sizeof buf);
+                }
+            }};
+
+            char buf[sizeof message];
+            for (int i = 0; i < num_round_trips; ++i) {
+                send(pipe_a, message, sizeof message);
+                recv(pipe_b, buf, sizeof buf);
+            }
+
+            peer.join();
+        }
+        auto t_mutex = std::chrono::duration<double, std::micro>(clock::now() - t0).count() / num_round_trips;
+
+        std::ostringstream report;
+        report << "round trip of " << sizeof message << " bytes\n"
+               << "  circular ring:        " << t_ring << " us\n"
+               << "  mutex + condvar queue: " << t_mutex << " us";
+
+        INFO(report.str());
+        CHECK(ring_a->total_written() == num_round_trips * sizeof message);
+    }
 }